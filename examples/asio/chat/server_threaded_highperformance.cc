@@ -1,9 +1,10 @@
 #include "examples/asio/chat/codec.h"
 
 #include "muduo/base/Logging.h"
-#include "muduo/base/Mutex.h"
 #include "muduo/base/ThreadLocalSingleton.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/LoopMessenger.h"
 #include "muduo/net/TcpServer.h"
 
 #include <set>
@@ -36,6 +37,11 @@ class ChatServer : noncopyable
   {
     server_.setThreadInitCallback(std::bind(&ChatServer::threadInit, this, _1));
     server_.start();
+    // no connection is accepted until the main loop runs, after start()
+    // returns, so no io loop sends a message before messenger_ is set.
+    messenger_.reset(new Messenger(server_.threadPool()->getAllLoops(),
+                                   kMessengerCapacity,
+                                   std::bind(&ChatServer::distributeMessage, this, _3)));
   }
 
  private:
@@ -55,52 +61,55 @@ class ChatServer : noncopyable
     }
   }
 
-  void onStringMessage(const TcpConnectionPtr&,
+  typedef LoopMessenger<BufferSlice> Messenger;
+  static const size_t kMessengerCapacity = 64 * 1024;
+
+  void onStringMessage(const TcpConnectionPtr& conn,
                        const string& message,
                        Timestamp)
   {
-    EventLoop::Functor f = std::bind(&ChatServer::distributeMessage, this, message);
+    // encodes once, sends to all connections by reference
+    Buffer buf;
+    buf.append(message);
+    buf.prependInt32(static_cast<int32_t>(message.size()));
+    BufferSlice msg(&buf);
+    size_t from = messenger_->indexOf(conn->getLoop());
     LOG_DEBUG;
-
-    MutexLockGuard lock(mutex_);
-    for (std::set<EventLoop*>::iterator it = loops_.begin();
-        it != loops_.end();
-        ++it)
+    for (size_t to = 0; to < messenger_->numLoops(); ++to)
     {
-      (*it)->queueInLoop(f);
+      if (!messenger_->send(from, to, msg))
+      {
+        LOG_WARN << "loop " << to << " is too busy, drop message";
+      }
     }
     LOG_DEBUG;
   }
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
 
-  void distributeMessage(const string& message)
+  void distributeMessage(const BufferSlice& message)
   {
     LOG_DEBUG << "begin";
     for (ConnectionList::iterator it = LocalConnections::instance().begin();
         it != LocalConnections::instance().end();
         ++it)
     {
-      codec_.send(get_pointer(*it), message);
+      (*it)->send(message);
     }
     LOG_DEBUG << "end";
   }
 
-  void threadInit(EventLoop* loop)
+  void threadInit(EventLoop*)
   {
     assert(LocalConnections::pointer() == NULL);
     LocalConnections::instance();
     assert(LocalConnections::pointer() != NULL);
-    MutexLockGuard lock(mutex_);
-    loops_.insert(loop);
   }
 
+  std::unique_ptr<Messenger> messenger_;  // outlives loop threads of server_
   TcpServer server_;
   LengthHeaderCodec codec_;
   typedef ThreadLocalSingleton<ConnectionList> LocalConnections;
-
-  MutexLock mutex_;
-  std::set<EventLoop*> loops_ GUARDED_BY(mutex_);
 };
 
 int main(int argc, char* argv[])
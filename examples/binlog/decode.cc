@@ -0,0 +1,56 @@
+#include "muduo/base/BinaryLogging.h"
+
+#include <stdio.h>
+
+using namespace muduo;
+
+// Renders files written by AsyncLogging::setRawBinaryOutput() to stdout.
+bool decodeFile(const char* filename, binlog::Decoder* decoder)
+{
+  FILE* fp = ::fopen(filename, "rb");
+  if (fp == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+  string data;
+  string text;
+  char buf[64*1024];
+  size_t nread = 0;
+  while ((nread = ::fread(buf, 1, sizeof buf, fp)) > 0)
+  {
+    data.append(buf, nread);
+    size_t n = decoder->decode(data.data(), data.size(), &text);
+    data.erase(0, n);
+    ::fwrite(text.data(), 1, text.size(), stdout);
+    text.clear();
+  }
+  ::fclose(fp);
+  if (!data.empty())
+  {
+    fprintf(stderr, "%s: %zd bytes of incomplete frame at end\n", filename, data.size());
+  }
+  return data.empty();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s binary_log_file...\n", argv[0]);
+    return 1;
+  }
+  bool ok = true;
+  for (int i = 1; i < argc; ++i)
+  {
+    // each file carries sites of its records
+    binlog::Decoder decoder;
+    ok = decodeFile(argv[i], &decoder) && ok;
+    if (decoder.badRecords() > 0)
+    {
+      fprintf(stderr, "%s: %ld bad records\n", argv[i], static_cast<long>(decoder.badRecords()));
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "muduo/base/FlightRecorder.h"
+
+#include <stdio.h>
+
+using namespace muduo;
+
+// Prints lines of all threads in a dump of FlightRecorder, ordered by time.
+bool decodeFile(const char* filename)
+{
+  FILE* fp = ::fopen(filename, "rb");
+  if (fp == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+  string data;
+  char buf[64*1024];
+  size_t nread = 0;
+  while ((nread = ::fread(buf, 1, sizeof buf, fp)) > 0)
+  {
+    data.append(buf, nread);
+  }
+  ::fclose(fp);
+
+  string text;
+  int lines = FlightRecorder::decode(data.data(), data.size(), &text);
+  if (lines < 0)
+  {
+    fprintf(stderr, "%s: not a dump of FlightRecorder\n", filename);
+    return false;
+  }
+  ::fwrite(text.data(), 1, text.size(), stdout);
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s flight_recorder_dump...\n", argv[0]);
+    return 1;
+  }
+  bool ok = true;
+  for (int i = 1; i < argc; ++i)
+  {
+    ok = decodeFile(argv[i]) && ok;
+  }
+  return ok ? 0 : 1;
+}
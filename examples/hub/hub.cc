@@ -42,7 +42,8 @@ class Topic : public muduo::copyable
   {
     content_ = content;
     lastPubTime_ = time;
-    string message = makeMessage();
+    // shared by all audiences, instead of copied to each output buffer
+    BufferSlice message(makeMessage());
     for (std::set<TcpConnectionPtr>::iterator it = audiences_.begin();
          it != audiences_.end();
          ++it)
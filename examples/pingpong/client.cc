@@ -82,7 +82,8 @@ class Client : noncopyable
          int blockSize,
          int sessionCount,
          int timeout,
-         int threadCount)
+         int threadCount,
+         int busyPollUsec)
     : loop_(loop),
       threadPool_(loop, "pingpong-client"),
       sessionCount_(sessionCount),
@@ -93,7 +94,7 @@ class Client : noncopyable
     {
       threadPool_.setThreadNum(threadCount);
     }
-    threadPool_.start();
+    threadPool_.start(std::bind(&EventLoop::setBusyPoll, _1, busyPollUsec));
 
     for (int i = 0; i < blockSize; ++i)
     {
@@ -187,10 +188,10 @@ void Session::onConnection(const TcpConnectionPtr& conn)
 
 int main(int argc, char* argv[])
 {
-  if (argc != 7)
+  if (argc != 7 && argc != 8)
   {
     fprintf(stderr, "Usage: client <host_ip> <port> <threads> <blocksize> ");
-    fprintf(stderr, "<sessions> <time>\n");
+    fprintf(stderr, "<sessions> <time> [busypoll_usec]\n");
   }
   else
   {
@@ -203,11 +204,13 @@ int main(int argc, char* argv[])
     int blockSize = atoi(argv[4]);
     int sessionCount = atoi(argv[5]);
     int timeout = atoi(argv[6]);
+    int busyPollUsec = argc > 7 ? atoi(argv[7]) : 0;
 
     EventLoop loop;
     InetAddress serverAddr(ip, port);
 
-    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount);
+    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount,
+                  busyPollUsec);
     loop.loop();
   }
 }
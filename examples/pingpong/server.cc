@@ -31,7 +31,7 @@ int main(int argc, char* argv[])
 {
   if (argc < 4)
   {
-    fprintf(stderr, "Usage: server <address> <port> <threads>\n");
+    fprintf(stderr, "Usage: server <address> <port> <threads> [busypoll_usec]\n");
   }
   else
   {
@@ -42,13 +42,16 @@ int main(int argc, char* argv[])
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
     InetAddress listenAddr(ip, port);
     int threadCount = atoi(argv[3]);
+    int busyPollUsec = argc > 4 ? atoi(argv[4]) : 0;
 
     EventLoop loop;
+    loop.setBusyPoll(busyPollUsec);
 
     TcpServer server(&loop, listenAddr, "PingPong");
 
     server.setConnectionCallback(onConnection);
     server.setMessageCallback(onMessage);
+    server.setThreadInitCallback(std::bind(&EventLoop::setBusyPoll, _1, busyPollUsec));
 
     if (threadCount > 1)
     {
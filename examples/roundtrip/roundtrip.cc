@@ -38,9 +38,10 @@ void serverMessageCallback(const TcpConnectionPtr& conn,
   }
 }
 
-void runServer(uint16_t port)
+void runServer(uint16_t port, int busyPollUsec)
 {
   EventLoop loop;
+  loop.setBusyPoll(busyPollUsec);
   TcpServer server(&loop, InetAddress(port), "ClockServer");
   server.setConnectionCallback(serverConnectionCallback);
   server.setMessageCallback(serverMessageCallback);
@@ -94,9 +95,10 @@ void sendMyTime()
   }
 }
 
-void runClient(const char* ip, uint16_t port)
+void runClient(const char* ip, uint16_t port, int busyPollUsec)
 {
   EventLoop loop;
+  loop.setBusyPoll(busyPollUsec);
   TcpClient client(&loop, InetAddress(ip, port), "ClockClient");
   client.enableRetry();
   client.setConnectionCallback(clientConnectionCallback);
@@ -111,18 +113,19 @@ int main(int argc, char* argv[])
   if (argc > 2)
   {
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
+    int busyPollUsec = argc > 3 ? atoi(argv[3]) : 0;
     if (strcmp(argv[1], "-s") == 0)
     {
-      runServer(port);
+      runServer(port, busyPollUsec);
     }
     else
     {
-      runClient(argv[1], port);
+      runClient(argv[1], port, busyPollUsec);
     }
   }
   else
   {
-    printf("Usage:\n%s -s port\n%s ip port\n", argv[0], argv[0]);
+    printf("Usage:\n%s -s port [busypoll_usec]\n%s ip port [busypoll_usec]\n", argv[0], argv[0]);
   }
 }
 
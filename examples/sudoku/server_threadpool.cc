@@ -33,6 +33,7 @@ class SudokuServer
   void start()
   {
     LOG_INFO << "starting " << numThreads_ << " threads.";
+    threadPool_.setMaxQueueSize(kMaxQueueSize);
     threadPool_.start(numThreads_);
     server_.start();
   }
@@ -96,7 +97,14 @@ class SudokuServer
 
     if (puzzle.size() == implicit_cast<size_t>(kCells))
     {
-      threadPool_.run(std::bind(&solve, conn, puzzle, id));
+      // never blocks the IO thread, reply is sent from the IO thread too.
+      if (!threadPool_.trySubmit(std::bind(&solveSudoku, puzzle),
+                                 conn->getLoop(),
+                                 std::bind(&SudokuServer::reply, conn, id, _1)))
+      {
+        LOG_WARN << conn->name() << " server busy";
+        reply(conn, id, "ServerBusy");
+      }
     }
     else
     {
@@ -105,12 +113,11 @@ class SudokuServer
     return goodRequest;
   }
 
-  static void solve(const TcpConnectionPtr& conn,
-                    const string& puzzle,
-                    const string& id)
+  static void reply(const TcpConnectionPtr& conn,
+                    const string& id,
+                    const string& result)
   {
     LOG_DEBUG << conn->name();
-    string result = solveSudoku(puzzle);
     if (id.empty())
     {
       conn->send(result+"\r\n");
@@ -121,6 +128,8 @@ class SudokuServer
     }
   }
 
+  static const int kMaxQueueSize = 10000;
+
   TcpServer server_;
   ThreadPool threadPool_;
   int numThreads_;
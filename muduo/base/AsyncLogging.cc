@@ -4,13 +4,110 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include "muduo/base/AsyncLogging.h"
+#include "muduo/base/BinaryLogging.h"
 #include "muduo/base/LogFile.h"
 #include "muduo/base/Timestamp.h"
 
+#include <algorithm>
+
 #include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 
+// Staging ring of one logging thread, written by that thread only,
+// read by the background thread only.
+class AsyncLogging::ThreadBuffer : noncopyable
+{
+ public:
+  ThreadBuffer(size_t size, bool binary)
+    : data_(new char[size]),
+      size_(size),
+      binary_(binary),
+      exited_(false),
+      sampleCount_(0),
+      head_(0),
+      tail_(0)
+  {
+  }
+
+  size_t size() const { return size_; }
+  // of binlog frames
+  bool binary() const { return binary_; }
+
+  size_t used() const
+  {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  // Called by the logging thread, returns false if no room for len bytes.
+  // Sets *halfFull if the ring becomes half full.
+  bool append(const char* logline, size_t len, bool* halfFull)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t used = tail - head_.load(std::memory_order_acquire);
+    if (size_ - used < len)
+    {
+      return false;
+    }
+    size_t offset = tail % size_;
+    size_t first = std::min(len, size_ - offset);
+    memcpy(data_.get() + offset, logline, first);
+    memcpy(data_.get(), logline + first, len - first);
+    tail_.store(tail + len, std::memory_order_release);
+    *halfFull = used < size_ / 2 && used + len >= size_ / 2;
+    return true;
+  }
+
+  // Called by the background thread, adds at most two pieces of
+  // complete lines to iov, returns number of bytes.
+  size_t peek(std::vector<struct iovec>* iov)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t len = tail_.load(std::memory_order_acquire) - head;
+    if (len > 0)
+    {
+      size_t offset = head % size_;
+      size_t first = std::min(len, size_ - offset);
+      iov->push_back(iovec{ data_.get() + offset, first });
+      if (len > first)
+      {
+        iov->push_back(iovec{ data_.get(), len - first });
+      }
+    }
+    return len;
+  }
+
+  // Called by the background thread, after writing what peek() returns.
+  void retrieve(size_t len)
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + len, std::memory_order_release);
+  }
+
+  // for kSample, called by the logging thread
+  bool sample(int rate)
+  {
+    return ++sampleCount_ % rate == 0;
+  }
+
+  std::atomic<bool>& exited() { return exited_; }
+
+ private:
+  static const size_t kCacheLineSize = 64;
+
+  const std::unique_ptr<char[]> data_;
+  const size_t size_;
+  const bool binary_;
+  std::atomic<bool> exited_;
+  int sampleCount_;
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> head_;  // written by background thread
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> tail_;  // written by logging thread
+  char pad2_[kCacheLineSize];
+};
+
 AsyncLogging::AsyncLogging(const string& basename,
                            off_t rollSize,
                            int flushInterval)
@@ -18,119 +115,292 @@ AsyncLogging::AsyncLogging(const string& basename,
     running_(false),
     basename_(basename),
     rollSize_(rollSize),
+    policy_(kDrop),
+    sampleRate_(10),
+    threadBufferSize_(1024*1024),
+    unbufferedOutput_(true),
+    mappedOutput_(false),
+    rawBinaryOutput_(false),
     thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
     latch_(1),
     mutex_(),
     cond_(mutex_),
-    currentBuffer_(new Buffer),
-    nextBuffer_(new Buffer),
-    buffers_()
+    wakeupPending_(false),
+    spaceCond_(mutex_),
+    blockedWriters_(0),
+    buffers_(),
+    droppedMessages_(0),
+    droppedBytes_(0),
+    reportedMessages_(0),
+    reportedBytes_(0)
 {
-  currentBuffer_->bzero();
-  nextBuffer_->bzero();
-  buffers_.reserve(16);
+  MCHECK(pthread_key_create(&key_, &AsyncLogging::threadExited));
+  MCHECK(pthread_key_create(&binaryKey_, &AsyncLogging::threadExited));
 }
 
-void AsyncLogging::append(const char* logline, int len)
+AsyncLogging::~AsyncLogging()
 {
-  muduo::MutexLockGuard lock(mutex_);
-  if (currentBuffer_->avail() > len)
+  if (running_)
   {
-    currentBuffer_->append(logline, len);
+    stop();
   }
-  else
+  MCHECK(pthread_key_delete(key_));
+  MCHECK(pthread_key_delete(binaryKey_));
+  for (ThreadBuffer* buffer : buffers_)
+  {
+    delete buffer;
+  }
+}
+
+void AsyncLogging::threadExited(void* buffer)
+{
+  static_cast<ThreadBuffer*>(buffer)->exited().store(true, std::memory_order_release);
+}
+
+bool AsyncLogging::freeExited(ThreadBuffer* buffer)
+{
+  // no more lines after exited, the last ones are written in next round
+  if (buffer->exited().load(std::memory_order_acquire) && buffer->used() == 0)
   {
-    buffers_.push_back(std::move(currentBuffer_));
+    delete buffer;
+    return true;
+  }
+  return false;
+}
 
-    if (nextBuffer_)
+AsyncLogging::ThreadBuffer* AsyncLogging::threadBuffer(pthread_key_t key, bool binary)
+{
+  ThreadBuffer* buffer = static_cast<ThreadBuffer*>(pthread_getspecific(key));
+  if (buffer == NULL)
+  {
+    buffer = new ThreadBuffer(threadBufferSize_, binary);
     {
-      currentBuffer_ = std::move(nextBuffer_);
+    MutexLockGuard lock(mutex_);
+    buffers_.push_back(buffer);
     }
-    else
+    MCHECK(pthread_setspecific(key, buffer));
+  }
+  return buffer;
+}
+
+void AsyncLogging::append(const char* logline, int len)
+{
+  appendTo(threadBuffer(key_, false), logline, len);
+}
+
+void AsyncLogging::appendBinary(const char* record, int len)
+{
+  appendTo(threadBuffer(binaryKey_, true), record, len);
+}
+
+void AsyncLogging::appendTo(ThreadBuffer* buffer, const char* logline, int len)
+{
+  size_t n = static_cast<size_t>(len);
+  bool halfFull = false;
+  if (policy_ == kSample && buffer->used() >= buffer->size() / 2
+      && !buffer->sample(sampleRate_))
+  {
+    drop(n);
+  }
+  else if (buffer->append(logline, n, &halfFull))
+  {
+    if (halfFull)
     {
-      currentBuffer_.reset(new Buffer); // Rarely happens
+      wakeup();
     }
-    currentBuffer_->append(logline, len);
+  }
+  else if (!appendFull(buffer, logline, n))
+  {
+    drop(n);
+  }
+}
+
+bool AsyncLogging::appendFull(ThreadBuffer* buffer, const char* logline, size_t len)
+{
+  if (policy_ != kBlock || len > buffer->size())
+  {
+    return false;
+  }
+  bool halfFull = false;
+  MutexLockGuard lock(mutex_);
+  ++blockedWriters_;
+  // background thread may be not running yet, or stopped, then drops
+  bool appended = false;
+  while (running_ && !(appended = buffer->append(logline, len, &halfFull)))
+  {
+    wakeupPending_ = true;
     cond_.notify();
+    // frees the ring and signals while holding mutex_, no lost wakeup,
+    // but may be stopped meanwhile
+    spaceCond_.waitForSeconds(flushInterval_);
+  }
+  --blockedWriters_;
+  return appended;
+}
+
+void AsyncLogging::drop(size_t len)
+{
+  droppedMessages_.fetch_add(1, std::memory_order_relaxed);
+  droppedBytes_.fetch_add(static_cast<int64_t>(len), std::memory_order_relaxed);
+}
+
+void AsyncLogging::wakeup()
+{
+  MutexLockGuard lock(mutex_);
+  wakeupPending_ = true;
+  cond_.notify();
+}
+
+void AsyncLogging::reportDropped(LogFile* output)
+{
+  int64_t messages = droppedMessages_;
+  int64_t bytes = droppedBytes_;
+  if (messages > reportedMessages_)
+  {
+    char buf[256];
+    snprintf(buf, sizeof buf, "Dropped log messages at %s, %ld messages, %ld bytes\n",
+             Timestamp::now().toFormattedString().c_str(),
+             static_cast<long>(messages - reportedMessages_),
+             static_cast<long>(bytes - reportedBytes_));
+    fputs(buf, stderr);
+    output->append(buf, static_cast<int>(strlen(buf)));
+    reportedMessages_ = messages;
+    reportedBytes_ = bytes;
+  }
+}
+
+// Every round starts with sites of its records, so that each file
+// decodes on its own, after rolling.
+void AsyncLogging::writeRawBinary(const string& records, string* sites, LogFile* output)
+{
+  if (records.empty())
+  {
+    return;
+  }
+  std::vector<bool> seen;
+  size_t pos = 0;
+  size_t n = 0;
+  while ((n = binlog::frameLength(records.data() + pos, records.size() - pos)) > 0)
+  {
+    binlog::RecordHeader header;
+    if (n >= sizeof header)
+    {
+      memcpy(&header, records.data() + pos, sizeof header);
+      const LogSite* site = LogSite::find(header.site);
+      if (site && (static_cast<size_t>(header.site) >= seen.size() || !seen[header.site]))
+      {
+        if (static_cast<size_t>(header.site) >= seen.size())
+        {
+          seen.resize(header.site + 1);
+        }
+        seen[header.site] = true;
+        binlog::appendSite(*site, sites);
+      }
+    }
+    pos += n;
   }
+  struct iovec iov[2] = {
+    { const_cast<char*>(sites->data()), sites->size() },
+    { const_cast<char*>(records.data()), records.size() },
+  };
+  output->appendv(iov, 2);
 }
 
 void AsyncLogging::threadFunc()
 {
   assert(running_ == true);
   latch_.countDown();
-  LogFile output(basename_, rollSize_, false);
-  BufferPtr newBuffer1(new Buffer);
-  BufferPtr newBuffer2(new Buffer);
-  newBuffer1->bzero();
-  newBuffer2->bzero();
-  BufferVector buffersToWrite;
-  buffersToWrite.reserve(16);
-  while (running_)
-  {
-    assert(newBuffer1 && newBuffer1->length() == 0);
-    assert(newBuffer2 && newBuffer2->length() == 0);
-    assert(buffersToWrite.empty());
-
+  LogFile output(basename_, rollSize_, false, flushInterval_, 1024,
+                 unbufferedOutput_, mappedOutput_);
+  output.setRollCallback(rollCallback_);
+  ThreadBufferList buffersToWrite;
+  std::vector<size_t> lengths;
+  std::vector<struct iovec> iov;
+  std::unique_ptr<LogFile> binaryOutput;
+  if (rawBinaryOutput_)
+  {
+    binaryOutput.reset(new LogFile(basename_ + ".bin", rollSize_, false,
+                                   flushInterval_, 1024,
+                                   unbufferedOutput_, mappedOutput_));
+    binaryOutput->setRollCallback(rollCallback_);
+  }
+  binlog::Decoder decoder;
+  decoder.setUseRegistry(true);
+  std::vector<struct iovec> binaryIov;
+  string binary;  // records of all threads
+  string text;    // rendered from binary, or sites of binary
+  bool draining = true;
+  while (draining)
+  {
+    // one more round after stop(), for lines appended before it
+    draining = running_;
     {
       muduo::MutexLockGuard lock(mutex_);
-      if (buffers_.empty())  // unusual usage!
+      if (!wakeupPending_ && draining)
       {
         cond_.waitForSeconds(flushInterval_);
       }
-      buffers_.push_back(std::move(currentBuffer_));
-      currentBuffer_ = std::move(newBuffer1);
-      buffersToWrite.swap(buffers_);
-      if (!nextBuffer_)
+      wakeupPending_ = false;
+      buffersToWrite = buffers_;
+    }
+
+    bool anyExited = false;
+    lengths.clear();
+    iov.clear();
+    binary.clear();
+    text.clear();
+    for (ThreadBuffer* buffer : buffersToWrite)
+    {
+      anyExited |= buffer->exited().load(std::memory_order_acquire);
+      if (buffer->binary())
       {
-        nextBuffer_ = std::move(newBuffer2);
+        // linearized, frames may wrap around
+        binaryIov.clear();
+        lengths.push_back(buffer->peek(&binaryIov));
+        for (const struct iovec& piece : binaryIov)
+        {
+          binary.append(static_cast<const char*>(piece.iov_base), piece.iov_len);
+        }
+      }
+      else
+      {
+        lengths.push_back(buffer->peek(&iov));
       }
     }
-
-    assert(!buffersToWrite.empty());
-
-    if (buffersToWrite.size() > 25)
+    if (binaryOutput)
     {
-      char buf[256];
-      snprintf(buf, sizeof buf, "Dropped log messages at %s, %zd larger buffers\n",
-               Timestamp::now().toFormattedString().c_str(),
-               buffersToWrite.size()-2);
-      fputs(buf, stderr);
-      output.append(buf, static_cast<int>(strlen(buf)));
-      buffersToWrite.erase(buffersToWrite.begin()+2, buffersToWrite.end());
+      writeRawBinary(binary, &text, binaryOutput.get());
     }
-
-    for (const auto& buffer : buffersToWrite)
+    else if (!binary.empty())
     {
-      // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-      output.append(buffer->data(), buffer->length());
+      decoder.decode(binary.data(), binary.size(), &text);
+      iov.push_back(iovec{ const_cast<char*>(text.data()), text.size() });
     }
-
-    if (buffersToWrite.size() > 2)
+    // all threads with one writev(2), if unbuffered
+    output.appendv(iov.data(), static_cast<int>(iov.size()));
+    for (size_t i = 0; i < buffersToWrite.size(); ++i)
     {
-      // drop non-bzero-ed buffers, avoid trashing
-      buffersToWrite.resize(2);
+      buffersToWrite[i]->retrieve(lengths[i]);
     }
-
-    if (!newBuffer1)
     {
-      assert(!buffersToWrite.empty());
-      newBuffer1 = std::move(buffersToWrite.back());
-      buffersToWrite.pop_back();
-      newBuffer1->reset();
+      muduo::MutexLockGuard lock(mutex_);
+      if (blockedWriters_ > 0)
+      {
+        spaceCond_.notifyAll();
+      }
+    }
+    reportDropped(&output);
+    output.flush();
+    if (binaryOutput)
+    {
+      binaryOutput->flush();
     }
 
-    if (!newBuffer2)
+    if (anyExited)
     {
-      assert(!buffersToWrite.empty());
-      newBuffer2 = std::move(buffersToWrite.back());
-      buffersToWrite.pop_back();
-      newBuffer2->reset();
+      muduo::MutexLockGuard lock(mutex_);
+      auto last = std::remove_if(buffers_.begin(), buffers_.end(), freeExited);
+      buffers_.erase(last, buffers_.end());
     }
-
-    buffersToWrite.clear();
-    output.flush();
   }
-  output.flush();
 }
-
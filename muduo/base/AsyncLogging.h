@@ -6,36 +6,80 @@
 #ifndef MUDUO_BASE_ASYNCLOGGING_H
 #define MUDUO_BASE_ASYNCLOGGING_H
 
-#include "muduo/base/BlockingQueue.h"
-#include "muduo/base/BoundedBlockingQueue.h"
 #include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Thread.h"
-#include "muduo/base/LogStream.h"
 
 #include <atomic>
+#include <functional>
 #include <vector>
 
+#include <pthread.h>
+
 namespace muduo
 {
 
+class LogFile;
+
+///
+/// Writes log lines to LogFile in a background thread.
+///
+/// Each logging thread appends to its own staging ring, without locking.
+/// The background thread drains all rings every flushInterval seconds,
+/// or sooner if a ring is half full.  Lines of one thread keep their
+/// order, lines of different threads are grouped by thread in a round.
+///
+/// Records of BinaryLogger go to another ring of each thread, and are
+/// rendered into text by the background thread, after the lines.
+///
 class AsyncLogging : noncopyable
 {
  public:
+  /// What append() does if the ring of calling thread is full.
+  enum OverflowPolicy
+  {
+    kBlock,   // waits for the background thread
+    kDrop,    // drops the line
+    kSample,  // when the ring is over half full, keeps one line of
+              // every sampleRate, drops the others, and drops if full
+  };
 
   AsyncLogging(const string& basename,
                off_t rollSize,
                int flushInterval = 3);
 
-  ~AsyncLogging()
+  ~AsyncLogging();
+
+  // Must be called before start().
+  void setOverflowPolicy(OverflowPolicy policy, int sampleRate = 10)
   {
-    if (running_)
-    {
-      stop();
-    }
+    policy_ = policy;
+    sampleRate_ = sampleRate;
   }
+  /// Bytes of staging ring of each logging thread, default 1MiB.
+  void setThreadBufferSize(size_t bytes)
+  { threadBufferSize_ = bytes; }
+  /// Writes with writev(2) to a preallocated file, and fdatasync(2) every
+  /// flushInterval, instead of stdio and fflush(3), default true.
+  void setUnbufferedOutput(bool on)
+  { unbufferedOutput_ = on; }
+  /// Copies into mmap(2)ed segments of files, see FileUtil::MappedAppendFile,
+  /// instead of either above, default false.
+  void setMappedOutput(bool on)
+  { mappedOutput_ = on; }
+  /// Writes records of appendBinary() as they are to files of
+  /// basename.bin, for offline decoding, instead of text, default false.
+  void setRawBinaryOutput(bool on)
+  { rawBinaryOutput_ = on; }
+  typedef std::function<void (const string& filename)> RollCallback;
+  /// Called in the background thread with name of each rolled file,
+  /// e.g. LogArchiver::archive().
+  void setRollCallback(const RollCallback& cb)
+  { rollCallback_ = cb; }
 
   void append(const char* logline, int len);
+  /// For BinaryLogger::setOutput(), @c record is a binlog::kRecord frame.
+  void appendBinary(const char* record, int len);
 
   void start()
   {
@@ -47,29 +91,56 @@ class AsyncLogging : noncopyable
   void stop() NO_THREAD_SAFETY_ANALYSIS
   {
     running_ = false;
-    cond_.notify();
+    wakeup();
     thread_.join();
   }
 
+  int64_t droppedMessages() const { return droppedMessages_; }
+  int64_t droppedBytes() const { return droppedBytes_; }
+
  private:
+  class ThreadBuffer;
+  typedef std::vector<ThreadBuffer*> ThreadBufferList;
 
-  void threadFunc();
+  static void threadExited(void* buffer);
+  static bool freeExited(ThreadBuffer* buffer);
 
-  typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
-  typedef std::vector<std::unique_ptr<Buffer>> BufferVector;
-  typedef BufferVector::value_type BufferPtr;
+  void threadFunc();
+  ThreadBuffer* threadBuffer(pthread_key_t key, bool binary);
+  void appendTo(ThreadBuffer* buffer, const char* data, int len);
+  bool appendFull(ThreadBuffer* buffer, const char* logline, size_t len);
+  void drop(size_t len);
+  void wakeup();
+  void reportDropped(LogFile* output);
+  void writeRawBinary(const string& records, string* sites, LogFile* output);
 
   const int flushInterval_;
   std::atomic<bool> running_;
   const string basename_;
   const off_t rollSize_;
+  OverflowPolicy policy_;
+  int sampleRate_;
+  size_t threadBufferSize_;
+  bool unbufferedOutput_;
+  bool mappedOutput_;
+  bool rawBinaryOutput_;
+  RollCallback rollCallback_;
+  pthread_key_t key_;
+  pthread_key_t binaryKey_;
   muduo::Thread thread_;
   muduo::CountDownLatch latch_;
   muduo::MutexLock mutex_;
   muduo::Condition cond_ GUARDED_BY(mutex_);
-  BufferPtr currentBuffer_ GUARDED_BY(mutex_);
-  BufferPtr nextBuffer_ GUARDED_BY(mutex_);
-  BufferVector buffers_ GUARDED_BY(mutex_);
+  bool wakeupPending_ GUARDED_BY(mutex_);
+  // kBlock, signaled by background thread after it frees rings
+  muduo::Condition spaceCond_ GUARDED_BY(mutex_);
+  int blockedWriters_ GUARDED_BY(mutex_);
+  ThreadBufferList buffers_ GUARDED_BY(mutex_);  // owned
+  std::atomic<int64_t> droppedMessages_;
+  std::atomic<int64_t> droppedBytes_;
+  // by background thread
+  int64_t reportedMessages_;
+  int64_t reportedBytes_;
 };
 
 }  // namespace muduo
@@ -0,0 +1,412 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/BinaryLogging.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Timestamp.h"
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <time.h>
+
+namespace muduo
+{
+
+extern const char* LogLevelName[Logger::NUM_LOG_LEVELS];
+
+namespace detail
+{
+
+struct LogSiteRegistry
+{
+  MutexLock mutex;
+  std::vector<const LogSite*> sites GUARDED_BY(mutex);
+};
+
+// never deleted, for sites logged while exiting
+LogSiteRegistry& logSiteRegistry()
+{
+  static LogSiteRegistry* registry = new LogSiteRegistry;
+  return *registry;
+}
+
+void defaultBinaryOutput(const char* record, int len)
+{
+  static MutexLock mutex;
+  static binlog::Decoder decoder;
+  string text;
+  {
+  MutexLockGuard lock(mutex);
+  decoder.setUseRegistry(true);
+  decoder.decode(record, static_cast<size_t>(len), &text);
+  }
+  size_t n = fwrite(text.data(), 1, text.size(), stdout);
+  (void)n;
+}
+
+BinaryLogger::OutputFunc g_binaryOutput = defaultBinaryOutput;
+
+}  // namespace detail
+
+}  // namespace muduo
+
+using namespace muduo;
+using namespace muduo::binlog;
+
+LogSite::LogSite(Logger::LogLevel level, Logger::SourceFile file, int line,
+                 const char* func, const char* format)
+  : level_(level),
+    file_(file),
+    line_(line),
+    func_(func),
+    format_(format),
+    id_(0)
+{
+  detail::LogSiteRegistry& registry = detail::logSiteRegistry();
+  MutexLockGuard lock(registry.mutex);
+  id_ = static_cast<int>(registry.sites.size());
+  registry.sites.push_back(this);
+}
+
+const LogSite* LogSite::find(int id)
+{
+  detail::LogSiteRegistry& registry = detail::logSiteRegistry();
+  MutexLockGuard lock(registry.mutex);
+  if (id >= 0 && static_cast<size_t>(id) < registry.sites.size())
+  {
+    return registry.sites[id];
+  }
+  return NULL;
+}
+
+void BinaryLogger::setOutput(OutputFunc out)
+{
+  detail::g_binaryOutput = out;
+}
+
+void BinaryLogger::output(const char* record, int len)
+{
+  detail::g_binaryOutput(record, len);
+}
+
+void binlog::appendSite(const LogSite& site, string* frames)
+{
+  const char* func = site.func() ? site.func() : "";
+  size_t length = sizeof(FrameHeader) + 3 * sizeof(int32_t)
+      + static_cast<size_t>(site.file().size_) + 1 + strlen(func) + 1
+      + strlen(site.format()) + 1;
+  FrameHeader header = { static_cast<uint32_t>(length), kSite };
+  int32_t fields[3] = { site.id(), site.level(), site.line() };
+  frames->append(reinterpret_cast<const char*>(&header), sizeof header);
+  frames->append(reinterpret_cast<const char*>(fields), sizeof fields);
+  frames->append(site.file().data_, static_cast<size_t>(site.file().size_));
+  frames->push_back('\0');
+  frames->append(func);
+  frames->push_back('\0');
+  frames->append(site.format());
+  frames->push_back('\0');
+}
+
+size_t binlog::frameLength(const char* data, size_t len)
+{
+  FrameHeader header;
+  if (len < sizeof header)
+  {
+    return 0;
+  }
+  memcpy(&header, data, sizeof header);
+  if (header.length < sizeof header || header.length > len)
+  {
+    return 0;
+  }
+  return header.length;
+}
+
+Encoder::Encoder(const LogSite& site)
+  : cur_(buf_ + sizeof(RecordHeader))
+{
+  RecordHeader header;
+  header.frame.length = 0;
+  header.frame.type = kRecord;
+  header.site = site.id();
+  header.tid = CurrentThread::tid();
+  header.microSecondsSinceEpoch = Timestamp::now().microSecondsSinceEpoch();
+  memcpy(buf_, &header, sizeof header);
+}
+
+void Encoder::finish()
+{
+  uint32_t len = static_cast<uint32_t>(length());
+  memcpy(buf_, &len, sizeof len);
+}
+
+void Encoder::putString(const char* str, size_t len)
+{
+  uint32_t avail = static_cast<uint32_t>(end() - cur_);
+  if (avail < 1 + sizeof(uint32_t))
+  {
+    return;
+  }
+  uint32_t n = static_cast<uint32_t>(std::min<size_t>(len, avail - 1 - sizeof(uint32_t)));
+  *cur_++ = static_cast<char>(kString);
+  memcpy(cur_, &n, sizeof n);
+  cur_ += sizeof n;
+  memcpy(cur_, str, n);
+  cur_ += n;
+}
+
+Decoder::Decoder()
+  : useRegistry_(false),
+    lastSecond_(-1),
+    badRecords_(0)
+{
+  time_[0] = '\0';
+}
+
+size_t Decoder::decode(const char* data, size_t len, string* text)
+{
+  size_t pos = 0;
+  size_t n = 0;
+  while ((n = frameLength(data + pos, len - pos)) > 0)
+  {
+    FrameHeader header;
+    memcpy(&header, data + pos, sizeof header);
+    if (header.type == kSite)
+    {
+      decodeSite(data + pos, n);
+    }
+    else if (header.type == kRecord)
+    {
+      decodeRecord(data + pos, n, text);
+    }
+    else
+    {
+      ++badRecords_;
+    }
+    pos += n;
+  }
+  return pos;
+}
+
+void Decoder::decodeSite(const char* data, size_t len)
+{
+  int32_t fields[3];
+  const char* end = data + len;
+  const char* p = data + sizeof(FrameHeader) + sizeof fields;
+  if (p > end || *(end - 1) != '\0')
+  {
+    ++badRecords_;
+    return;
+  }
+  memcpy(fields, data + sizeof(FrameHeader), sizeof fields);
+  if (fields[0] < 0 || fields[0] >= kMaxSites)
+  {
+    ++badRecords_;
+    return;
+  }
+  if (static_cast<size_t>(fields[0]) >= sites_.size())
+  {
+    sites_.resize(fields[0] + 1);
+  }
+  if (!sites_[fields[0]])
+  {
+    sites_[fields[0]].reset(new Site);
+  }
+  Site& site = *sites_[fields[0]];
+  site.known = true;
+  site.level = std::min<int32_t>(std::max<int32_t>(fields[1], 0), Logger::NUM_LOG_LEVELS - 1);
+  site.line = fields[2];
+  string* strings[3] = { &site.file, &site.func, &site.format };
+  for (string* str : strings)
+  {
+    const char* nul = p < end ? static_cast<const char*>(memchr(p, '\0', end - p)) : NULL;
+    if (nul == NULL)
+    {
+      ++badRecords_;
+      site.known = false;
+      return;
+    }
+    str->assign(p, nul);
+    p = nul + 1;
+  }
+}
+
+const Decoder::Site* Decoder::findSite(int id)
+{
+  if (const Site* site = knownSite(id))
+  {
+    return site;
+  }
+  const LogSite* site = useRegistry_ ? LogSite::find(id) : NULL;
+  if (site == NULL)
+  {
+    return NULL;
+  }
+  string frame;
+  appendSite(*site, &frame);
+  decodeSite(frame.data(), frame.size());
+  return knownSite(id);
+}
+
+const Decoder::Site* Decoder::knownSite(int id) const
+{
+  if (id >= 0 && static_cast<size_t>(id) < sites_.size()
+      && sites_[id] && sites_[id]->known)
+  {
+    return sites_[id].get();
+  }
+  return NULL;
+}
+
+void Decoder::decodeRecord(const char* data, size_t len, string* text)
+{
+  RecordHeader header;
+  if (len < sizeof header)
+  {
+    ++badRecords_;
+    return;
+  }
+  memcpy(&header, data, sizeof header);
+  const char* arg = data + sizeof header;
+  const char* end = data + len;
+  bool good = true;
+
+  formatTime(header.microSecondsSinceEpoch);
+  stream_ << Fmt("%5d ", header.tid);
+  const Site* site = findSite(header.site);
+  if (site)
+  {
+    stream_ << LogLevelName[site->level];
+    if (site->level <= Logger::DEBUG && !site->func.empty())
+    {
+      stream_ << site->func << ' ';
+    }
+    const char* format = site->format.c_str();
+    const char* placeholder = NULL;
+    while ((placeholder = strstr(format, "{}")) != NULL)
+    {
+      stream_.append(format, static_cast<int>(placeholder - format));
+      format = placeholder + 2;
+      if (arg < end)
+      {
+        good = appendArg(&arg, end) && good;
+      }
+      else
+      {
+        stream_ << "{}";
+      }
+    }
+    stream_ << format;
+  }
+  else
+  {
+    stream_ << "UNKNOWN site " << header.site;
+    good = false;
+  }
+  while (arg < end && good)
+  {
+    stream_ << ' ';
+    good = appendArg(&arg, end);
+  }
+  if (site)
+  {
+    stream_ << " - " << site->file << ':' << site->line;
+  }
+  stream_ << '\n';
+  if (!good)
+  {
+    ++badRecords_;
+  }
+  const LogStream::Buffer& buf = stream_.buffer();
+  text->append(buf.data(), buf.length());
+  stream_.resetBuffer();
+}
+
+namespace
+{
+
+template<typename T>
+bool readValue(const char** arg, const char* end, T* value)
+{
+  if (static_cast<size_t>(end - *arg) < sizeof *value)
+  {
+    return false;
+  }
+  memcpy(value, *arg, sizeof *value);
+  *arg += sizeof *value;
+  return true;
+}
+
+template<typename T>
+bool appendValue(LogStream& stream, const char** arg, const char* end)
+{
+  T value;
+  if (!readValue(arg, end, &value))
+  {
+    return false;
+  }
+  stream << value;
+  return true;
+}
+
+}  // namespace
+
+bool Decoder::appendArg(const char** arg, const char* end)
+{
+  char type = *(*arg)++;
+  switch (type)
+  {
+    case kInt32:
+      return appendValue<int32_t>(stream_, arg, end);
+    case kUInt32:
+      return appendValue<uint32_t>(stream_, arg, end);
+    case kInt64:
+      return appendValue<int64_t>(stream_, arg, end);
+    case kUInt64:
+      return appendValue<uint64_t>(stream_, arg, end);
+    case kDouble:
+      return appendValue<double>(stream_, arg, end);
+    case kChar:
+      return appendValue<char>(stream_, arg, end);
+    case kBool:
+      return appendValue<bool>(stream_, arg, end);
+    case kPointer:
+      return appendValue<const void*>(stream_, arg, end);
+    case kString:
+    {
+      uint32_t len = 0;
+      if (!readValue(arg, end, &len) || static_cast<size_t>(end - *arg) < len)
+      {
+        return false;
+      }
+      stream_.append(*arg, static_cast<int>(len));
+      *arg += len;
+      return true;
+    }
+    default:
+      *arg = end;
+      return false;
+  }
+}
+
+void Decoder::formatTime(int64_t microSecondsSinceEpoch)
+{
+  int64_t seconds = microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond;
+  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+  if (seconds != lastSecond_)
+  {
+    lastSecond_ = seconds;
+    time_t t = static_cast<time_t>(seconds);
+    struct tm tm_time;
+    ::gmtime_r(&t, &tm_time);
+    snprintf(time_, sizeof time_, "%4d%02d%02d %02d:%02d:%02d",
+             tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+             tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+  }
+  stream_ << time_ << Fmt(".%06dZ ", microseconds);
+}
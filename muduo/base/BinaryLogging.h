@@ -0,0 +1,260 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_BINARYLOGGING_H
+#define MUDUO_BASE_BINARYLOGGING_H
+
+#include "muduo/base/Logging.h"
+
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// A LOGB_xxx statement, one static instance per statement, registered
+/// with a process-wide id on first use.
+///
+/// The format and source location of a statement live here, so a log
+/// record carries only the id of its site and the raw bytes of arguments.
+///
+class LogSite : noncopyable
+{
+ public:
+  LogSite(Logger::LogLevel level, Logger::SourceFile file, int line,
+          const char* func, const char* format);
+
+  int id() const { return id_; }
+  Logger::LogLevel level() const { return level_; }
+  const Logger::SourceFile& file() const { return file_; }
+  int line() const { return line_; }
+  const char* func() const { return func_; }
+  const char* format() const { return format_; }
+
+  /// Returns NULL if no such site in this process.
+  static const LogSite* find(int id);
+
+ private:
+  const Logger::LogLevel level_;
+  const Logger::SourceFile file_;
+  const int line_;
+  const char* const func_;
+  const char* const format_;
+  int id_;
+};
+
+namespace binlog
+{
+
+/// A record or a site is a frame, in memory and in files,
+/// all integers are in host byte order.
+enum FrameType
+{
+  kSite = 1,    // id, level, line, then file, func and format, '\0' terminated
+  kRecord = 2,  // RecordHeader, then arguments
+};
+
+struct FrameHeader
+{
+  uint32_t length;  // of whole frame, including this header
+  uint32_t type;
+};
+
+struct RecordHeader
+{
+  FrameHeader frame;
+  int32_t site;
+  int32_t tid;
+  int64_t microSecondsSinceEpoch;
+};
+
+/// An argument is a one-byte tag followed by its value,
+/// strings are copied as uint32_t length and bytes.
+enum ArgType
+{
+  kInt32 = 1,
+  kUInt32,
+  kInt64,
+  kUInt64,
+  kDouble,
+  kChar,
+  kBool,
+  kString,
+  kPointer,
+};
+
+const int kMaxRecordSize = 1024;
+/// Larger site ids of frames are bad records, so that a corrupted or
+/// hostile file can't make Decoder allocate without bound.
+const int kMaxSites = 1 << 20;
+
+/// Appends a kSite frame of @c site.
+void appendSite(const LogSite& site, string* frames);
+
+/// Returns length of the frame at @c data,
+/// 0 if less than a whole frame in @c len bytes.
+size_t frameLength(const char* data, size_t len);
+
+// Encodes a record on stack, long strings are truncated.
+class Encoder : noncopyable
+{
+ public:
+  explicit Encoder(const LogSite& site);
+
+  void append() {}
+
+  template<typename T, typename... Args>
+  void append(const T& x, const Args&... args)
+  {
+    encode(x);
+    append(args...);
+  }
+
+  // fills length in header
+  void finish();
+
+  const char* data() const { return buf_; }
+  int length() const { return static_cast<int>(cur_ - buf_); }
+
+ private:
+  void encode(signed char v) { encode(static_cast<int>(v)); }
+  void encode(unsigned char v) { encode(static_cast<unsigned>(v)); }
+  void encode(short v) { encode(static_cast<int>(v)); }
+  void encode(unsigned short v) { encode(static_cast<unsigned>(v)); }
+  void encode(int v) { put(kInt32, &v, sizeof v); }
+  void encode(unsigned v) { put(kUInt32, &v, sizeof v); }
+  void encode(long v) { encode(static_cast<long long>(v)); }
+  void encode(unsigned long v) { encode(static_cast<unsigned long long>(v)); }
+  void encode(long long v) { put(kInt64, &v, sizeof v); }
+  void encode(unsigned long long v) { put(kUInt64, &v, sizeof v); }
+  void encode(float v) { encode(static_cast<double>(v)); }
+  void encode(double v) { put(kDouble, &v, sizeof v); }
+  void encode(char v) { put(kChar, &v, sizeof v); }
+  void encode(bool v) { put(kBool, &v, sizeof v); }
+  void encode(const void* v) { put(kPointer, &v, sizeof v); }
+  void encode(const char* v) { putString(v, strlen(v)); }
+  void encode(const string& v) { putString(v.data(), v.size()); }
+  void encode(StringPiece v) { putString(v.data(), static_cast<size_t>(v.size())); }
+
+  void put(ArgType type, const void* value, size_t len)
+  {
+    if (static_cast<size_t>(end() - cur_) >= 1 + len)
+    {
+      *cur_++ = static_cast<char>(type);
+      memcpy(cur_, value, len);
+      cur_ += len;
+    }
+  }
+
+  void putString(const char* str, size_t len);
+
+  const char* end() const { return buf_ + sizeof buf_; }
+
+  char buf_[kMaxRecordSize];
+  char* cur_;
+};
+
+///
+/// Renders frames as text lines, of the same layout as Logger,
+/// but always in UTC.
+///
+/// Each "{}" in the format of a site is replaced by the next argument,
+/// extra arguments are appended.  Sites are learnt from kSite frames,
+/// or looked up in LogSite registry of this process if setUseRegistry().
+///
+class Decoder : noncopyable
+{
+ public:
+  Decoder();
+
+  void setUseRegistry(bool on) { useRegistry_ = on; }
+
+  /// Decodes whole frames at the beginning of @c data, appends lines
+  /// to @c text, returns number of bytes consumed.
+  size_t decode(const char* data, size_t len, string* text);
+
+  /// Records of unknown site or of bad arguments, rendered in part.
+  int64_t badRecords() const { return badRecords_; }
+
+ private:
+  struct Site
+  {
+    Site() : known(false), level(0), line(0) {}
+    bool known;
+    int level;
+    int line;
+    string file;
+    string func;
+    string format;
+  };
+
+  void decodeSite(const char* data, size_t len);
+  void decodeRecord(const char* data, size_t len, string* text);
+  const Site* findSite(int id);
+  const Site* knownSite(int id) const;
+  // returns false if bad argument
+  bool appendArg(const char** arg, const char* end);
+  void formatTime(int64_t microSecondsSinceEpoch);
+
+  bool useRegistry_;
+  std::vector<std::unique_ptr<Site>> sites_;  // indexed by site id, sparse
+  LogStream stream_;
+  int64_t lastSecond_;
+  char time_[64];
+  int64_t badRecords_;
+};
+
+}  // namespace binlog
+
+///
+/// Deferred-formatting logging, the hot thread copies only the id of its
+/// LogSite and raw arguments, text is rendered later by AsyncLogging,
+/// or offline from raw frames.
+///
+class BinaryLogger
+{
+ public:
+  typedef void (*OutputFunc)(const char* record, int len);
+
+  /// Default renders to text and writes to stdout.
+  static void setOutput(OutputFunc);
+
+  template<typename... Args>
+  static void log(const LogSite& site, const Args&... args)
+  {
+    binlog::Encoder encoder(site);
+    encoder.append(args...);
+    encoder.finish();
+    output(encoder.data(), encoder.length());
+  }
+
+ private:
+  static void output(const char* record, int len);
+};
+
+}  // namespace muduo
+
+// Same as LOG_xxx, but format is a string literal with "{}" placeholders,
+// and arguments are integers, floating points, chars, bools, pointers
+// or strings, for example,
+//
+// LOGB_INFO("conn {} read {} bytes", conn->name(), n);
+//
+#define LOGB_LOG(level, format, ...) \
+  do { if (MUDUO_MIN_LOG_LEVEL <= (level) && muduo::Logger::logLevel() <= (level)) { \
+    static const muduo::LogSite muduoLogSite((level), MUDUO_SOURCE_FILE, __LINE__, __func__, (format)); \
+    muduo::BinaryLogger::log(muduoLogSite, ##__VA_ARGS__); \
+  } } while (0)
+
+#define LOGB_TRACE(format, ...) LOGB_LOG(muduo::Logger::TRACE, format, ##__VA_ARGS__)
+#define LOGB_DEBUG(format, ...) LOGB_LOG(muduo::Logger::DEBUG, format, ##__VA_ARGS__)
+#define LOGB_INFO(format, ...) LOGB_LOG(muduo::Logger::INFO, format, ##__VA_ARGS__)
+#define LOGB_WARN(format, ...) LOGB_LOG(muduo::Logger::WARN, format, ##__VA_ARGS__)
+#define LOGB_ERROR(format, ...) LOGB_LOG(muduo::Logger::ERROR, format, ##__VA_ARGS__)
+
+#endif  // MUDUO_BASE_BINARYLOGGING_H
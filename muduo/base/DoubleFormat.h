@@ -0,0 +1,33 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_DOUBLEFORMAT_H
+#define MUDUO_BASE_DOUBLEFORMAT_H
+
+#include <stddef.h>
+
+namespace muduo
+{
+namespace detail
+{
+
+/// Enough for any output of formatShortest(), with '\0'.
+const int kMaxShortestSize = 25;
+
+/// Writes the shortest digits that read back to @c v, see Ulf Adams's
+/// "Ryu: Fast Float-to-String Conversion".  The layout is that of
+/// "%.17g" of printf(3), e.g. 0.1, 1e+100, 123456.789, -0, inf, nan.
+/// Returns length, excluding the '\0' written.
+int formatShortest(char* buf, double v);
+
+/// Writes @c v as "%.*f" of printf(3) does, correctly rounded, for
+/// @c precision in [0, 17] and |v| * 10^precision < 2^64.  Returns
+/// length, or -1 if out of these ranges or not fit in @c size.
+int formatFixed(char* buf, size_t size, double v, int precision);
+
+}  // namespace detail
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_DOUBLEFORMAT_H
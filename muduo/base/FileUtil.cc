@@ -6,30 +6,88 @@
 #include "muduo/base/FileUtil.h"
 #include "muduo/base/Logging.h"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 using namespace muduo;
 
 FileUtil::AppendFile::AppendFile(StringArg filename)
   : fp_(::fopen(filename.c_str(), "ae")),  // 'e' for O_CLOEXEC
-    writtenBytes_(0)
+    fd_(-1),
+    writtenBytes_(0),
+    fileSize_(0),
+    allocatedSize_(0),
+    preallocateBytes_(0)
 {
   assert(fp_);
   ::setbuffer(fp_, buffer_, sizeof buffer_);
   // posix_fadvise POSIX_FADV_DONTNEED ?
 }
 
+FileUtil::AppendFile::AppendFile(StringArg filename, bool unbuffered, off_t preallocateBytes)
+  : fp_(unbuffered ? NULL : ::fopen(filename.c_str(), "ae")),
+    fd_(unbuffered ? ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644) : -1),
+    writtenBytes_(0),
+    fileSize_(0),
+    allocatedSize_(0),
+    preallocateBytes_(unbuffered ? preallocateBytes : 0)
+{
+  if (unbuffered)
+  {
+    assert(fd_ >= 0);
+    struct stat statbuf;
+    if (::fstat(fd_, &statbuf) == 0)
+    {
+      fileSize_ = statbuf.st_size;
+      allocatedSize_ = fileSize_;
+    }
+  }
+  else
+  {
+    assert(fp_);
+    ::setbuffer(fp_, buffer_, sizeof buffer_);
+  }
+}
+
 FileUtil::AppendFile::~AppendFile()
 {
-  ::fclose(fp_);
+  if (fp_)
+  {
+    ::fclose(fp_);
+  }
+  else
+  {
+    if (preallocateBytes_ > 0 && allocatedSize_ > fileSize_)
+    {
+      // releases preallocated blocks beyond EOF
+      if (::ftruncate(fd_, fileSize_) < 0)
+      {
+        fprintf(stderr, "AppendFile::~AppendFile() ftruncate failed %s\n", strerror_tl(errno));
+      }
+    }
+    ::close(fd_);
+  }
 }
 
 void FileUtil::AppendFile::append(const char* logline, const size_t len)
+{
+  preallocate(len);
+  size_t n = writeFully(logline, len);
+  writtenBytes_ += n;
+  fileSize_ += n;
+}
+
+// returns bytes written, less than len if error
+size_t FileUtil::AppendFile::writeFully(const char* logline, const size_t len)
 {
   size_t n = write(logline, len);
   size_t remain = len - n;
@@ -38,7 +96,7 @@ void FileUtil::AppendFile::append(const char* logline, const size_t len)
     size_t x = write(logline + n, remain);
     if (x == 0)
     {
-      int err = ferror(fp_);
+      int err = fp_ ? ferror(fp_) : errno;
       if (err)
       {
         fprintf(stderr, "AppendFile::append() failed %s\n", strerror_tl(err));
@@ -48,19 +106,253 @@ void FileUtil::AppendFile::append(const char* logline, const size_t len)
     n += x;
     remain = len - n; // remain -= x
   }
+  return n;
+}
 
-  writtenBytes_ += len;
+void FileUtil::AppendFile::appendv(const struct iovec* iov, int iovcnt)
+{
+  if (fp_)
+  {
+    for (int i = 0; i < iovcnt; ++i)
+    {
+      append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return;
+  }
+
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i)
+  {
+    total += iov[i].iov_len;
+  }
+  preallocate(total);
+  size_t done = 0;  // bytes really written, not total if error
+  int i = 0;
+  while (i < iovcnt)
+  {
+    ssize_t n = ::writev(fd_, iov + i, std::min(iovcnt - i, IOV_MAX));
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fprintf(stderr, "AppendFile::appendv() failed %s\n", strerror_tl(errno));
+      break;
+    }
+    size_t written = static_cast<size_t>(n);
+    done += written;
+    while (i < iovcnt && written >= iov[i].iov_len)
+    {
+      written -= iov[i].iov_len;
+      ++i;
+    }
+    if (written > 0)
+    {
+      // short write, finishes this one
+      size_t remain = iov[i].iov_len - written;
+      size_t x = writeFully(static_cast<const char*>(iov[i].iov_base) + written, remain);
+      done += x;
+      if (x < remain)
+      {
+        break;
+      }
+      ++i;
+    }
+  }
+  writtenBytes_ += done;
+  fileSize_ += done;
 }
 
 void FileUtil::AppendFile::flush()
 {
-  ::fflush(fp_);
+  if (fp_)
+  {
+    ::fflush(fp_);
+  }
+  else
+  {
+    ::fdatasync(fd_);
+  }
 }
 
 size_t FileUtil::AppendFile::write(const char* logline, size_t len)
 {
-  // #undef fwrite_unlocked
-  return ::fwrite_unlocked(logline, 1, len, fp_);
+  if (fp_)
+  {
+    // #undef fwrite_unlocked
+    return ::fwrite_unlocked(logline, 1, len, fp_);
+  }
+  ssize_t n = ::write(fd_, logline, len);
+  if (n < 0 && errno == EINTR)
+  {
+    n = ::write(fd_, logline, len);
+  }
+  return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+void FileUtil::AppendFile::preallocate(size_t len)
+{
+  off_t end = fileSize_ + static_cast<off_t>(len);
+  if (preallocateBytes_ > 0 && end > allocatedSize_)
+  {
+    off_t size = std::max(preallocateBytes_, end - allocatedSize_);
+    // FALLOC_FL_KEEP_SIZE, so O_APPEND still writes at EOF
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, allocatedSize_, size) == 0)
+    {
+      allocatedSize_ += size;
+    }
+    else
+    {
+      // eg. not supported by file system, gives up
+      preallocateBytes_ = 0;
+    }
+  }
+}
+
+FileUtil::MappedAppendFile::MappedAppendFile(StringArg filename, off_t segmentBytes)
+  : fd_(::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)),
+    segmentBytes_(0),
+    segment_(NULL),
+    segmentStart_(0),
+    fileSize_(0),
+    allocatedSize_(0),
+    flushedSize_(0),
+    writtenBytes_(0)
+{
+  assert(fd_ >= 0);
+  struct stat statbuf;
+  if (::fstat(fd_, &statbuf) == 0)
+  {
+    fileSize_ = statbuf.st_size;
+    allocatedSize_ = fileSize_;
+    flushedSize_ = fileSize_;
+  }
+  off_t pageSize = ::sysconf(_SC_PAGESIZE);
+  segmentBytes_ = std::max(segmentBytes + pageSize - 1, pageSize) / pageSize * pageSize;
+  mapSegment(fileSize_ / pageSize * pageSize);
+}
+
+FileUtil::MappedAppendFile::~MappedAppendFile()
+{
+  unmapSegment();
+  if (allocatedSize_ > fileSize_ && ::ftruncate(fd_, fileSize_) < 0)
+  {
+    fprintf(stderr, "MappedAppendFile::~MappedAppendFile() ftruncate failed %s\n",
+            strerror_tl(errno));
+  }
+  ::close(fd_);
+}
+
+bool FileUtil::MappedAppendFile::mapSegment(off_t offset)
+{
+  off_t end = offset + segmentBytes_;
+  if (end > allocatedSize_)
+  {
+    // extends the file, so stores to the mapping never SIGBUS for ENOSPC,
+    // a file system without fallocate(2) gets a sparse file instead,
+    // others fail, ENOSPC included, and append() falls back to write(2).
+    int ret = ::fallocate(fd_, 0, allocatedSize_, end - allocatedSize_);
+    if (ret < 0 && (errno == EOPNOTSUPP || errno == ENOSYS))
+    {
+      ret = ::ftruncate(fd_, end);
+    }
+    if (ret < 0)
+    {
+      fprintf(stderr, "MappedAppendFile::mapSegment() failed %s\n", strerror_tl(errno));
+      segmentBytes_ = 0;
+      return false;
+    }
+    allocatedSize_ = end;
+  }
+  void* addr = ::mmap(NULL, static_cast<size_t>(segmentBytes_), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd_, offset);
+  if (addr == MAP_FAILED)
+  {
+    fprintf(stderr, "MappedAppendFile::mapSegment() mmap failed %s\n", strerror_tl(errno));
+    segmentBytes_ = 0;
+    return false;
+  }
+  segment_ = static_cast<char*>(addr);
+  segmentStart_ = offset;
+  return true;
+}
+
+void FileUtil::MappedAppendFile::unmapSegment()
+{
+  if (segment_)
+  {
+    ::munmap(segment_, static_cast<size_t>(segmentBytes_));
+    segment_ = NULL;
+  }
+}
+
+void FileUtil::MappedAppendFile::append(const char* logline, const size_t len)
+{
+  size_t remain = len;
+  while (remain > 0)
+  {
+    off_t segmentEnd = segmentStart_ + segmentBytes_;
+    if (segment_ && fileSize_ == segmentEnd)
+    {
+      unmapSegment();
+      mapSegment(segmentEnd);
+    }
+    if (segment_ == NULL)
+    {
+      remain -= writeFully(logline, remain);
+      break;
+    }
+    size_t n = std::min(remain, static_cast<size_t>(segmentStart_ + segmentBytes_ - fileSize_));
+    memcpy(segment_ + (fileSize_ - segmentStart_), logline, n);
+    fileSize_ += n;
+    logline += n;
+    remain -= n;
+  }
+  writtenBytes_ += len - remain;
+}
+
+void FileUtil::MappedAppendFile::appendv(const struct iovec* iov, int iovcnt)
+{
+  for (int i = 0; i < iovcnt; ++i)
+  {
+    append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+}
+
+// returns bytes written, less than len if error
+size_t FileUtil::MappedAppendFile::writeFully(const char* logline, size_t len)
+{
+  size_t written = 0;
+  while (len > 0)
+  {
+    ssize_t n = ::pwrite(fd_, logline, len, fileSize_);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      fprintf(stderr, "MappedAppendFile::append() failed %s\n", strerror_tl(errno));
+      break;
+    }
+    fileSize_ += n;
+    logline += n;
+    len -= static_cast<size_t>(n);
+    written += static_cast<size_t>(n);
+  }
+  return written;
+}
+
+void FileUtil::MappedAppendFile::flush()
+{
+  // msync(MS_ASYNC) is a no-op on Linux, this starts write-back of
+  // records since last flush without waiting for it
+  if (fileSize_ > flushedSize_)
+  {
+    ::sync_file_range(fd_, flushedSize_, fileSize_ - flushedSize_, SYNC_FILE_RANGE_WRITE);
+    flushedSize_ = fileSize_;
+  }
 }
 
 FileUtil::ReadSmallFile::ReadSmallFile(StringArg filename)
@@ -12,6 +12,8 @@
 #include "muduo/base/StringPiece.h"
 #include <sys/types.h>  // for off_t
 
+struct iovec;
+
 namespace muduo
 {
 namespace FileUtil
@@ -65,10 +67,19 @@ class AppendFile : noncopyable
  public:
   explicit AppendFile(StringArg filename);
 
+  /// If @c unbuffered, writes go to the file descriptor by write(2) and
+  /// writev(2), without a stdio buffer, flush() calls fdatasync(2), and
+  /// disk space is preallocated with fallocate(2), @c preallocateBytes at
+  /// a time if > 0, the unused part is released on close.
+  AppendFile(StringArg filename, bool unbuffered, off_t preallocateBytes = 0);
+
   ~AppendFile();
 
   void append(const char* logline, size_t len);
 
+  /// Appends all of @c iov, with one writev(2) if unbuffered.
+  void appendv(const struct iovec* iov, int iovcnt);
+
   void flush();
 
   off_t writtenBytes() const { return writtenBytes_; }
@@ -76,10 +87,55 @@ class AppendFile : noncopyable
  private:
 
   size_t write(const char* logline, size_t len);
+  size_t writeFully(const char* logline, size_t len);
+  void preallocate(size_t len);
 
   FILE* fp_;
+  int fd_;  // if unbuffered
   char buffer_[64*1024];
   off_t writtenBytes_;
+  off_t fileSize_;  // if unbuffered
+  off_t allocatedSize_;
+  off_t preallocateBytes_;
+};
+
+///
+/// Appends by memcpy(3) into a shared mapping of the file, which grows one
+/// segment of @c segmentBytes at a time by fallocate(2).
+///
+/// A record is in the page cache once copied, so a crashed process still
+/// leaves all records on disk, followed by '\0' up to the segment end.
+/// flush() starts write-back without waiting, the file is truncated to
+/// its real length on close.  Falls back to pwrite(2) if mmap(2) fails.
+///
+// not thread safe
+class MappedAppendFile : noncopyable
+{
+ public:
+  MappedAppendFile(StringArg filename, off_t segmentBytes);
+  ~MappedAppendFile();
+
+  void append(const char* logline, size_t len);
+
+  void appendv(const struct iovec* iov, int iovcnt);
+
+  void flush();
+
+  off_t writtenBytes() const { return writtenBytes_; }
+
+ private:
+  bool mapSegment(off_t offset);
+  void unmapSegment();
+  size_t writeFully(const char* logline, size_t len);
+
+  int fd_;
+  off_t segmentBytes_;   // 0 if fell back to pwrite(2)
+  char* segment_;        // maps [segmentStart_, segmentStart_ + segmentBytes_)
+  off_t segmentStart_;
+  off_t fileSize_;       // of records, the file is longer while open
+  off_t allocatedSize_;
+  off_t flushedSize_;    // write-back started
+  off_t writtenBytes_;
 };
 
 }  // namespace FileUtil
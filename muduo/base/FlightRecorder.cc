@@ -0,0 +1,473 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/FlightRecorder.h"
+
+#include "muduo/base/CurrentThread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace muduo
+{
+namespace detail
+{
+
+const uint32_t kRingMagic = 0x4652696e;  // "FRin"
+const char kDumpMagic[8] = { 'M', 'U', 'D', 'U', 'O', 'F', 'R', '1' };
+const int kMaxRings = 1024;
+const size_t kAltStackSize = 64*1024;
+const int kFatalSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+const int kNumFatalSignals = sizeof kFatalSignals / sizeof kFatalSignals[0];
+
+enum RingState
+{
+  kRingFree,
+  kRingOwned,
+};
+
+// at the beginning of each ring, followed by data of capacity bytes
+struct Ring
+{
+  uint32_t magic;
+  uint32_t capacity;  // power of 2
+  int32_t tid;
+  std::atomic<int32_t> state;
+  std::atomic<uint64_t> head;  // total bytes written
+  std::atomic<uint64_t> tail;  // first whole record
+  char name[32];
+  char* altStack;  // signal stack of owner, kept for next owner
+
+  char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+// copy of Ring in dumps, followed by data
+struct DumpedRing
+{
+  uint32_t magic;
+  uint32_t capacity;
+  int32_t tid;
+  int32_t reserved;
+  uint64_t head;
+  uint64_t tail;
+  char name[32];
+};
+
+struct DumpHeader
+{
+  char magic[8];
+  int32_t pid;
+  int32_t reserved;
+};
+
+// a line in ring
+struct Record
+{
+  uint32_t length;  // including this header
+  int32_t level;
+  int64_t microSecondsSinceEpoch;
+};
+
+std::atomic<Ring*> g_rings[kMaxRings];
+std::atomic<int> g_numRings(0);
+uint32_t g_capacity = 0;
+char g_dumpFile[PATH_MAX];
+pthread_key_t g_ringKey;
+std::atomic<bool> g_crashDumped(false);
+std::atomic<bool> g_altStacks(false);
+struct sigaction g_oldActions[kNumFatalSignals];
+
+__thread Ring* t_ring = NULL;
+__thread bool t_noRing = false;
+
+void releaseRing(void* arg)
+{
+  Ring* ring = static_cast<Ring*>(arg);
+  stack_t ss;
+  if (ring->altStack && ::sigaltstack(NULL, &ss) == 0 && ss.ss_sp == ring->altStack)
+  {
+    // next owner may take it before this thread is gone
+    memZero(&ss, sizeof ss);
+    ss.ss_flags = SS_DISABLE;
+    ::sigaltstack(&ss, NULL);
+  }
+  // lines logged by later key destructors of this thread go nowhere,
+  // the ring may be claimed by another thread once free
+  t_ring = NULL;
+  t_noRing = true;
+  ring->state.store(kRingFree, std::memory_order_release);
+}
+
+// so that fatal signals of stack overflow get handled,
+// unless the thread has a signal stack of its own
+void setAltStack(Ring* ring)
+{
+  stack_t ss;
+  if (::sigaltstack(NULL, &ss) < 0 || (ss.ss_flags & SS_DISABLE) == 0)
+  {
+    return;
+  }
+  if (ring->altStack == NULL)
+  {
+    void* addr = ::mmap(NULL, kAltStackSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+    {
+      return;
+    }
+    ring->altStack = static_cast<char*>(addr);
+  }
+  memZero(&ss, sizeof ss);
+  ss.ss_sp = ring->altStack;
+  ss.ss_size = kAltStackSize;
+  ::sigaltstack(&ss, NULL);
+}
+
+void copyIn(Ring* ring, uint64_t pos, const void* src, size_t len)
+{
+  size_t offset = static_cast<size_t>(pos & (ring->capacity - 1));
+  size_t n = std::min<size_t>(len, ring->capacity - offset);
+  memcpy(ring->data() + offset, src, n);
+  memcpy(ring->data(), static_cast<const char*>(src) + n, len - n);
+}
+
+void copyOut(const char* data, uint32_t capacity, uint64_t pos, void* dest, size_t len)
+{
+  size_t offset = static_cast<size_t>(pos & (capacity - 1));
+  size_t n = std::min<size_t>(len, capacity - offset);
+  memcpy(dest, data + offset, n);
+  memcpy(static_cast<char*>(dest) + n, data, len - n);
+}
+
+// a free ring of an exited thread, or a new one, NULL if too many
+Ring* claimRing()
+{
+  int numRings = std::min(g_numRings.load(std::memory_order_acquire), kMaxRings);
+  for (int i = 0; i < numRings; ++i)
+  {
+    Ring* ring = g_rings[i].load(std::memory_order_acquire);
+    int32_t expected = kRingFree;
+    if (ring && ring->state.compare_exchange_strong(expected, kRingOwned))
+    {
+      // lines of the previous owner are gone
+      ring->tail.store(0, std::memory_order_relaxed);
+      ring->head.store(0, std::memory_order_release);
+      return ring;
+    }
+  }
+
+  if (g_numRings.load(std::memory_order_relaxed) >= kMaxRings)
+  {
+    return NULL;
+  }
+  void* addr = ::mmap(NULL, sizeof(Ring) + g_capacity, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED)
+  {
+    return NULL;
+  }
+  Ring* ring = new (addr) Ring;
+  ring->magic = kRingMagic;
+  ring->capacity = g_capacity;
+  ring->state.store(kRingOwned, std::memory_order_relaxed);
+  ring->head.store(0, std::memory_order_relaxed);
+  ring->tail.store(0, std::memory_order_relaxed);
+  ring->altStack = NULL;
+  int index = g_numRings.fetch_add(1);
+  if (index >= kMaxRings)
+  {
+    ::munmap(addr, sizeof(Ring) + g_capacity);
+    return NULL;
+  }
+  g_rings[index].store(ring, std::memory_order_release);
+  return ring;
+}
+
+Ring* threadRing()
+{
+  if (t_ring == NULL && !t_noRing)
+  {
+    t_ring = claimRing();
+    if (t_ring)
+    {
+      t_ring->tid = CurrentThread::tid();
+      memZero(t_ring->name, sizeof t_ring->name);
+      strncpy(t_ring->name, CurrentThread::name(), sizeof t_ring->name - 1);
+      pthread_setspecific(g_ringKey, t_ring);
+      if (g_altStacks.load(std::memory_order_acquire))
+      {
+        setAltStack(t_ring);
+      }
+    }
+    else
+    {
+      t_noRing = true;
+    }
+  }
+  return t_ring;
+}
+
+void append(Ring* ring, Logger::LogLevel level, int64_t microSecondsSinceEpoch,
+            const char* msg, int len)
+{
+  // a line never takes more than 1/4 of the ring
+  size_t size = std::min(static_cast<size_t>(len), ring->capacity / 4 - sizeof(Record));
+  Record record = { static_cast<uint32_t>(sizeof record + size), level, microSecondsSinceEpoch };
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+  if (head + record.length - tail > ring->capacity)
+  {
+    while (head + record.length - tail > ring->capacity)
+    {
+      Record oldest;
+      copyOut(ring->data(), ring->capacity, tail, &oldest, sizeof oldest);
+      tail += oldest.length;
+    }
+    ring->tail.store(tail, std::memory_order_release);
+  }
+  copyIn(ring, head, &record, sizeof record);
+  copyIn(ring, head + sizeof record, msg, size);
+  ring->head.store(head + record.length, std::memory_order_release);
+}
+
+// Sink is bool(const void*, size_t)
+template<typename Sink>
+bool dumpRings(Sink&& sink)
+{
+  DumpHeader header;
+  memZero(&header, sizeof header);
+  memcpy(header.magic, kDumpMagic, sizeof header.magic);
+  header.pid = static_cast<int32_t>(::getpid());
+  bool ok = sink(&header, sizeof header);
+  int numRings = std::min(g_numRings.load(std::memory_order_acquire), kMaxRings);
+  for (int i = 0; i < numRings && ok; ++i)
+  {
+    Ring* ring = g_rings[i].load(std::memory_order_acquire);
+    if (ring == NULL)
+    {
+      continue;
+    }
+    DumpedRing dumped;
+    memZero(&dumped, sizeof dumped);
+    dumped.magic = ring->magic;
+    dumped.capacity = ring->capacity;
+    dumped.tid = ring->tid;
+    dumped.tail = ring->tail.load(std::memory_order_acquire);
+    dumped.head = ring->head.load(std::memory_order_acquire);
+    memcpy(dumped.name, ring->name, sizeof dumped.name);
+    ok = sink(&dumped, sizeof dumped) && sink(ring->data(), ring->capacity);
+  }
+  return ok;
+}
+
+bool writeFully(int fd, const void* data, size_t len)
+{
+  const char* p = static_cast<const char*>(data);
+  while (len > 0)
+  {
+    ssize_t n = ::write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    p += n;
+    len -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void crashDump()
+{
+  if (!g_crashDumped.exchange(true))
+  {
+    FlightRecorder::dump();
+  }
+}
+
+void onFatalSignal(int sig)
+{
+  crashDump();
+  // delivered to the previous action once this handler returns,
+  // or again by the faulting instruction
+  for (int i = 0; i < kNumFatalSignals; ++i)
+  {
+    if (kFatalSignals[i] == sig)
+    {
+      ::sigaction(sig, &g_oldActions[i], NULL);
+    }
+  }
+  ::raise(sig);
+}
+
+}  // namespace detail
+}  // namespace muduo
+
+using namespace muduo;
+using namespace muduo::detail;
+
+void FlightRecorder::start(const string& dumpFile, Logger::LogLevel level, size_t bytesPerThread)
+{
+  assert(!started());
+  uint32_t capacity = 4096;
+  while (capacity < bytesPerThread && capacity < (1u << 30))
+  {
+    capacity *= 2;
+  }
+  g_capacity = capacity;
+  strncpy(g_dumpFile, dumpFile.c_str(), sizeof g_dumpFile - 1);
+  pthread_key_create(&g_ringKey, releaseRing);
+  Logger::setRecorder(record, level);
+}
+
+bool FlightRecorder::started()
+{
+  return g_capacity > 0;
+}
+
+void FlightRecorder::installSignalHandlers()
+{
+  g_altStacks.store(true, std::memory_order_release);
+  Ring* ring = threadRing();
+  if (ring)
+  {
+    setAltStack(ring);
+  }
+
+  struct sigaction sa;
+  memZero(&sa, sizeof sa);
+  sa.sa_handler = onFatalSignal;
+  sa.sa_flags = SA_ONSTACK;
+  sigemptyset(&sa.sa_mask);
+  for (int i = 0; i < kNumFatalSignals; ++i)
+  {
+    ::sigaction(kFatalSignals[i], &sa, &g_oldActions[i]);
+  }
+}
+
+void FlightRecorder::record(Logger::LogLevel level, Timestamp time, const char* msg, int len)
+{
+  Ring* ring = threadRing();
+  if (ring)
+  {
+    append(ring, level, time.microSecondsSinceEpoch(), msg, len);
+  }
+  if (level == Logger::FATAL)
+  {
+    crashDump();
+  }
+}
+
+bool FlightRecorder::dump(const char* filename)
+{
+  int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    return false;
+  }
+  bool ok = dumpRings([fd](const void* data, size_t len) { return writeFully(fd, data, len); });
+  ::close(fd);
+  return ok;
+}
+
+bool FlightRecorder::dump()
+{
+  return started() && dump(g_dumpFile);
+}
+
+string FlightRecorder::snapshot()
+{
+  string data;
+  dumpRings([&data](const void* p, size_t len)
+            {
+              data.append(static_cast<const char*>(p), len);
+              return true;
+            });
+  string text;
+  decode(data.data(), data.size(), &text);
+  return text;
+}
+
+int FlightRecorder::decode(const char* data, size_t len, string* text)
+{
+  DumpHeader header;
+  if (len < sizeof header || memcmp(data, kDumpMagic, sizeof kDumpMagic) != 0)
+  {
+    return -1;
+  }
+
+  struct Line
+  {
+    int64_t microSecondsSinceEpoch;
+    const char* data;  // or NULL if wrapped
+    size_t offset;     // in wrapped
+    size_t length;
+  };
+  std::vector<Line> lines;
+  string wrapped;  // lines across end of rings
+  size_t pos = sizeof header;
+  DumpedRing ring;
+  while (len - pos >= sizeof ring)
+  {
+    memcpy(&ring, data + pos, sizeof ring);
+    pos += sizeof ring;
+    if (ring.magic != kRingMagic || ring.capacity == 0
+        || (ring.capacity & (ring.capacity - 1)) != 0 || len - pos < ring.capacity)
+    {
+      break;
+    }
+    const char* ringData = data + pos;
+    pos += ring.capacity;
+    // being written while dumped, skips the overwritten
+    uint64_t tail = std::max(ring.tail, ring.head > ring.capacity ? ring.head - ring.capacity : 0);
+    while (ring.head - tail >= sizeof(Record))
+    {
+      Record record;
+      copyOut(ringData, ring.capacity, tail, &record, sizeof record);
+      if (record.length < sizeof record || record.length > ring.head - tail)
+      {
+        break;
+      }
+      Line line = { record.microSecondsSinceEpoch, NULL, 0, record.length - sizeof record };
+      size_t offset = static_cast<size_t>((tail + sizeof record) & (ring.capacity - 1));
+      if (offset + line.length <= ring.capacity)
+      {
+        line.data = ringData + offset;
+      }
+      else
+      {
+        line.offset = wrapped.size();
+        wrapped.resize(wrapped.size() + line.length);
+        copyOut(ringData, ring.capacity, tail + sizeof record, &wrapped[line.offset], line.length);
+      }
+      lines.push_back(line);
+      tail += record.length;
+    }
+  }
+
+  std::stable_sort(lines.begin(), lines.end(),
+                   [](const Line& lhs, const Line& rhs)
+                   { return lhs.microSecondsSinceEpoch < rhs.microSecondsSinceEpoch; });
+  for (const Line& line : lines)
+  {
+    text->append(line.data ? line.data : wrapped.data() + line.offset, line.length);
+  }
+  return static_cast<int>(lines.size());
+}
@@ -0,0 +1,59 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_FLIGHTRECORDER_H
+#define MUDUO_BASE_FLIGHTRECORDER_H
+
+#include "muduo/base/Logging.h"
+
+namespace muduo
+{
+
+///
+/// Keeps the last log lines of each thread in a ring of mmap(2)ed memory,
+/// for post-mortem analysis.  Lines of all levels at or above its own are
+/// recorded, including TRACE and DEBUG below Logger::logLevel(), which go
+/// nowhere else.  Recording is a memcpy(3), without locks or system calls.
+///
+/// Rings of all threads are dumped to a file on LOG_FATAL, on fatal
+/// signals if installSignalHandlers(), or by dump(), e.g. Inspector's
+/// /proc/flightrec/dump.  Dumps are decoded by flightrec_decode.
+///
+class FlightRecorder : noncopyable
+{
+ public:
+  /// Records lines of @c level and above, in a ring of @c bytesPerThread
+  /// of each thread, rounded up to a power of 2.  Crash dumps are written
+  /// to @c dumpFile.  Call once, before other threads start logging.
+  static void start(const string& dumpFile,
+                    Logger::LogLevel level = Logger::TRACE,
+                    size_t bytesPerThread = 1024*1024);
+  static bool started();
+
+  /// Dumps on SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT, then passes
+  /// the signal to the handler it replaced, or dies of it as usual.
+  /// Threads get a signal stack with their ring, so that a stack
+  /// overflow is dumped too, call after start(), before other threads.
+  static void installSignalHandlers();
+
+  /// Writes rings of all threads to @c filename, async-signal-safe.
+  static bool dump(const char* filename);
+  /// Writes to the dump file of start().
+  static bool dump();
+
+  /// Renders dumped rings as log lines of all threads, ordered by time,
+  /// returns number of lines, or -1 if not a dump.
+  static int decode(const char* data, size_t len, string* text);
+
+  /// Lines in rings of all threads now, as decode() of a dump.
+  static string snapshot();
+
+ private:
+  static void record(Logger::LogLevel level, Timestamp time, const char* msg, int len);
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_FLIGHTRECORDER_H
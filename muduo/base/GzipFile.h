@@ -57,6 +57,14 @@ class GzipFile : noncopyable
 
   // int flush(int f) { return ::gzflush(file_, f); }
 
+  // return Z_OK if buffered data are written and closed, closed even if not
+  int close()
+  {
+    int ret = ::gzclose(file_);
+    file_ = NULL;
+    return ret;
+  }
+
   static GzipFile openForRead(StringArg filename)
   {
     return GzipFile(::gzopen(filename.c_str(), "rbe"));
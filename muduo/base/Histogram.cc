@@ -0,0 +1,75 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/Histogram.h"
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+void Histogram::reset()
+{
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t Histogram::count() const
+{
+  int64_t total = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    total += bucketCount(i);
+  }
+  return total;
+}
+
+int64_t Histogram::percentile(double p) const
+{
+  int64_t counts[kNumBuckets];
+  int64_t total = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    counts[i] = bucketCount(i);
+    total += counts[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+  // rank of the sample, counting from 1
+  double rank = p / 100 * static_cast<double>(total);
+  int64_t seen = 0;
+  int last = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    if (counts[i] > 0)
+    {
+      seen += counts[i];
+      last = i;
+      if (static_cast<double>(seen) >= rank)
+      {
+        break;
+      }
+    }
+  }
+  return upperBound(last);
+}
+
+string Histogram::toString() const
+{
+  char buf[128];
+  snprintf(buf, sizeof buf,
+           "count %" PRId64 " p50 <=%" PRId64 " p90 <=%" PRId64
+           " p99 <=%" PRId64 " max <=%" PRId64,
+           count(), percentile(50), percentile(90), percentile(99), percentile(100));
+  return buf;
+}
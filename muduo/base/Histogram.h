@@ -0,0 +1,79 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_HISTOGRAM_H
+#define MUDUO_BASE_HISTOGRAM_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Counts of non-negative samples, eg. latencies in microseconds,
+/// in power-of-2 buckets.
+///
+/// Bucket 0 holds 0, bucket i holds [2^(i-1), 2^i), the last bucket
+/// holds the rest.  add() is lock free and may be called by many threads.
+///
+class Histogram : noncopyable
+{
+ public:
+  static const int kNumBuckets = 40;
+
+  Histogram()
+  {
+    reset();
+  }
+
+  void add(int64_t value)
+  {
+    buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Not atomic with respect to add().
+  void reset();
+
+  int64_t count() const;
+
+  int64_t bucketCount(int bucket) const
+  { return buckets_[bucket].load(std::memory_order_relaxed); }
+
+  /// Largest value of @c bucket.
+  static int64_t upperBound(int bucket)
+  {
+    return bucket >= kNumBuckets - 1 ? INT64_MAX
+                                     : (static_cast<int64_t>(1) << bucket) - 1;
+  }
+
+  static int bucketOf(int64_t value)
+  {
+    if (value <= 0)
+    {
+      return 0;
+    }
+    int bucket = 64 - __builtin_clzll(static_cast<unsigned long long>(value));
+    return bucket < kNumBuckets ? bucket : kNumBuckets - 1;
+  }
+
+  /// Upper bound of the bucket where the @c p-th percentile falls,
+  /// @c p in [0, 100].  Returns 0 if empty.
+  int64_t percentile(double p) const;
+
+  /// eg. "count 1000 p50 <=15 p90 <=63 p99 <=255 max <=1023"
+  string toString() const;
+
+ private:
+  std::atomic<int64_t> buckets_[kNumBuckets];
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_HISTOGRAM_H
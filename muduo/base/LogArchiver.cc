@@ -0,0 +1,216 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/LogArchiver.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/GzipFile.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Timestamp.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+namespace
+{
+
+const int kChunkSize = 256*1024;
+
+// see ioprio_set(2), glibc has no wrapper
+const int kIoprioClassIdle = 3;
+const int kIoprioClassShift = 13;
+const int kIoprioWhoProcess = 1;
+
+void lowerPriority()
+{
+  ::setpriority(PRIO_PROCESS, CurrentThread::tid(), 19);
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, CurrentThread::tid(),
+            kIoprioClassIdle << kIoprioClassShift);
+}
+
+bool endsWith(const string& str, const char* suffix)
+{
+  size_t len = strlen(suffix);
+  return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+}
+
+}  // namespace
+
+LogArchiver::LogArchiver(const string& basename)
+  : basename_(basename),
+    maxFiles_(0),
+    maxBytes_(0),
+    bytesPerSecond_(10*1000*1000),
+    running_(false),
+    thread_(std::bind(&LogArchiver::threadFunc, this), "LogArchiver"),
+    archivedFiles_(0),
+    throttledBytes_(0),
+    throttleStart_(0)
+{
+  assert(basename.find('/') == string::npos);
+}
+
+LogArchiver::~LogArchiver()
+{
+  if (running_)
+  {
+    stop();
+  }
+}
+
+void LogArchiver::start()
+{
+  assert(!running_);
+  running_ = true;
+  thread_.start();
+}
+
+void LogArchiver::stop()
+{
+  assert(running_);
+  running_ = false;
+  queue_.put(string());
+  thread_.join();
+}
+
+void LogArchiver::archive(const string& filename)
+{
+  if (!filename.empty())
+  {
+    queue_.put(filename);
+  }
+}
+
+void LogArchiver::threadFunc()
+{
+  lowerPriority();
+  string filename;
+  while (!(filename = queue_.take()).empty())
+  {
+    if (compress(filename))
+    {
+      archivedFiles_.fetch_add(1, std::memory_order_relaxed);
+    }
+    enforceRetention();
+  }
+}
+
+bool LogArchiver::compress(const string& filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    LOG_SYSERR << "LogArchiver open " << filename;
+    return false;
+  }
+  // renamed when complete, so a crash never leaves a truncated archive
+  string tmpname = filename + ".gz.tmp";
+  string gzname = filename + ".gz";
+  bool ok = true;
+  {
+    GzipFile gz = GzipFile::openForWriteTruncate(tmpname);
+    ok = gz.valid();
+    std::vector<char> buf(kChunkSize);
+    off_t offset = 0;
+    ssize_t n = 0;
+    while (ok && (n = ::read(fd, buf.data(), buf.size())) > 0)
+    {
+      ok = gz.write(StringPiece(buf.data(), static_cast<int>(n))) == n;
+      // leaves page cache to the active log file
+      ::posix_fadvise(fd, offset, n, POSIX_FADV_DONTNEED);
+      offset += n;
+      throttle(n);
+    }
+    ok = ok && n == 0;
+    // writes the rest and the trailer, may fail of ENOSPC
+    ok = gz.valid() && gz.close() == Z_OK && ok;
+  }
+  ::close(fd);
+
+  if (ok && ::rename(tmpname.c_str(), gzname.c_str()) == 0)
+  {
+    ::unlink(filename.c_str());
+    return true;
+  }
+  LOG_ERROR << "LogArchiver failed to compress " << filename;
+  ::unlink(tmpname.c_str());
+  return false;
+}
+
+void LogArchiver::throttle(int64_t bytes)
+{
+  if (bytesPerSecond_ <= 0)
+  {
+    return;
+  }
+  int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  // restarts after idle, no burst for the time not spent
+  if (throttledBytes_ == 0 || now - throttleStart_ > Timestamp::kMicroSecondsPerSecond)
+  {
+    throttleStart_ = now;
+    throttledBytes_ = 0;
+  }
+  throttledBytes_ += bytes;
+  int64_t due = throttleStart_ + throttledBytes_ * Timestamp::kMicroSecondsPerSecond / bytesPerSecond_;
+  if (due > now)
+  {
+    ::usleep(static_cast<useconds_t>(due - now));
+  }
+}
+
+void LogArchiver::enforceRetention()
+{
+  if (maxFiles_ <= 0 && maxBytes_ <= 0)
+  {
+    return;
+  }
+  std::vector<std::pair<string, int64_t>> archives;
+  DIR* dir = ::opendir(".");
+  if (dir == NULL)
+  {
+    return;
+  }
+  string prefix = basename_ + ".";
+  struct dirent* entry = NULL;
+  while ((entry = ::readdir(dir)) != NULL)
+  {
+    string name = entry->d_name;
+    struct stat statbuf;
+    if (name.compare(0, prefix.size(), prefix) == 0 && endsWith(name, ".log.gz")
+        && ::stat(name.c_str(), &statbuf) == 0 && S_ISREG(statbuf.st_mode))
+    {
+      archives.push_back(std::make_pair(name, static_cast<int64_t>(statbuf.st_size)));
+    }
+  }
+  ::closedir(dir);
+
+  // file names start with time of creation, newest first
+  std::sort(archives.begin(), archives.end(),
+            [](const std::pair<string, int64_t>& lhs, const std::pair<string, int64_t>& rhs)
+            { return lhs.first > rhs.first; });
+  int64_t totalBytes = 0;
+  for (size_t i = 0; i < archives.size(); ++i)
+  {
+    totalBytes += archives[i].second;
+    bool tooMany = maxFiles_ > 0 && i >= static_cast<size_t>(maxFiles_);
+    bool tooLarge = maxBytes_ > 0 && totalBytes > maxBytes_ && i > 0;
+    if (tooMany || tooLarge)
+    {
+      ::unlink(archives[i].first.c_str());
+    }
+  }
+}
@@ -0,0 +1,71 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_LOGARCHIVER_H
+#define MUDUO_BASE_LOGARCHIVER_H
+
+#include "muduo/base/BlockingQueue.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+
+namespace muduo
+{
+
+///
+/// Compresses rolled log files to .gz with GzipFile in a background
+/// thread, and removes the oldest archives beyond retention.
+///
+/// The thread runs at idle I/O priority and lowest CPU priority, and reads
+/// at most setRateLimit() bytes per second, so it does not compete with
+/// the active log writer.  Pass archive() to LogFile::setRollCallback().
+/// Link with muduo_logarchiver and zlib.
+///
+class LogArchiver : noncopyable
+{
+ public:
+  /// Archives of @c basename of LogFile, in current directory.
+  explicit LogArchiver(const string& basename);
+  ~LogArchiver();
+
+  // Must be called before start().
+  /// Archives kept at most, 0 for unlimited, the default.
+  void setMaxFiles(int maxFiles) { maxFiles_ = maxFiles; }
+  /// Total bytes of archives kept at most, 0 for unlimited, the default.
+  void setMaxBytes(int64_t maxBytes) { maxBytes_ = maxBytes; }
+  /// Bytes of log files read per second, default 10MB.
+  void setRateLimit(int64_t bytesPerSecond) { bytesPerSecond_ = bytesPerSecond; }
+
+  void start();
+  /// Waits for files already passed to archive().
+  void stop();
+
+  /// Compresses @c filename to filename.gz and removes it, thread safe.
+  void archive(const string& filename);
+
+  int64_t archivedFiles() const { return archivedFiles_.load(std::memory_order_relaxed); }
+
+ private:
+  void threadFunc();
+  bool compress(const string& filename);
+  void enforceRetention();
+  void throttle(int64_t bytes);
+
+  const string basename_;
+  int maxFiles_;
+  int64_t maxBytes_;
+  int64_t bytesPerSecond_;
+  bool running_;
+  BlockingQueue<string> queue_;  // empty string to stop
+  Thread thread_;
+  std::atomic<int64_t> archivedFiles_;
+  int64_t throttledBytes_;
+  int64_t throttleStart_;  // microseconds
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_LOGARCHIVER_H
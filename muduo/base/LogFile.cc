@@ -8,6 +8,8 @@
 #include "muduo/base/FileUtil.h"
 #include "muduo/base/ProcessInfo.h"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <stdio.h>
 #include <time.h>
@@ -18,11 +20,15 @@ LogFile::LogFile(const string& basename,
                  off_t rollSize,
                  bool threadSafe,
                  int flushInterval,
-                 int checkEveryN)
+                 int checkEveryN,
+                 bool unbuffered,
+                 bool mapped)
   : basename_(basename),
     rollSize_(rollSize),
     flushInterval_(flushInterval),
     checkEveryN_(checkEveryN),
+    unbuffered_(unbuffered),
+    mapped_(mapped),
     count_(0),
     mutex_(threadSafe ? new MutexLock : NULL),
     startOfPeriod_(0),
@@ -48,12 +54,52 @@ void LogFile::append(const char* logline, int len)
   }
 }
 
+void LogFile::appendv(const struct iovec* iov, int iovcnt)
+{
+  if (mutex_)
+  {
+    MutexLockGuard lock(*mutex_);
+    appendv_unlocked(iov, iovcnt);
+  }
+  else
+  {
+    appendv_unlocked(iov, iovcnt);
+  }
+}
+
 void LogFile::flush()
 {
+  time_t now = unbuffered_ || mapped_ ? ::time(NULL) : 0;
   if (mutex_)
   {
     MutexLockGuard lock(*mutex_);
-    file_->flush();
+    flush_unlocked(now);
+  }
+  else
+  {
+    flush_unlocked(now);
+  }
+}
+
+void LogFile::flush_unlocked(time_t now)
+{
+  // fdatasync and write-back are expensive, flush interval applies
+  bool throttled = unbuffered_ || mapped_;
+  if (!throttled || now - lastFlush_ >= flushInterval_)
+  {
+    if (throttled)
+    {
+      lastFlush_ = now;
+    }
+    flushFile();
+  }
+}
+
+void LogFile::flushFile()
+{
+  if (mappedFile_)
+  {
+    mappedFile_->flush();
   }
   else
   {
@@ -61,17 +107,46 @@ void LogFile::flush()
   }
 }
 
+off_t LogFile::writtenBytes() const
+{
+  return mappedFile_ ? mappedFile_->writtenBytes() : file_->writtenBytes();
+}
+
 void LogFile::append_unlocked(const char* logline, int len)
 {
-  file_->append(logline, len);
+  if (mappedFile_)
+  {
+    mappedFile_->append(logline, len);
+  }
+  else
+  {
+    file_->append(logline, len);
+  }
+  checkRollOrFlush(1);
+}
+
+void LogFile::appendv_unlocked(const struct iovec* iov, int iovcnt)
+{
+  if (mappedFile_)
+  {
+    mappedFile_->appendv(iov, iovcnt);
+  }
+  else
+  {
+    file_->appendv(iov, iovcnt);
+  }
+  checkRollOrFlush(iovcnt);
+}
 
-  if (file_->writtenBytes() > rollSize_)
+void LogFile::checkRollOrFlush(int count)
+{
+  if (writtenBytes() > rollSize_)
   {
     rollFile();
   }
   else
   {
-    ++count_;
+    count_ += count;
     if (count_ >= checkEveryN_)
     {
       count_ = 0;
@@ -84,7 +159,7 @@ void LogFile::append_unlocked(const char* logline, int len)
       else if (now - lastFlush_ > flushInterval_)
       {
         lastFlush_ = now;
-        file_->flush();
+        flushFile();
       }
     }
   }
@@ -101,7 +176,31 @@ bool LogFile::rollFile()
     lastRoll_ = now;
     lastFlush_ = now;
     startOfPeriod_ = start;
-    file_.reset(new FileUtil::AppendFile(filename));
+    if (mapped_)
+    {
+      // truncates the last file before opening the next
+      mappedFile_.reset();
+      off_t segmentBytes = kSegmentBytes_;
+      mappedFile_.reset(new FileUtil::MappedAppendFile(filename,
+                                                       std::min(rollSize_, segmentBytes)));
+    }
+    else if (unbuffered_)
+    {
+      off_t preallocateBytes = kPreallocateBytes_;
+      file_.reset(new FileUtil::AppendFile(filename, true,
+                                           std::min(rollSize_, preallocateBytes)));
+    }
+    else
+    {
+      file_.reset(new FileUtil::AppendFile(filename));
+    }
+    string closed;
+    closed.swap(filename_);
+    filename_ = filename;
+    if (rollCallback_ && !closed.empty())
+    {
+      rollCallback_(closed);
+    }
     return true;
   }
   return false;
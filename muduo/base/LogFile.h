@@ -9,32 +9,55 @@
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Types.h"
 
+#include <functional>
 #include <memory>
 
+struct iovec;
+
 namespace muduo
 {
 
 namespace FileUtil
 {
 class AppendFile;
+class MappedAppendFile;
 }
 
 class LogFile : noncopyable
 {
  public:
+  /// If @c unbuffered, see FileUtil::AppendFile, flush() calls fdatasync(2)
+  /// at most once every @c flushInterval seconds.
+  /// If @c mapped, see FileUtil::MappedAppendFile, appends are memcpy(3)
+  /// and flush() starts write-back at most once every @c flushInterval.
   LogFile(const string& basename,
           off_t rollSize,
           bool threadSafe = true,
           int flushInterval = 3,
-          int checkEveryN = 1024);
+          int checkEveryN = 1024,
+          bool unbuffered = false,
+          bool mapped = false);
   ~LogFile();
 
   void append(const char* logline, int len);
+  /// Appends all of @c iov, with one writev(2) if unbuffered.
+  void appendv(const struct iovec* iov, int iovcnt);
   void flush();
   bool rollFile();
 
+  typedef std::function<void (const string& filename)> RollCallback;
+  /// Called with name of the file closed by rollFile(), e.g. to archive it,
+  /// in the thread of append(), with lock held if thread safe.
+  void setRollCallback(const RollCallback& cb)
+  { rollCallback_ = cb; }
+
  private:
   void append_unlocked(const char* logline, int len);
+  void appendv_unlocked(const struct iovec* iov, int iovcnt);
+  void checkRollOrFlush(int count);
+  void flush_unlocked(time_t now);
+  void flushFile();
+  off_t writtenBytes() const;
 
   static string getLogFileName(const string& basename, time_t* now);
 
@@ -42,6 +65,8 @@ class LogFile : noncopyable
   const off_t rollSize_;
   const int flushInterval_;
   const int checkEveryN_;
+  const bool unbuffered_;
+  const bool mapped_;
 
   int count_;
 
@@ -50,8 +75,13 @@ class LogFile : noncopyable
   time_t lastRoll_;
   time_t lastFlush_;
   std::unique_ptr<FileUtil::AppendFile> file_;
+  std::unique_ptr<FileUtil::MappedAppendFile> mappedFile_;  // if mapped
+  string filename_;
+  RollCallback rollCallback_;
 
   const static int kRollPerSeconds_ = 60*60*24;
+  const static off_t kPreallocateBytes_ = 64*1024*1024;
+  const static off_t kSegmentBytes_ = 64*1024*1024;
 };
 
 }  // namespace muduo
@@ -5,10 +5,13 @@
 
 #include "muduo/base/LogStream.h"
 
+#include "muduo/base/DoubleFormat.h"
+
 #include <algorithm>
 #include <limits>
 #include <type_traits>
 #include <assert.h>
+#include <ctype.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -305,26 +308,81 @@ LogStream& LogStream::operator<<(const void* p)
   return *this;
 }
 
-// FIXME: replace this with Grisu3 by Florian Loitsch.
 LogStream& LogStream::operator<<(double v)
 {
   if (buffer_.avail() >= kMaxNumericSize)
   {
-    int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
+    int len = formatShortest(buffer_.current(), v);
     buffer_.add(len);
   }
   return *this;
 }
 
+namespace
+{
+
+// "%f", "%.3f" or "%.12f"
+bool isFixedFormat(const char* fmt, int* precision)
+{
+  if (fmt[0] != '%')
+  {
+    return false;
+  }
+  if (fmt[1] == 'f' && fmt[2] == '\0')
+  {
+    *precision = 6;
+    return true;
+  }
+  if (fmt[1] != '.' || !isdigit(fmt[2]))
+  {
+    return false;
+  }
+  int n = fmt[2] - '0';
+  const char* p = fmt + 3;
+  if (isdigit(*p))
+  {
+    n = n * 10 + *p++ - '0';
+  }
+  if (p[0] != 'f' || p[1] != '\0')
+  {
+    return false;
+  }
+  *precision = n;
+  return true;
+}
+
+}  // namespace
+
 template<typename T>
 Fmt::Fmt(const char* fmt, T val)
 {
   static_assert(std::is_arithmetic<T>::value == true, "Must be arithmetic type");
 
+  int precision = 0;
+  if (std::is_floating_point<T>::value && isFixedFormat(fmt, &precision))
+  {
+    length_ = formatFixed(buf_, sizeof buf_, static_cast<double>(val), precision);
+    if (length_ >= 0)
+    {
+      return;
+    }
+  }
   length_ = snprintf(buf_, sizeof buf_, fmt, val);
   assert(static_cast<size_t>(length_) < sizeof buf_);
 }
 
+Fmt Fmt::fixed(double val, int precision)
+{
+  Fmt result;
+  result.length_ = formatFixed(result.buf_, sizeof result.buf_, val, precision);
+  if (result.length_ < 0)
+  {
+    result.length_ = snprintf(result.buf_, sizeof result.buf_, "%.*f", precision, val);
+    result.length_ = std::min(result.length_, static_cast<int>(sizeof result.buf_) - 1);
+  }
+  return result;
+}
+
 // Explicit instantiations
 
 template Fmt::Fmt(const char* fmt, char);
@@ -105,6 +105,7 @@ class LogStream : noncopyable
     *this << static_cast<double>(v);
     return *this;
   }
+  /// Shortest digits that read back to @c v, see detail::formatShortest().
   self& operator<<(double);
   // self& operator<<(long double);
 
@@ -171,13 +172,20 @@ class LogStream : noncopyable
 class Fmt // : noncopyable
 {
  public:
+  /// "%f" and "%.Nf" of floating points are done without snprintf(3),
+  /// unless out of range of detail::formatFixed().
   template<typename T>
   Fmt(const char* fmt, T val);
 
+  /// Same as Fmt("%.*f", precision, val), truncated if too long.
+  static Fmt fixed(double val, int precision);
+
   const char* data() const { return buf_; }
   int length() const { return length_; }
 
  private:
+  Fmt() : length_(0) {}
+
   char buf_[32];
   int length_;
 };
@@ -6,6 +6,7 @@
 #include "muduo/base/Logging.h"
 
 #include "muduo/base/CurrentThread.h"
+#include "muduo/base/Mutex.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/base/TimeZone.h"
 
@@ -13,6 +14,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <limits>
 #include <sstream>
 
 namespace muduo
@@ -39,6 +42,20 @@ __thread char t_errnobuf[512];
 __thread char t_time[64];
 __thread time_t t_lastSecond;
 
+// Offset window of g_logTimeZone and day of t_time, so that a new second
+// costs an addition and a comparison, and rewrites only "HH:MM:SS".
+struct LocalTimeCache
+{
+  int generation;  // of g_logTimeZone, 0 for none
+  bool local;      // g_logTimeZone is valid
+  time_t start;
+  time_t end;
+  int gmtOffset;
+  time_t day;      // local days since epoch written in t_time
+};
+
+__thread LocalTimeCache t_localTime;
+
 const char* strerror_tl(int savedErrno)
 {
   return strerror_r(savedErrno, t_errnobuf, sizeof t_errnobuf);
@@ -55,6 +72,7 @@ Logger::LogLevel initLogLevel()
 }
 
 Logger::LogLevel g_logLevel = initLogLevel();
+Logger::LogLevel g_logMinLevel = g_logLevel;
 
 const char* LogLevelName[Logger::NUM_LOG_LEVELS] =
 {
@@ -107,54 +125,183 @@ void defaultFlush()
 
 Logger::OutputFunc g_output = defaultOutput;
 Logger::FlushFunc g_flush = defaultFlush;
-TimeZone g_logTimeZone;
+Logger::RecordFunc g_record = NULL;
+Logger::LogLevel g_recordLevel = Logger::NUM_LOG_LEVELS;
+// Threads copy the window they need under the lock, on a miss of their
+// LocalTimeCache, the generation tells them setTimeZone() was called.
+MutexLock g_logTimeZoneMutex;
+TimeZone g_logTimeZone GUARDED_BY(g_logTimeZoneMutex);
+std::atomic<int> g_logTimeZoneGeneration(1);
+bool g_logCachedClock = false;
+
+// GCRA, a token bucket of one atomic, in microseconds
+struct LogRateLimit
+{
+  std::atomic<int64_t> interval;   // per message, 0 for unlimited
+  std::atomic<int64_t> tolerance;  // interval * burst
+  std::atomic<int64_t> arrival;    // theoretical arrival time of next message
+  std::atomic<int64_t> pending;    // dropped, not reported yet
+  std::atomic<int64_t> total;      // dropped
+};
+
+LogRateLimit g_logRateLimits[Logger::NUM_LOG_LEVELS];
+std::atomic<bool> g_logRateLimited[Logger::NUM_LOG_LEVELS];
+
+// Returns false if over the limit, or sets number dropped since last admitted.
+bool admitLog(Logger::LogLevel level, int64_t now, int64_t* dropped)
+{
+  LogRateLimit& limit = g_logRateLimits[level];
+  int64_t interval = limit.interval.load(std::memory_order_relaxed);
+  if (interval == 0 || level == Logger::FATAL)
+  {
+    return true;
+  }
+  int64_t tolerance = limit.tolerance.load(std::memory_order_relaxed);
+  int64_t arrival = limit.arrival.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    int64_t next = std::max(arrival, now) + interval;
+    if (next - now > tolerance)
+    {
+      limit.pending.fetch_add(1, std::memory_order_relaxed);
+      limit.total.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (limit.arrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed))
+    {
+      break;
+    }
+  }
+  if (limit.pending.load(std::memory_order_relaxed) > 0)
+  {
+    *dropped = limit.pending.exchange(0, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+namespace detail
+{
+
+LogAdmission admitLimitedLog(Logger::LogLevel level)
+{
+  int savedErrno = errno;
+  Timestamp now(g_logCachedClock ? Timestamp::cachedNow() : Timestamp::now());
+  int64_t dropped = 0;
+  bool admitted = muduo::admitLog(level, now.microSecondsSinceEpoch(), &dropped);
+  errno = savedErrno;
+  return LogAdmission(admitted, dropped);
+}
+
+}  // namespace detail
 
 }  // namespace muduo
 
 using namespace muduo;
 
-Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int line)
-  : time_(Timestamp::now()),
+Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int line,
+                   const detail::LogAdmission* admission)
+  : time_(g_logCachedClock ? Timestamp::cachedNow() : Timestamp::now()),
     stream_(),
     level_(level),
     line_(line),
-    basename_(file)
+    basename_(file),
+    suppressed_(false)
 {
+  int64_t dropped = 0;
+  if (admission)
+  {
+    dropped = admission->dropped();
+  }
+  else if (!admitLog(level, time_.microSecondsSinceEpoch(), &dropped))
+  {
+    suppressed_ = true;
+    return;
+  }
   formatTime();
   CurrentThread::tid();
   stream_ << T(CurrentThread::tidString(), CurrentThread::tidStringLength());
   stream_ << T(LogLevelName[level], 6);
+  stream_ << detail::Suppressed(dropped);
   if (savedErrno != 0)
   {
     stream_ << strerror_tl(savedErrno) << " (errno=" << savedErrno << ") ";
   }
 }
 
-void Logger::Impl::formatTime()
+namespace
 {
-  int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
-  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
-  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
-  if (seconds != t_lastSecond)
+
+const int kSecondsPerDay = 24*60*60;
+
+// two digits of 0 ~ 99
+inline void formatTwoDigits(char* buf, int n)
+{
+  buf[0] = static_cast<char>('0' + n / 10);
+  buf[1] = static_cast<char>('0' + n % 10);
+}
+
+// "YYYYMMDD HH:MM:SS" into t_time
+void formatSeconds(time_t seconds)
+{
+  LocalTimeCache& cache = t_localTime;
+  if (cache.generation != g_logTimeZoneGeneration.load(std::memory_order_relaxed)
+      || seconds < cache.start || seconds >= cache.end)
   {
-    t_lastSecond = seconds;
-    struct tm tm_time;
-    if (g_logTimeZone.valid())
+    MutexLockGuard lock(g_logTimeZoneMutex);
+    cache.local = g_logTimeZone.valid();
+    if (cache.local)
     {
-      tm_time = g_logTimeZone.toLocalTime(seconds);
+      TimeZone::Window window = g_logTimeZone.windowOf(seconds);
+      cache.start = window.start;
+      cache.end = window.end;
+      cache.gmtOffset = window.gmtOffset;
     }
     else
     {
-      ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
+      cache.start = std::numeric_limits<time_t>::min();
+      cache.end = std::numeric_limits<time_t>::max();
+      cache.gmtOffset = 0;
     }
+    cache.generation = g_logTimeZoneGeneration.load(std::memory_order_relaxed);
+    cache.day = std::numeric_limits<time_t>::min();
+  }
 
-    int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
-        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+  time_t local = seconds + cache.gmtOffset;
+  time_t day = local / kSecondsPerDay;
+  int secondsOfDay = static_cast<int>(local % kSecondsPerDay);
+  if (secondsOfDay < 0)
+  {
+    secondsOfDay += kSecondsPerDay;
+    --day;
+  }
+  if (day != cache.day)
+  {
+    cache.day = day;
+    struct tm tm_time = TimeZone::toUtcTime(day * kSecondsPerDay);
+    int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d 00:00:00",
+        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday);
     assert(len == 17); (void)len;
   }
+  formatTwoDigits(t_time + 9, secondsOfDay / 3600);
+  formatTwoDigits(t_time + 12, secondsOfDay / 60 % 60);
+  formatTwoDigits(t_time + 15, secondsOfDay % 60);
+}
+
+}  // namespace
+
+void Logger::Impl::formatTime()
+{
+  int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
+  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+  if (seconds != t_lastSecond
+      || t_localTime.generation != g_logTimeZoneGeneration.load(std::memory_order_relaxed))
+  {
+    t_lastSecond = seconds;
+    formatSeconds(seconds);
+  }
 
-  if (g_logTimeZone.valid())
+  if (t_localTime.local)
   {
     Fmt us(".%06d ", microseconds);
     assert(us.length() == 8);
@@ -194,11 +341,38 @@ Logger::Logger(SourceFile file, int line, bool toAbort)
 {
 }
 
+Logger::Logger(SourceFile file, int line, LogLevel level, const char* func,
+               detail::LogAdmission admission)
+  : impl_(level, 0, file, line, &admission)
+{
+  if (func)
+  {
+    impl_.stream_ << func << ' ';
+  }
+}
+
+Logger::Logger(SourceFile file, int line, bool toAbort, detail::LogAdmission admission)
+  : impl_(toAbort?FATAL:ERROR, errno, file, line, &admission)
+{
+}
+
 Logger::~Logger()
 {
+  if (impl_.suppressed_)
+  {
+    return;
+  }
   impl_.finish();
   const LogStream::Buffer& buf(stream().buffer());
-  g_output(buf.data(), buf.length());
+  if (impl_.level_ >= g_recordLevel)
+  {
+    g_record(impl_.level_, impl_.time_, buf.data(), buf.length());
+  }
+  // below logLevel() for recorder only, LOG_WARN and above are unconditional
+  if (impl_.level_ >= std::min(g_logLevel, WARN))
+  {
+    g_output(buf.data(), buf.length());
+  }
   if (impl_.level_ == FATAL)
   {
     g_flush();
@@ -209,6 +383,7 @@ Logger::~Logger()
 void Logger::setLogLevel(Logger::LogLevel level)
 {
   g_logLevel = level;
+  g_logMinLevel = std::min(g_logLevel, g_recordLevel);
 }
 
 void Logger::setOutput(OutputFunc out)
@@ -221,7 +396,51 @@ void Logger::setFlush(FlushFunc flush)
   g_flush = flush;
 }
 
+void Logger::setRecorder(RecordFunc record, LogLevel level)
+{
+  g_record = record;
+  g_recordLevel = record ? level : NUM_LOG_LEVELS;
+  g_logMinLevel = std::min(g_logLevel, g_recordLevel);
+}
+
 void Logger::setTimeZone(const TimeZone& tz)
 {
+  MutexLockGuard lock(g_logTimeZoneMutex);
   g_logTimeZone = tz;
+  g_logTimeZoneGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::setCachedClock(bool on)
+{
+  g_logCachedClock = on;
+}
+
+void Logger::setRateLimit(LogLevel level, int messagesPerSecond, int burst)
+{
+  LogRateLimit& limit = g_logRateLimits[level];
+  int64_t interval = messagesPerSecond > 0
+      ? std::max<int64_t>(Timestamp::kMicroSecondsPerSecond / messagesPerSecond, 1) : 0;
+  limit.tolerance.store(interval * std::max(burst, 1), std::memory_order_relaxed);
+  limit.arrival.store(0, std::memory_order_relaxed);
+  limit.interval.store(interval, std::memory_order_relaxed);
+  g_logRateLimited[level].store(interval > 0, std::memory_order_relaxed);
+}
+
+int64_t Logger::suppressedMessages(LogLevel level)
+{
+  return g_logRateLimits[level].total.load(std::memory_order_relaxed);
+}
+
+int64_t detail::LogSiteState::everyT(double seconds)
+{
+  int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  int64_t next = next_.load(std::memory_order_relaxed);
+  if (now < next || !next_.compare_exchange_strong(
+        next, now + static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond),
+        std::memory_order_relaxed))
+  {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    return -1;
+  }
+  return count_.exchange(0, std::memory_order_relaxed);
 }
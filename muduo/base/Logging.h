@@ -9,11 +9,47 @@
 #include "muduo/base/LogStream.h"
 #include "muduo/base/Timestamp.h"
 
+#include <atomic>
+#include <type_traits>
+
+#include <assert.h>
+
 namespace muduo
 {
 
 class TimeZone;
 
+namespace detail
+{
+
+// Result of rate limit of a LOG_* statement, tested in its condition,
+// so that operands of a dropped line are never evaluated.
+class LogAdmission
+{
+ public:
+  LogAdmission()
+    : admitted_(false),
+      dropped_(0)
+  {
+  }
+
+  LogAdmission(bool admitted, int64_t dropped)
+    : admitted_(admitted),
+      dropped_(dropped)
+  {
+  }
+
+  explicit operator bool() const { return admitted_; }
+  // since last admitted line of same level
+  int64_t dropped() const { return dropped_; }
+
+ private:
+  bool admitted_;
+  int64_t dropped_;
+};
+
+}  // namespace detail
+
 class Logger
 {
  public:
@@ -33,16 +69,18 @@ class Logger
   {
    public:
     template<int N>
-    SourceFile(const char (&arr)[N])
-      : data_(arr),
-        size_(N-1)
+    constexpr SourceFile(const char (&arr)[N])
+      : data_(arr + basenameOffset(arr)),
+        size_(N - 1 - basenameOffset(arr))
+    {
+    }
+
+    /// @c offset is basenameOffset(arr), see MUDUO_SOURCE_FILE.
+    template<int N>
+    constexpr SourceFile(const char (&arr)[N], int offset)
+      : data_(arr + offset),
+        size_(N - 1 - offset)
     {
-      const char* slash = strrchr(data_, '/'); // builtin function
-      if (slash)
-      {
-        data_ = slash + 1;
-        size_ -= static_cast<int>(data_ - arr);
-      }
     }
 
     explicit SourceFile(const char* filename)
@@ -56,26 +94,69 @@ class Logger
       size_ = static_cast<int>(strlen(data_));
     }
 
+    template<int N>
+    static constexpr int basenameOffset(const char (&path)[N])
+    {
+      return N > 1 ? slashEnd(path, 0, N - 1) : 0;
+    }
+
     const char* data_;
     int size_;
+
+   private:
+    static constexpr int max(int a, int b) { return a > b ? a : b; }
+
+    // 1 + index of last '/' in path[begin, end), 0 if none, of depth log(N)
+    static constexpr int slashEnd(const char* path, int begin, int end)
+    {
+      return end - begin == 1 ? (path[begin] == '/' ? begin + 1 : 0)
+          : max(slashEnd(path, begin, (begin + end) / 2),
+                slashEnd(path, (begin + end) / 2, end));
+    }
   };
 
   Logger(SourceFile file, int line);
   Logger(SourceFile file, int line, LogLevel level);
   Logger(SourceFile file, int line, LogLevel level, const char* func);
   Logger(SourceFile file, int line, bool toAbort);
+  /// Admitted by rate limit already, see detail::admitLog().
+  /// @c func may be NULL.
+  Logger(SourceFile file, int line, LogLevel level, const char* func,
+         detail::LogAdmission admission);
+  Logger(SourceFile file, int line, bool toAbort, detail::LogAdmission admission);
   ~Logger();
 
   LogStream& stream() { return impl_.stream_; }
 
   static LogLevel logLevel();
   static void setLogLevel(LogLevel level);
+  /// Lowest level of lines formatted, for output or recorder.
+  static LogLevel minLogLevel();
 
   typedef void (*OutputFunc)(const char* msg, int len);
   typedef void (*FlushFunc)();
+  typedef void (*RecordFunc)(LogLevel level, Timestamp time, const char* msg, int len);
   static void setOutput(OutputFunc);
   static void setFlush(FlushFunc);
+  /// Also passes lines of @c level and above to @c record, even if below
+  /// logLevel(), those go to @c record only.  See FlightRecorder.
+  static void setRecorder(RecordFunc record, LogLevel level);
+  /// Thread safe, other threads stamp their next line with @c tz.
   static void setTimeZone(const TimeZone& tz);
+  /// Stamps log lines with Timestamp::cachedNow() instead of now(),
+  /// which is cheaper but lags behind in EventLoop threads.
+  static void setCachedClock(bool on);
+  /// Token bucket of each level, at most @c messagesPerSecond in bursts of
+  /// @c burst, others are dropped and counted, and the next line of the
+  /// level tells how many.  0 for unlimited, the default.
+  /// FATAL is never limited.
+  /// LOG_TRACE to LOG_ERROR and LOG_SYSERR check it in their condition,
+  /// a dropped line doesn't evaluate its operands.  LOG_EVERY_N and
+  /// friends check it when constructing Logger, a dropped line evaluates
+  /// its operands, but formats no time and writes no output.
+  static void setRateLimit(LogLevel level, int messagesPerSecond, int burst);
+  /// Dropped by rate limit of @c level in total.
+  static int64_t suppressedMessages(LogLevel level);
 
  private:
 
@@ -83,7 +164,8 @@ class Impl
 {
  public:
   typedef Logger::LogLevel LogLevel;
-  Impl(LogLevel level, int old_errno, const SourceFile& file, int line);
+  Impl(LogLevel level, int old_errno, const SourceFile& file, int line,
+       const detail::LogAdmission* admission = NULL);
   void formatTime();
   void finish();
 
@@ -92,6 +174,7 @@ class Impl
   LogLevel level_;
   int line_;
   SourceFile basename_;
+  bool suppressed_;  // by rate limit
 };
 
   Impl impl_;
@@ -99,39 +182,162 @@ class Impl
 };
 
 extern Logger::LogLevel g_logLevel;
+extern Logger::LogLevel g_logMinLevel;
+extern std::atomic<bool> g_logRateLimited[Logger::NUM_LOG_LEVELS];
+
+namespace detail
+{
+
+// State of a LOG_EVERY_N, LOG_FIRST_N or LOG_EVERY_T statement,
+// static, initialized at compile time.
+class LogSiteState : noncopyable
+{
+ public:
+  constexpr LogSiteState()
+    : count_(0),
+      next_(0)
+  {
+  }
+
+  // true for 1st, (n+1)th, (2n+1)th, ... calls
+  bool everyN(int64_t n)
+  {
+    assert(n > 0);
+    return count_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+  }
+
+  // true for first n calls
+  bool firstN(int64_t n)
+  {
+    return count_.load(std::memory_order_relaxed) < n
+        && count_.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+  // -1 if less than @c seconds since the last logged call,
+  // otherwise the number of calls not logged since then.
+  int64_t everyT(double seconds);
+
+ private:
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> next_;  // in microseconds since epoch
+};
+
+// Rate limit of @c level, preserves errno for LOG_SYSERR.
+LogAdmission admitLimitedLog(Logger::LogLevel level);
+
+// a load and a branch if unlimited
+inline LogAdmission admitLog(Logger::LogLevel level)
+{
+  return g_logRateLimited[level].load(std::memory_order_relaxed)
+      ? admitLimitedLog(level) : LogAdmission(true, 0);
+}
+
+struct Suppressed
+{
+  explicit Suppressed(int64_t n) : count(n) {}
+  int64_t count;
+};
+
+inline LogStream& operator<<(LogStream& s, Suppressed v)
+{
+  if (v.count > 0)
+  {
+    s << "[suppressed " << v.count << "] ";
+  }
+  return s;
+}
+
+}  // namespace detail
 
 inline Logger::LogLevel Logger::logLevel()
 {
   return g_logLevel;
 }
 
+inline Logger::LogLevel Logger::minLogLevel()
+{
+  return g_logMinLevel;
+}
+
 //
-// CAUTION: do not write:
+// LOG_xxx are for statements, not if statements, so
 //
 // if (good)
 //   LOG_INFO << "Good news";
 // else
 //   LOG_WARN << "Bad news";
 //
-// this expends to
+// is fine, it expands to
 //
 // if (good)
-//   if (logging_INFO)
+//   for (admission = logging_INFO; admission; admission = false)
 //     logInfoStream << "Good news";
-//   else
+// else
+//   for (admission = logging_WARN; admission; admission = false)
 //     logWarnStream << "Bad news";
 //
-#define LOG_TRACE if (muduo::Logger::logLevel() <= muduo::Logger::TRACE) \
-  muduo::Logger(__FILE__, __LINE__, muduo::Logger::TRACE, __func__).stream()
-#define LOG_DEBUG if (muduo::Logger::logLevel() <= muduo::Logger::DEBUG) \
-  muduo::Logger(__FILE__, __LINE__, muduo::Logger::DEBUG, __func__).stream()
-#define LOG_INFO if (muduo::Logger::logLevel() <= muduo::Logger::INFO) \
-  muduo::Logger(__FILE__, __LINE__).stream()
-#define LOG_WARN muduo::Logger(__FILE__, __LINE__, muduo::Logger::WARN).stream()
-#define LOG_ERROR muduo::Logger(__FILE__, __LINE__, muduo::Logger::ERROR).stream()
-#define LOG_FATAL muduo::Logger(__FILE__, __LINE__, muduo::Logger::FATAL).stream()
-#define LOG_SYSERR muduo::Logger(__FILE__, __LINE__, false).stream()
-#define LOG_SYSFATAL muduo::Logger(__FILE__, __LINE__, true).stream()
+// Basename of __FILE__, computed at compile time.
+#define MUDUO_SOURCE_FILE muduo::Logger::SourceFile(__FILE__, \
+  std::integral_constant<int, muduo::Logger::SourceFile::basenameOffset(__FILE__)>::value)
+
+// Statements below MUDUO_MIN_LOG_LEVEL are dead code, removed by compiler,
+// and their operands are never evaluated.  Build release binaries of hot
+// services with -DMUDUO_MIN_LOG_LEVEL=2 to drop LOG_TRACE and LOG_DEBUG,
+// 0 for TRACE, 1 for DEBUG, 2 for INFO, 3 for WARN, 4 for ERROR.
+#ifndef MUDUO_MIN_LOG_LEVEL
+#define MUDUO_MIN_LOG_LEVEL 0
+#endif
+
+#define MUDUO_LOG_ENABLED(level) \
+  (MUDUO_MIN_LOG_LEVEL <= muduo::Logger::level && muduo::Logger::minLogLevel() <= muduo::Logger::level)
+
+// Runs the statement once if enabled and admitted by rate limit of the
+// level, a for instead of an if, so that an else never binds to it.
+#define MUDUO_LOG_ADMIT(level, enabled) \
+  for (muduo::detail::LogAdmission muduoAdmission = (enabled) \
+         ? muduo::detail::admitLog(muduo::Logger::level) : muduo::detail::LogAdmission(); \
+       muduoAdmission; muduoAdmission = muduo::detail::LogAdmission())
+
+#define LOG_TRACE MUDUO_LOG_ADMIT(TRACE, MUDUO_LOG_ENABLED(TRACE)) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::TRACE, __func__, muduoAdmission).stream()
+#define LOG_DEBUG MUDUO_LOG_ADMIT(DEBUG, MUDUO_LOG_ENABLED(DEBUG)) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::DEBUG, __func__, muduoAdmission).stream()
+#define LOG_INFO MUDUO_LOG_ADMIT(INFO, MUDUO_LOG_ENABLED(INFO)) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::INFO, NULL, muduoAdmission).stream()
+// regardless of log level, unless removed at compile time
+#define LOG_WARN MUDUO_LOG_ADMIT(WARN, MUDUO_MIN_LOG_LEVEL <= 3) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::WARN, NULL, muduoAdmission).stream()
+#define LOG_ERROR MUDUO_LOG_ADMIT(ERROR, MUDUO_MIN_LOG_LEVEL <= 4) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::ERROR, NULL, muduoAdmission).stream()
+#define LOG_FATAL muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::FATAL).stream()
+// Per statement rate limits, e.g.
+//
+// LOG_EVERY_N(WARN, 1000) << "queue is full";
+// LOG_EVERY_T(ERROR, 1.0) << "accept failed";  // at most once a second
+//
+// LOG_EVERY_T tells how many lines were skipped since the last one.
+#define MUDUO_LOG_SITE_STATE \
+  ([]() -> muduo::detail::LogSiteState& { \
+    static muduo::detail::LogSiteState state; return state; }())
+
+#define LOG_EVERY_N(level, n) \
+  for (bool muduoOnce = MUDUO_LOG_ENABLED(level) && MUDUO_LOG_SITE_STATE.everyN(n); \
+       muduoOnce; muduoOnce = false) \
+    muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::level).stream()
+#define LOG_FIRST_N(level, n) \
+  for (bool muduoOnce = MUDUO_LOG_ENABLED(level) && MUDUO_LOG_SITE_STATE.firstN(n); \
+       muduoOnce; muduoOnce = false) \
+    muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::level).stream()
+#define LOG_EVERY_T(level, seconds) \
+  for (int64_t muduoSuppressed = MUDUO_LOG_ENABLED(level) \
+         ? MUDUO_LOG_SITE_STATE.everyT(seconds) : -1; \
+       muduoSuppressed >= 0; muduoSuppressed = -1) \
+    muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, muduo::Logger::level).stream() \
+      << muduo::detail::Suppressed(muduoSuppressed)
+
+#define LOG_SYSERR MUDUO_LOG_ADMIT(ERROR, true) \
+  muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, false, muduoAdmission).stream()
+#define LOG_SYSFATAL muduo::Logger(MUDUO_SOURCE_FILE, __LINE__, true).stream()
 
 const char* strerror_tl(int savedErrno);
 
@@ -0,0 +1,327 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_MPMCQUEUE_H
+#define MUDUO_BASE_MPMCQUEUE_H
+
+#include "muduo/base/Condition.h"
+#include "muduo/base/Mutex.h"
+
+#include <atomic>
+#include <memory>
+
+#include <assert.h>
+#include <sched.h>
+#include <stddef.h>
+
+namespace muduo
+{
+
+///
+/// Bounded lock-free queue for many producers and many consumers,
+/// a drop-in for BoundedBlockingQueue.
+///
+/// Each slot has a sequence number, telling whether it's ready for the
+/// producer or the consumer of a given lap, see Dmitry Vyukov's
+/// "Bounded MPMC queue".  put() and take() spin a while on full or empty,
+/// then park on a condition variable.  The tryXxx() functions never block,
+/// and take no lock unless some thread is parked.
+///
+template<typename T>
+class MpmcQueue : noncopyable
+{
+ public:
+  /// @c capacity is rounded up to power of 2.
+  explicit MpmcQueue(size_t capacity)
+    : mutex_(),
+      notEmpty_(mutex_),
+      notFull_(mutex_),
+      capacity_(roundUp(capacity)),
+      mask_(capacity_ - 1),
+      slots_(new Slot[capacity_]),
+      numWaitingProducers_(0),
+      numWaitingConsumers_(0),
+      putPos_(0),
+      takePos_(0)
+  {
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Returns false if full.
+  bool tryPut(const T& x)
+  {
+    T copy(x);
+    return tryPut(std::move(copy));
+  }
+
+  /// Returns false if full, @c x is intact then.
+  bool tryPut(T&& x)
+  {
+    if (!putSlot(&x, 1))
+    {
+      return false;
+    }
+    wakeup(numWaitingConsumers_, notEmpty_, false);
+    return true;
+  }
+
+  /// Returns false if empty.
+  bool tryTake(T* x)
+  {
+    if (!takeSlot(x, 1))
+    {
+      return false;
+    }
+    wakeup(numWaitingProducers_, notFull_, false);
+    return true;
+  }
+
+  /// Puts first k items of @c items in a row, moved from, returns k.
+  /// k < @c n if the queue becomes full.
+  size_t tryPutBatch(T* items, size_t n)
+  {
+    size_t k = putSlot(items, n);
+    if (k > 0)
+    {
+      wakeup(numWaitingConsumers_, notEmpty_, k > 1);
+    }
+    return k;
+  }
+
+  /// Takes at most @c n items, returns number taken.
+  size_t tryTakeBatch(T* items, size_t n)
+  {
+    size_t k = takeSlot(items, n);
+    if (k > 0)
+    {
+      wakeup(numWaitingProducers_, notFull_, k > 1);
+    }
+    return k;
+  }
+
+  void put(const T& x)
+  {
+    T copy(x);
+    put(std::move(copy));
+  }
+
+  /// Blocks if full.
+  void put(T&& x)
+  {
+    for (int i = 0; i < kSpinRounds; ++i)
+    {
+      if (tryPut(std::move(x)))
+      {
+        return;
+      }
+      sched_yield();
+    }
+    {
+    MutexLockGuard lock(mutex_);
+    park(numWaitingProducers_);
+    while (!putSlot(&x, 1))
+    {
+      notFull_.wait();
+    }
+    numWaitingProducers_.fetch_sub(1);
+    }
+    wakeup(numWaitingConsumers_, notEmpty_, false);
+  }
+
+  /// Blocks until all @c n items of @c items are put, moved from.
+  void putBatch(T* items, size_t n)
+  {
+    size_t done = 0;
+    while (done < n)
+    {
+      size_t k = tryPutBatch(items + done, n - done);
+      if (k == 0)
+      {
+        put(std::move(items[done]));
+        k = 1;
+      }
+      done += k;
+    }
+  }
+
+  /// Blocks if empty.
+  T take()
+  {
+    T x;
+    takeBatch(&x, 1);
+    return x;
+  }
+
+  /// Blocks if empty, then takes at most @c n items, returns number taken.
+  size_t takeBatch(T* items, size_t n)
+  {
+    assert(n > 0);
+    size_t k = 0;
+    for (int i = 0; i < kSpinRounds; ++i)
+    {
+      if ((k = tryTakeBatch(items, n)) > 0)
+      {
+        return k;
+      }
+      sched_yield();
+    }
+    {
+    MutexLockGuard lock(mutex_);
+    park(numWaitingConsumers_);
+    while ((k = takeSlot(items, n)) == 0)
+    {
+      notEmpty_.wait();
+    }
+    numWaitingConsumers_.fetch_sub(1);
+    }
+    wakeup(numWaitingProducers_, notFull_, k > 1);
+    return k;
+  }
+
+  /// Approximate if other threads are putting or taking.
+  size_t size() const
+  {
+    size_t put = putPos_.load(std::memory_order_acquire);
+    size_t taken = takePos_.load(std::memory_order_acquire);
+    return put > taken ? put - taken : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  bool full() const { return size() >= capacity_; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct Slot
+  {
+    // == pos, ready for the producer of pos
+    // == pos + 1, ready for the consumer of pos
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t roundUp(size_t n)
+  {
+    assert(n > 0);
+    size_t result = 1;
+    while (result < n)
+    {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // claims up to n consecutive slots with one CAS, returns number claimed.
+  size_t claim(std::atomic<size_t>& position, size_t lap, size_t n, size_t* first)
+  {
+    size_t pos = position.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      size_t k = 0;
+      while (k < n)
+      {
+        size_t seq = slots_[(pos + k) & mask_].sequence.load(std::memory_order_acquire);
+        if (seq != pos + k + lap)
+        {
+          break;
+        }
+        ++k;
+      }
+      if (k == 0)
+      {
+        size_t seq = slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+        // behind by a lap: full for producer, empty for consumer
+        if (static_cast<ptrdiff_t>(seq - (pos + lap)) < 0)
+        {
+          return 0;
+        }
+        pos = position.load(std::memory_order_relaxed);
+      }
+      else if (position.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+      {
+        *first = pos;
+        return k;
+      }
+    }
+  }
+
+  size_t putSlot(T* items, size_t n)
+  {
+    size_t pos = 0;
+    size_t k = claim(putPos_, 0, n, &pos);
+    for (size_t i = 0; i < k; ++i)
+    {
+      Slot& slot = slots_[(pos + i) & mask_];
+      slot.data = std::move(items[i]);
+      slot.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return k;
+  }
+
+  size_t takeSlot(T* items, size_t n)
+  {
+    size_t pos = 0;
+    size_t k = claim(takePos_, 1, n, &pos);
+    for (size_t i = 0; i < k; ++i)
+    {
+      Slot& slot = slots_[(pos + i) & mask_];
+      items[i] = std::move(slot.data);
+      slot.data = T();  // release resources held by items[i]
+      slot.sequence.store(pos + i + capacity_, std::memory_order_release);
+    }
+    return k;
+  }
+
+  // Registers a parked thread, mutex_ held.
+  void park(std::atomic<int>& numWaiting)
+  {
+    numWaiting.fetch_add(1);
+    // pairs with the fence in wakeup(), either the parked thread sees
+    // the slot, or the waking thread sees the parked one.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void wakeup(std::atomic<int>& numWaiting, Condition& cond, bool all)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numWaiting.load(std::memory_order_relaxed) > 0)
+    {
+      MutexLockGuard lock(mutex_);
+      if (all)
+      {
+        cond.notifyAll();
+      }
+      else
+      {
+        cond.notify();
+      }
+    }
+  }
+
+  static const size_t kCacheLineSize = 64;
+  static const int kSpinRounds = 16;
+
+  MutexLock mutex_;
+  Condition notEmpty_ GUARDED_BY(mutex_);
+  Condition notFull_ GUARDED_BY(mutex_);
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<int> numWaitingProducers_;
+  std::atomic<int> numWaitingConsumers_;
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> putPos_;
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> takePos_;
+  char pad2_[kCacheLineSize];
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_MPMCQUEUE_H
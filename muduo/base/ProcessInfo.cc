@@ -50,6 +50,29 @@ int scanDir(const char *dirpath, int (*filter)(const struct dirent *))
   return result;
 }
 
+// parses cpulist format, eg. "0-3,8-11"
+std::vector<int> parseCpuList(const string& list)
+{
+  std::vector<int> cpus;
+  const char* p = list.c_str();
+  while (::isdigit(*p))
+  {
+    char* end = NULL;
+    long first = ::strtol(p, &end, 10);
+    long last = first;
+    if (*end == '-')
+    {
+      last = ::strtol(end + 1, &end, 10);
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+    {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return cpus;
+}
+
 Timestamp g_startTime = Timestamp::now();
 // assume those won't change during the life time of a process.
 int g_clockTicks = static_cast<int>(::sysconf(_SC_CLK_TCK));
@@ -244,3 +267,43 @@ std::vector<pid_t> ProcessInfo::threads()
   return result;
 }
 
+
+std::vector<std::vector<int>> ProcessInfo::numaNodeCpus()
+{
+  std::vector<std::vector<int>> result;
+  for (int node = 0; ; ++node)
+  {
+    char path[64];
+    snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", node);
+    string list;
+    if (FileUtil::readFile(path, 65536, &list) != 0)
+    {
+      break;
+    }
+    std::vector<int> cpus = parseCpuList(list);
+    if (!cpus.empty())  // memory-only node
+    {
+      result.push_back(cpus);
+    }
+  }
+  if (result.empty())
+  {
+    // online CPUs may have holes, e.g. "0-3,8-11"
+    string list;
+    std::vector<int> cpus;
+    if (FileUtil::readFile("/sys/devices/system/cpu/online", 65536, &list) == 0)
+    {
+      cpus = parseCpuList(list);
+    }
+    if (cpus.empty())
+    {
+      long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+      for (int cpu = 0; cpu < n; ++cpu)
+      {
+        cpus.push_back(cpu);
+      }
+    }
+    result.push_back(cpus);
+  }
+  return result;
+}
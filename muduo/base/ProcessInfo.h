@@ -61,6 +61,10 @@ namespace ProcessInfo
 
   int numThreads();
   std::vector<pid_t> threads();
+
+  /// CPUs of each NUMA node, read from /sys/devices/system/node.
+  /// Returns one set of all online CPUs if NUMA info is not available.
+  std::vector<std::vector<int>> numaNodeCpus();
 }  // namespace ProcessInfo
 
 }  // namespace muduo
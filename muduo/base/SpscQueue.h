@@ -0,0 +1,120 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_SPSCQUEUE_H
+#define MUDUO_BASE_SPSCQUEUE_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+#include <vector>
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace muduo
+{
+
+///
+/// Bounded lock-free queue for exactly one producer thread
+/// and one consumer thread, non-blocking.
+///
+template<typename T>
+class SpscQueue : noncopyable
+{
+ public:
+  /// @c capacity is rounded up to power of 2.
+  explicit SpscQueue(size_t capacity)
+    : buffer_(roundUp(capacity)),
+      mask_(buffer_.size() - 1),
+      head_(0),
+      cachedTail_(0),
+      tail_(0),
+      cachedHead_(0)
+  {
+  }
+
+  /// Called by the producer, returns false if full.
+  bool tryPut(const T& x)
+  {
+    T copy(x);
+    return tryPut(std::move(copy));
+  }
+
+  bool tryPut(T&& x)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ == buffer_.size())
+    {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (tail - cachedHead_ == buffer_.size())
+      {
+        return false;
+      }
+    }
+    buffer_[tail & mask_] = std::move(x);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Called by the consumer, returns false if empty.
+  bool tryTake(T* x)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_)
+    {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (head == cachedTail_)
+      {
+        return false;
+      }
+    }
+    *x = std::move(buffer_[head & mask_]);
+    buffer_[head & mask_] = T();  // release resources held by x
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Approximate if called by neither side.
+  size_t size() const
+  {
+    return tail_.load(std::memory_order_acquire)
+           - head_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return buffer_.size(); }
+
+ private:
+  static size_t roundUp(size_t n)
+  {
+    assert(n > 0);
+    size_t result = 1;
+    while (result < n)
+    {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  static const size_t kCacheLineSize = 64;
+
+  std::vector<T> buffer_;
+  const size_t mask_;
+  char pad0_[kCacheLineSize];
+  // written by consumer
+  std::atomic<size_t> head_;
+  size_t cachedTail_;
+  char pad1_[kCacheLineSize];
+  // written by producer
+  std::atomic<size_t> tail_;
+  size_t cachedHead_;
+  char pad2_[kCacheLineSize];
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_SPSCQUEUE_H
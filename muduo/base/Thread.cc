@@ -54,21 +54,46 @@ struct ThreadData
   typedef muduo::Thread::ThreadFunc ThreadFunc;
   ThreadFunc func_;
   string name_;
+  muduo::Thread::CpuSet cpus_;
   pid_t* tid_;
   CountDownLatch* latch_;
 
   ThreadData(ThreadFunc func,
              const string& name,
+             const muduo::Thread::CpuSet& cpus,
              pid_t* tid,
              CountDownLatch* latch)
     : func_(std::move(func)),
       name_(name),
+      cpus_(cpus),
       tid_(tid),
       latch_(latch)
   { }
 
+  void setCpuAffinity()
+  {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus_)
+    {
+      assert(0 <= cpu && cpu < CPU_SETSIZE);
+      CPU_SET(cpu, &cpuset);
+    }
+    int err = ::pthread_setaffinity_np(::pthread_self(), sizeof cpuset, &cpuset);
+    if (err)
+    {
+      errno = err;
+      LOG_SYSERR << "Failed to set CPU affinity of thread " << name_;
+    }
+  }
+
   void runInThread()
   {
+    // before anything else, so that memory touched by func_ is node local.
+    if (!cpus_.empty())
+    {
+      setCpuAffinity();
+    }
     *tid_ = muduo::CurrentThread::tid();
     tid_ = NULL;
     latch_->countDown();
@@ -175,7 +200,7 @@ void Thread::start()
   assert(!started_);
   started_ = true;
   // FIXME: move(func_)
-  detail::ThreadData* data = new detail::ThreadData(func_, name_, &tid_, &latch_);
+  detail::ThreadData* data = new detail::ThreadData(func_, name_, cpus_, &tid_, &latch_);
   if (pthread_create(&pthreadId_, NULL, &detail::startThread, data))
   {
     started_ = false;
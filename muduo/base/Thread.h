@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 #include <pthread.h>
 
 namespace muduo
@@ -21,11 +22,19 @@ class Thread : noncopyable
 {
  public:
   typedef std::function<void ()> ThreadFunc;
+  typedef std::vector<int> CpuSet;
 
   explicit Thread(ThreadFunc, const string& name = string());
   // FIXME: make it movable in C++11
   ~Thread();
 
+  /// Restricts the thread to CPUs in @c cpus, empty means no restriction.
+  /// It's applied when the thread is created, so memory first touched by
+  /// ThreadFunc is allocated on the NUMA node of those CPUs.
+  /// Must be called before start().
+  void setCpuAffinity(const CpuSet& cpus) { cpus_ = cpus; }
+  const CpuSet& cpuAffinity() const { return cpus_; }
+
   void start();
   int join(); // return pthread_join()
 
@@ -45,6 +54,7 @@ class Thread : noncopyable
   pid_t      tid_;
   ThreadFunc func_;
   string     name_;
+  CpuSet     cpus_;
   CountDownLatch latch_;
 
   static AtomicInt32 numCreated_;
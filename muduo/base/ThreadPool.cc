@@ -12,13 +12,27 @@
 
 using namespace muduo;
 
+namespace
+{
+
+int64_t elapsedMicroSeconds(Timestamp since)
+{
+  return Timestamp::now().microSecondsSinceEpoch() - since.microSecondsSinceEpoch();
+}
+
+}  // namespace
+
 ThreadPool::ThreadPool(const string& nameArg)
   : mutex_(),
     notEmpty_(mutex_),
     notFull_(mutex_),
     name_(nameArg),
+    queueSize_(0),
     maxQueueSize_(0),
-    running_(false)
+    running_(false),
+    collectStats_(false),
+    numRejected_(0),
+    numDropped_(0)
 {
 }
 
@@ -41,6 +55,10 @@ void ThreadPool::start(int numThreads)
     snprintf(id, sizeof id, "%d", i+1);
     threads_.emplace_back(new muduo::Thread(
           std::bind(&ThreadPool::runInThread, this), name_+id));
+    if (!cpuSets_.empty())
+    {
+      threads_[i]->setCpuAffinity(cpuSets_[i % cpuSets_.size()]);
+    }
     threads_[i]->start();
   }
   if (numThreads == 0 && threadInitCallback_)
@@ -65,10 +83,27 @@ void ThreadPool::stop()
 size_t ThreadPool::queueSize() const
 {
   MutexLockGuard lock(mutex_);
-  return queue_.size();
+  return queueSize_;
+}
+
+int64_t ThreadPool::numRejected() const
+{
+  MutexLockGuard lock(mutex_);
+  return numRejected_;
+}
+
+int64_t ThreadPool::numDropped() const
+{
+  MutexLockGuard lock(mutex_);
+  return numDropped_;
 }
 
 void ThreadPool::run(Task task)
+{
+  run(std::move(task), kNormalPriority);
+}
+
+void ThreadPool::run(Task task, Priority priority)
 {
   if (threads_.empty())
   {
@@ -83,24 +118,84 @@ void ThreadPool::run(Task task)
     }
     assert(!isFull());
 
-    queue_.push_back(std::move(task));
-    notEmpty_.notify();
+    put(std::move(task), priority);
+  }
+}
+
+bool ThreadPool::tryRun(Task task, RejectPolicy policy, Priority priority)
+{
+  if (threads_.empty())
+  {
+    task();
+    return true;
+  }
+
+  Task dropped;  // destroyed out of the lock
+  {
+  MutexLockGuard lock(mutex_);
+  if (!isFull())
+  {
+    put(std::move(task), priority);
+    return true;
+  }
+  if (policy == kDropOldest)
+  {
+    for (int p = kLowPriority; p >= priority; --p)
+    {
+      if (!queues_[p].empty())
+      {
+        dropped = std::move(queues_[p].front().task);
+        queues_[p].pop_front();
+        --queueSize_;
+        ++numDropped_;
+        put(std::move(task), priority);
+        return true;
+      }
+    }
   }
+  if (policy != kCallerRuns)
+  {
+    ++numRejected_;
+    return false;
+  }
+  }
+  task();
+  return true;
+}
+
+void ThreadPool::put(Task task, Priority priority)
+{
+  mutex_.assertLocked();
+  assert(0 <= priority && priority < kNumPriorities);
+  queues_[priority].emplace_back(std::move(task),
+                                 collectStats_ ? Timestamp::now() : Timestamp());
+  ++queueSize_;
+  notEmpty_.notify();
 }
 
 ThreadPool::Task ThreadPool::take()
 {
   MutexLockGuard lock(mutex_);
   // always use a while-loop, due to spurious wakeup
-  while (queue_.empty() && running_)
+  while (queueSize_ == 0 && running_)
   {
     notEmpty_.wait();
   }
   Task task;
-  if (!queue_.empty())
+  if (queueSize_ > 0)
   {
-    task = queue_.front();
-    queue_.pop_front();
+    std::deque<Entry>* queue = queues_;
+    while (queue->empty())
+    {
+      ++queue;
+    }
+    task = std::move(queue->front().task);
+    if (queue->front().enqueued.valid())
+    {
+      queueTime_.add(elapsedMicroSeconds(queue->front().enqueued));
+    }
+    queue->pop_front();
+    --queueSize_;
     if (maxQueueSize_ > 0)
     {
       notFull_.notify();
@@ -112,7 +207,21 @@ ThreadPool::Task ThreadPool::take()
 bool ThreadPool::isFull() const
 {
   mutex_.assertLocked();
-  return maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_;
+  return maxQueueSize_ > 0 && queueSize_ >= maxQueueSize_;
+}
+
+void ThreadPool::runTask(const Task& task)
+{
+  if (collectStats_)
+  {
+    Timestamp start(Timestamp::now());
+    task();
+    runTime_.add(elapsedMicroSeconds(start));
+  }
+  else
+  {
+    task();
+  }
 }
 
 void ThreadPool::runInThread()
@@ -128,7 +237,7 @@ void ThreadPool::runInThread()
       Task task(take());
       if (task)
       {
-        task();
+        runTask(task);
       }
     }
   }
@@ -7,21 +7,72 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include "muduo/base/Condition.h"
+#include "muduo/base/Histogram.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
 #include "muduo/base/Types.h"
 
 #include <deque>
+#include <future>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace muduo
 {
 
+namespace detail
+{
+
+// Runs f in a pool thread, then cb(result) in the loop thread.
+template<typename F, typename Loop, typename Callback>
+class DeliverTask
+{
+ public:
+  DeliverTask(F f, Loop* loop, Callback cb)
+    : f_(std::move(f)),
+      loop_(loop),
+      cb_(std::move(cb))
+  {
+  }
+
+  void operator()()
+  {
+    loop_->queueInLoop(std::bind(cb_, f_()));
+  }
+
+ private:
+  F f_;
+  Loop* loop_;
+  Callback cb_;
+};
+
+}  // namespace detail
+
 class ThreadPool : noncopyable
 {
  public:
   typedef std::function<void ()> Task;
 
+  /// Tasks of higher priority are taken first, FIFO in the same priority.
+  enum Priority
+  {
+    kHighPriority,
+    kNormalPriority,
+    kLowPriority,
+    kNumPriorities,
+  };
+
+  /// What tryRun() does if the queue is full.
+  enum RejectPolicy
+  {
+    kReject,      // returns false
+    kDropOldest,  // discards the oldest task of the lowest priority,
+                  // if not higher than the new one, else rejects
+    kCallerRuns,  // runs the task in the calling thread
+  };
+
   explicit ThreadPool(const string& nameArg = string("ThreadPool"));
   ~ThreadPool();
 
@@ -29,6 +80,13 @@ class ThreadPool : noncopyable
   void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
   void setThreadInitCallback(const Task& cb)
   { threadInitCallback_ = cb; }
+  /// Pins the i-th worker to cpuSets[i % cpuSets.size()],
+  /// see Thread::setCpuAffinity().
+  void setCpuAffinity(const std::vector<Thread::CpuSet>& cpuSets)
+  { cpuSets_ = cpuSets; }
+  /// Records queueing and running time of each task, in microseconds,
+  /// see queueTimeHistogram() and runTimeHistogram().
+  void setCollectStats(bool on) { collectStats_ = on; }
 
   void start(int numThreads);
   void stop();
@@ -44,21 +102,86 @@ class ThreadPool : noncopyable
   // as we do in (Bounded)BlockingQueue.
   // https://stackoverflow.com/a/25408989
   void run(Task f);
+  void run(Task f, Priority priority);
+
+  /// Never blocks, suitable for an EventLoop thread.
+  /// Returns false if the task is rejected, see RejectPolicy.
+  bool tryRun(Task f,
+              RejectPolicy policy = kReject,
+              Priority priority = kNormalPriority);
+
+  /// Could block, same as run().
+  /// The future holds the result, or the exception thrown by @c f,
+  /// or std::future_error if the task is discarded by stop() or kDropOldest.
+  template<typename F>
+  std::future<typename std::result_of<F()>::type>
+  submit(F f, Priority priority = kNormalPriority)
+  {
+    typedef typename std::result_of<F()>::type Result;
+    typedef std::packaged_task<Result()> PackagedTask;
+    // std::function needs a copyable functor
+    std::shared_ptr<PackagedTask> task(std::make_shared<PackagedTask>(std::move(f)));
+    std::future<Result> result(task->get_future());
+    run(std::bind(&PackagedTask::operator(), task), priority);
+    return result;
+  }
+
+  /// Never blocks, same as tryRun().
+  /// Runs @c f in the pool, then @c cb(f()) in @c loop,
+  /// via loop->queueInLoop(), eg. to send the result from an IO thread.
+  /// @c f must not throw, neither return void.
+  template<typename F, typename Loop, typename Callback>
+  bool trySubmit(F f, Loop* loop, Callback cb,
+                 RejectPolicy policy = kReject,
+                 Priority priority = kNormalPriority)
+  {
+    return tryRun(detail::DeliverTask<F, Loop, Callback>(std::move(f), loop, std::move(cb)),
+                  policy, priority);
+  }
+
+  /// Tasks rejected by tryRun().
+  int64_t numRejected() const;
+  /// Tasks discarded by kDropOldest.
+  int64_t numDropped() const;
+
+  const Histogram& queueTimeHistogram() const { return queueTime_; }
+  const Histogram& runTimeHistogram() const { return runTime_; }
 
  private:
+  struct Entry
+  {
+    Entry(Task t, Timestamp when)
+      : task(std::move(t)),
+        enqueued(when)
+    {
+    }
+
+    Task task;
+    Timestamp enqueued;  // invalid if !collectStats_
+  };
+
   bool isFull() const REQUIRES(mutex_);
+  void put(Task task, Priority priority) REQUIRES(mutex_);
   void runInThread();
   Task take();
+  void runTask(const Task& task);
 
   mutable MutexLock mutex_;
   Condition notEmpty_ GUARDED_BY(mutex_);
   Condition notFull_ GUARDED_BY(mutex_);
   string name_;
   Task threadInitCallback_;
+  std::vector<Thread::CpuSet> cpuSets_;
   std::vector<std::unique_ptr<muduo::Thread>> threads_;
-  std::deque<Task> queue_ GUARDED_BY(mutex_);
+  std::deque<Entry> queues_[kNumPriorities] GUARDED_BY(mutex_);
+  size_t queueSize_ GUARDED_BY(mutex_);  // of all queues_
   size_t maxQueueSize_;
   bool running_;
+  bool collectStats_;
+  int64_t numRejected_ GUARDED_BY(mutex_);
+  int64_t numDropped_ GUARDED_BY(mutex_);
+  Histogram queueTime_;
+  Histogram runTime_;
 };
 
 }  // namespace muduo
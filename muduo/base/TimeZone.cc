@@ -8,6 +8,7 @@
 #include "muduo/base/Date.h"
 
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -296,6 +297,36 @@ struct tm TimeZone::toLocalTime(time_t seconds) const
   return localTime;
 }
 
+TimeZone::Window TimeZone::windowOf(time_t seconds) const
+{
+  assert(data_ != NULL);
+  const Data& data(*data_);
+
+  // same choice as findLocaltime(), the last transition not after seconds
+  detail::Transition sentry(seconds, 0, 0);
+  vector<detail::Transition>::const_iterator next = upper_bound(data.transitions.begin(),
+                                                                data.transitions.end(),
+                                                                sentry,
+                                                                detail::Comp(true));
+  Window window;
+  const detail::Localtime* local = NULL;
+  if (next == data.transitions.begin())
+  {
+    window.start = std::numeric_limits<time_t>::min();
+    local = &data.localtimes.front();
+  }
+  else
+  {
+    window.start = (next - 1)->gmttime;
+    local = &data.localtimes[(next - 1)->localtimeIdx];
+  }
+  window.end = next != data.transitions.end() ? next->gmttime
+                                              : std::numeric_limits<time_t>::max();
+  window.gmtOffset = static_cast<int>(local->gmtOffset);
+  window.isDst = local->isDst;
+  return window;
+}
+
 time_t TimeZone::fromLocalTime(const struct tm& localTm) const
 {
   assert(data_ != NULL);
@@ -32,6 +32,20 @@ class TimeZone : public muduo::copyable
   struct tm toLocalTime(time_t secondsSinceEpoch) const;
   time_t fromLocalTime(const struct tm&) const;
 
+  /// The UTC offset in effect over [start, end), between two transitions.
+  /// Callers convert many times of the same window with an addition,
+  /// and look up again only when leaving it.
+  struct Window
+  {
+    time_t start;
+    time_t end;
+    int gmtOffset;
+    bool isDst;
+  };
+
+  /// Returns the window containing @c secondsSinceEpoch.
+  Window windowOf(time_t secondsSinceEpoch) const;
+
   // gmtime(3)
   static struct tm toUtcTime(time_t secondsSinceEpoch, bool yday = false);
   // timegm(3)
@@ -5,8 +5,18 @@
 
 #include "muduo/base/Timestamp.h"
 
+#include <atomic>
+
+#include <math.h>
 #include <sys/time.h>
 #include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define MUDUO_HAVE_TSC 1
+#endif
 
 #ifndef __STDC_FORMAT_MACROS
 #define __STDC_FORMAT_MACROS
@@ -16,6 +26,137 @@
 
 using namespace muduo;
 
+namespace
+{
+
+Timestamp::Clock g_clock = Timestamp::kGettimeofday;
+__thread int64_t t_cachedNow = 0;
+
+int64_t gettimeofdayMicroSeconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  int64_t seconds = tv.tv_sec;
+  return seconds * Timestamp::kMicroSecondsPerSecond + tv.tv_usec;
+}
+
+#if MUDUO_HAVE_TSC
+// rebased against gettimeofday(2) every second, to follow NTP adjustments
+const int64_t kTscRebaseMicroSeconds = Timestamp::kMicroSecondsPerSecond;
+// a larger change of rate means the system clock was stepped
+const double kTscMaxRateChange = 0.001;
+
+struct TscCalibration
+{
+  uint64_t baseTsc;
+  int64_t baseMicroSeconds;
+  double microSecondsPerTick;
+};
+
+// published with a sequence lock, odd while being written
+std::atomic<uint32_t> g_tscSeq(0);
+std::atomic<uint64_t> g_tscBase(0);
+std::atomic<int64_t> g_tscBaseMicroSeconds(0);
+std::atomic<double> g_microSecondsPerTick(0.0);
+std::atomic<bool> g_tscRebasing(false);
+
+void storeTsc(const TscCalibration& c)
+{
+  uint32_t seq = g_tscSeq.load(std::memory_order_relaxed);
+  g_tscSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  g_tscBase.store(c.baseTsc, std::memory_order_relaxed);
+  g_tscBaseMicroSeconds.store(c.baseMicroSeconds, std::memory_order_relaxed);
+  g_microSecondsPerTick.store(c.microSecondsPerTick, std::memory_order_relaxed);
+  g_tscSeq.store(seq + 2, std::memory_order_release);
+}
+
+TscCalibration loadTsc()
+{
+  TscCalibration c;
+  uint32_t seq = 0;
+  do
+  {
+    seq = g_tscSeq.load(std::memory_order_acquire);
+    c.baseTsc = g_tscBase.load(std::memory_order_relaxed);
+    c.baseMicroSeconds = g_tscBaseMicroSeconds.load(std::memory_order_relaxed);
+    c.microSecondsPerTick = g_microSecondsPerTick.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != g_tscSeq.load(std::memory_order_relaxed));
+  return c;
+}
+
+bool hasInvariantTsc()
+{
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+}
+
+bool calibrateTsc()
+{
+  if (!hasInvariantTsc())
+  {
+    return false;
+  }
+  int64_t start = gettimeofdayMicroSeconds();
+  uint64_t startTsc = __rdtsc();
+  struct timespec ts = { 0, 20 * 1000 * 1000 };
+  ::nanosleep(&ts, NULL);
+  int64_t end = gettimeofdayMicroSeconds();
+  uint64_t endTsc = __rdtsc();
+  if (end <= start || endTsc <= startTsc)
+  {
+    return false;
+  }
+  // rough, refined by rebaseTsc() over a longer window
+  TscCalibration c = { endTsc, end,
+                       static_cast<double>(end - start) / static_cast<double>(endTsc - startTsc) };
+  storeTsc(c);
+  return true;
+}
+
+// Takes the time from gettimeofday(2) again, and the rate over the whole
+// period since last base.  So now() differs from the system clock by
+// the drift of at most one period, a few microseconds, plus the error of
+// interpolation, and follows slewing by NTP.
+int64_t rebaseTsc(const TscCalibration& old)
+{
+  int64_t now = gettimeofdayMicroSeconds();
+  uint64_t tsc = __rdtsc();
+  TscCalibration c = { tsc, now, old.microSecondsPerTick };
+  if (now > old.baseMicroSeconds && tsc > old.baseTsc)
+  {
+    double rate = static_cast<double>(now - old.baseMicroSeconds)
+        / static_cast<double>(tsc - old.baseTsc);
+    if (fabs(rate - old.microSecondsPerTick) < kTscMaxRateChange * old.microSecondsPerTick)
+    {
+      c.microSecondsPerTick = rate;
+    }
+  }
+  storeTsc(c);
+  return now;
+}
+
+int64_t tscMicroSeconds()
+{
+  uint64_t tsc = __rdtsc();
+  TscCalibration c = loadTsc();
+  int64_t ticks = static_cast<int64_t>(tsc - c.baseTsc);
+  int64_t elapsed = static_cast<int64_t>(static_cast<double>(ticks) * c.microSecondsPerTick);
+  // one thread rebases, others go on with the old calibration
+  if (elapsed >= kTscRebaseMicroSeconds
+      && !g_tscRebasing.exchange(true, std::memory_order_acquire))
+  {
+    int64_t now = rebaseTsc(c);
+    g_tscRebasing.store(false, std::memory_order_release);
+    return now;
+  }
+  return c.baseMicroSeconds + elapsed;
+}
+#endif
+
+}  // namespace
+
 static_assert(sizeof(Timestamp) == sizeof(int64_t),
               "Timestamp is same size as int64_t");
 
@@ -52,11 +193,70 @@ string Timestamp::toFormattedString(bool showMicroseconds) const
   return buf;
 }
 
+bool Timestamp::setClock(Clock clock)
+{
+  switch (clock)
+  {
+    case kGettimeofday:
+      break;
+    case kRealtimeCoarse:
+    {
+      struct timespec ts;
+      if (::clock_gettime(CLOCK_REALTIME_COARSE, &ts) != 0)
+      {
+        return false;
+      }
+      break;
+    }
+    case kTsc:
+#if MUDUO_HAVE_TSC
+      if (!calibrateTsc())
+      {
+        return false;
+      }
+      break;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+  g_clock = clock;
+  return true;
+}
+
+Timestamp::Clock Timestamp::clock()
+{
+  return g_clock;
+}
+
 Timestamp Timestamp::now()
 {
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  int64_t seconds = tv.tv_sec;
-  return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
+  switch (g_clock)
+  {
+    case kRealtimeCoarse:
+    {
+      struct timespec ts;
+      ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+      int64_t seconds = ts.tv_sec;
+      return Timestamp(seconds * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+    }
+#if MUDUO_HAVE_TSC
+    case kTsc:
+      return Timestamp(tscMicroSeconds());
+#endif
+    default:
+      return Timestamp(gettimeofdayMicroSeconds());
+  }
+}
+
+Timestamp Timestamp::cachedNow()
+{
+  return t_cachedNow > 0 ? Timestamp(t_cachedNow) : now();
+}
+
+void Timestamp::setCachedNow(Timestamp now)
+{
+  t_cachedNow = now.microSecondsSinceEpoch();
 }
 
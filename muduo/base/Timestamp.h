@@ -59,10 +59,39 @@ class Timestamp : public muduo::copyable,
   time_t secondsSinceEpoch() const
   { return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond); }
 
+  enum Clock
+  {
+    kGettimeofday,    // default
+    kRealtimeCoarse,  // CLOCK_REALTIME_COARSE, resolution is one tick (1~4ms)
+    kTsc,             // calibrated rdtsc, x86 with invariant TSC only
+  };
+
+  ///
+  /// Selects the clock of now(), returns false if it's not available.
+  ///
+  /// kTsc is calibrated against gettimeofday(2) when selected, and
+  /// rebased every second by the first now() after it, so it follows
+  /// NTP slewing within the drift of one second.  A step of the system
+  /// clock takes effect at next rebase.
+  /// Not thread safe, should be called at start-up.
+  static bool setClock(Clock clock);
+  static Clock clock();
+
   ///
   /// Get time of now.
   ///
   static Timestamp now();
+
+  ///
+  /// Get time of now cached in current thread.
+  ///
+  /// EventLoop refreshes it once per poll return, so it lags behind now()
+  /// by the time spent in current iteration, but costs nothing.
+  /// Same as now() in a thread without a looping EventLoop.
+  static Timestamp cachedNow();
+  /// internal, for EventLoop, invalid() disables the cache.
+  static void setCachedNow(Timestamp now);
+
   static Timestamp invalid()
   {
     return Timestamp();
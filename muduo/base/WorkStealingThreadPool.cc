@@ -0,0 +1,466 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/WorkStealingThreadPool.h"
+
+#include "muduo/base/Exception.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+namespace muduo
+{
+namespace detail
+{
+
+// Bounded Chase-Lev deque of tasks, see
+// "Dynamic Circular Work-Stealing Deque", SPAA 2005, and
+// "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013.
+// push() and pop() are called by the owner only, steal() by any thread.
+class WorkStealingDeque : noncopyable
+{
+ public:
+  typedef WorkStealingThreadPool::Task Task;
+
+  explicit WorkStealingDeque(int64_t capacity)
+    : buffer_(new std::atomic<Task*>[capacity]),
+      mask_(capacity - 1),
+      top_(0),
+      bottom_(0)
+  {
+    assert(capacity > 0 && (capacity & mask_) == 0);
+  }
+
+  // returns false if full
+  bool push(Task* task)
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_)
+    {
+      return false;
+    }
+    buffer_[b & mask_].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // LIFO, returns NULL if empty
+  Task* pop()
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    Task* task = NULL;
+    if (t <= b)
+    {
+      task = buffer_[b & mask_].load(std::memory_order_relaxed);
+      if (t == b)
+      {
+        // the last one, race with steal()
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+        {
+          task = NULL;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    }
+    else
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // FIFO, returns NULL if empty or lost the race
+  Task* steal()
+  {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t < b)
+    {
+      Task* task = buffer_[t & mask_].load(std::memory_order_relaxed);
+      if (top_.compare_exchange_strong(t, t + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+      {
+        return task;
+      }
+    }
+    return NULL;
+  }
+
+  size_t size() const
+  {
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    int64_t t = top_.load(std::memory_order_acquire);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+ private:
+  static const int kCacheLineSize = 64;
+
+  std::unique_ptr<std::atomic<Task*>[]> buffer_;
+  const int64_t mask_;
+  char pad0_[kCacheLineSize];
+  std::atomic<int64_t> top_;     // written by thieves
+  char pad1_[kCacheLineSize];
+  std::atomic<int64_t> bottom_;  // written by owner
+  char pad2_[kCacheLineSize];
+};
+
+struct WorkStealingWorker : noncopyable
+{
+  WorkStealingWorker(WorkStealingThreadPool* p, int i)
+    : pool(p),
+      index(i),
+      deque(kDequeSize)
+  {
+  }
+
+  static const int64_t kDequeSize = 4096;
+
+  WorkStealingThreadPool* const pool;
+  const int index;
+  WorkStealingDeque deque;
+};
+
+}  // namespace detail
+}  // namespace muduo
+
+namespace
+{
+
+__thread detail::WorkStealingWorker* t_worker = NULL;
+
+// rounds of looking for tasks, before going to sleep
+const int kSpinRounds = 8;
+// most tasks a worker moves from shared queue to its deque at a time
+const size_t kMaxBatch = 64;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string& nameArg)
+  : mutex_(),
+    notEmpty_(mutex_),
+    name_(nameArg),
+    queueSize_(0),
+    numIdle_(0),
+    running_(false)
+{
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  if (running_)
+  {
+    stop();
+  }
+  clear();
+}
+
+void WorkStealingThreadPool::start(int numThreads)
+{
+  assert(threads_.empty());
+  running_ = true;
+  workers_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    workers_.emplace_back(new Worker(this, i));
+  }
+  threads_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i+1);
+    threads_.emplace_back(new muduo::Thread(
+          std::bind(&WorkStealingThreadPool::runInThread, this, i), name_+id));
+    if (!cpuSets_.empty())
+    {
+      threads_[i]->setCpuAffinity(cpuSets_[i % cpuSets_.size()]);
+    }
+    threads_[i]->start();
+  }
+  if (numThreads == 0 && threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+}
+
+void WorkStealingThreadPool::stop()
+{
+  {
+  MutexLockGuard lock(mutex_);
+  running_ = false;
+  notEmpty_.notifyAll();
+  }
+  for (auto& thr : threads_)
+  {
+    thr->join();
+  }
+  clear();
+}
+
+void WorkStealingThreadPool::clear()
+{
+  for (auto& worker : workers_)
+  {
+    while (Task* task = worker->deque.pop())
+    {
+      delete task;
+    }
+  }
+  MutexLockGuard lock(mutex_);
+  for (Task* task : queue_)
+  {
+    delete task;
+  }
+  queue_.clear();
+  queueSize_ = 0;
+}
+
+size_t WorkStealingThreadPool::queueSize() const
+{
+  size_t size = queueSize_;
+  for (auto& worker : workers_)
+  {
+    size += worker->deque.size();
+  }
+  return size;
+}
+
+bool WorkStealingThreadPool::inWorkerThread() const
+{
+  return t_worker != NULL && t_worker->pool == this;
+}
+
+void WorkStealingThreadPool::run(Task task)
+{
+  if (threads_.empty())
+  {
+    task();
+  }
+  else if (inWorkerThread())
+  {
+    runLocal(std::move(task));
+  }
+  else
+  {
+    pushShared(new Task(std::move(task)));
+  }
+}
+
+void WorkStealingThreadPool::runBatch(std::vector<Task>* tasks)
+{
+  if (threads_.empty())
+  {
+    for (Task& task : *tasks)
+    {
+      task();
+    }
+  }
+  else if (!tasks->empty())
+  {
+    MutexLockGuard lock(mutex_);
+    for (Task& task : *tasks)
+    {
+      queue_.push_back(new Task(std::move(task)));
+    }
+    queueSize_ = queue_.size();
+    if (numIdle_ > 0)
+    {
+      notEmpty_.notifyAll();
+    }
+  }
+  tasks->clear();
+}
+
+void WorkStealingThreadPool::runLocal(Task task)
+{
+  if (!inWorkerThread())
+  {
+    run(std::move(task));
+    return;
+  }
+  Task* p = new Task(std::move(task));
+  if (t_worker->deque.push(p))
+  {
+    wakeupIdle();
+  }
+  else
+  {
+    pushShared(p);
+  }
+}
+
+void WorkStealingThreadPool::pushShared(Task* task)
+{
+  MutexLockGuard lock(mutex_);
+  queue_.push_back(task);
+  queueSize_ = queue_.size();
+  if (numIdle_ > 0)
+  {
+    notEmpty_.notify();
+  }
+}
+
+void WorkStealingThreadPool::wakeupIdle()
+{
+  // pairs with the fence in waitForTask(), either we see the idle worker,
+  // or it sees the task we just pushed.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (numIdle_.load(std::memory_order_relaxed) > 0)
+  {
+    MutexLockGuard lock(mutex_);
+    notEmpty_.notify();
+  }
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::findTask(Worker* self)
+{
+  Task* task = self->deque.pop();
+  if (task == NULL)
+  {
+    task = takeShared(self);
+  }
+  if (task == NULL)
+  {
+    task = steal(self);
+  }
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::takeShared(Worker* self)
+{
+  if (queueSize_.load(std::memory_order_relaxed) == 0)
+  {
+    return NULL;
+  }
+  MutexLockGuard lock(mutex_);
+  if (queue_.empty())
+  {
+    return NULL;
+  }
+  Task* task = queue_.front();
+  queue_.pop_front();
+  // take a fair share, so that one lock is paid for many tasks
+  size_t batch = std::min(queue_.size() / workers_.size(), kMaxBatch);
+  while (batch > 0 && self->deque.push(queue_.front()))
+  {
+    queue_.pop_front();
+    --batch;
+  }
+  queueSize_ = queue_.size();
+  if (numIdle_ > 0 && (!queue_.empty() || self->deque.size() > 0))
+  {
+    notEmpty_.notify();
+  }
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::steal(Worker* self)
+{
+  size_t n = workers_.size();
+  for (size_t i = 1; i < n; ++i)
+  {
+    Worker* victim = workers_[(self->index + i) % n].get();
+    if (Task* task = victim->deque.steal())
+    {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+bool WorkStealingThreadPool::hasTask() const
+{
+  mutex_.assertLocked();
+  if (!queue_.empty())
+  {
+    return true;
+  }
+  for (auto& worker : workers_)
+  {
+    if (worker->deque.size() > 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::waitForTask()
+{
+  MutexLockGuard lock(mutex_);
+  numIdle_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // always use a while-loop, due to spurious wakeup
+  while (running_ && !hasTask())
+  {
+    notEmpty_.wait();
+  }
+  numIdle_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WorkStealingThreadPool::runInThread(int index)
+{
+  try
+  {
+    Worker* self = workers_[index].get();
+    t_worker = self;
+    if (threadInitCallback_)
+    {
+      threadInitCallback_();
+    }
+    int idleRounds = 0;
+    while (running_)
+    {
+      std::unique_ptr<Task> task(findTask(self));
+      if (task)
+      {
+        idleRounds = 0;
+        (*task)();
+      }
+      else if (++idleRounds < kSpinRounds)
+      {
+        sched_yield();
+      }
+      else
+      {
+        idleRounds = 0;
+        waitForTask();
+      }
+    }
+    t_worker = NULL;
+  }
+  catch (const Exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+    abort();
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    throw; // rethrow
+  }
+}
@@ -0,0 +1,103 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include "muduo/base/Condition.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace muduo
+{
+
+namespace detail
+{
+struct WorkStealingWorker;
+}  // namespace detail
+
+///
+/// Thread pool with a work-stealing deque per worker.
+///
+/// Tasks submitted by a worker go to the bottom of its own deque without
+/// locking, idle workers steal from the top of others' deques.  Tasks
+/// submitted by other threads go to a shared queue, which workers drain
+/// in batches.  Unlike ThreadPool, there is no maximum queue size.
+///
+class WorkStealingThreadPool : noncopyable
+{
+ public:
+  typedef std::function<void ()> Task;
+
+  explicit WorkStealingThreadPool(const string& nameArg = string("WorkStealingThreadPool"));
+  ~WorkStealingThreadPool();
+
+  // Must be called before start().
+  void setThreadInitCallback(const Task& cb)
+  { threadInitCallback_ = cb; }
+  /// Pins the i-th worker to cpuSets[i % cpuSets.size()],
+  /// see Thread::setCpuAffinity().
+  void setCpuAffinity(const std::vector<Thread::CpuSet>& cpuSets)
+  { cpuSets_ = cpuSets; }
+
+  void start(int numThreads);
+  /// Pending tasks are discarded, same as ThreadPool::stop().
+  void stop();
+
+  const string& name() const
+  { return name_; }
+
+  /// Approximate if workers are running.
+  size_t queueSize() const;
+
+  /// Thread safe, same as runLocal() if called in a worker of this pool.
+  void run(Task task);
+
+  /// Submits all of @c tasks with one lock, and clears @c tasks.
+  void runBatch(std::vector<Task>* tasks);
+
+  /// Pushes @c task to the deque of current worker, without locking,
+  /// eg. by a task which forks subtasks.  It is run by current worker
+  /// after the task at hand, unless stolen by another worker.
+  /// Falls back to run() if not called in a worker of this pool.
+  void runLocal(Task task);
+
+  /// Whether the caller is a worker thread of this pool.
+  bool inWorkerThread() const;
+
+ private:
+  typedef detail::WorkStealingWorker Worker;
+
+  void runInThread(int index);
+  Task* findTask(Worker* self);
+  Task* takeShared(Worker* self);
+  Task* steal(Worker* self);
+  void waitForTask();
+  bool hasTask() const REQUIRES(mutex_);
+  void pushShared(Task* task);
+  void wakeupIdle();
+  void clear();
+
+  mutable MutexLock mutex_;
+  Condition notEmpty_ GUARDED_BY(mutex_);
+  string name_;
+  Task threadInitCallback_;
+  std::vector<Thread::CpuSet> cpuSets_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<muduo::Thread>> threads_;
+  std::deque<Task*> queue_ GUARDED_BY(mutex_);
+  std::atomic<size_t> queueSize_;  // of queue_, for checking without lock
+  std::atomic<int> numIdle_;
+  std::atomic<bool> running_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
@@ -0,0 +1,118 @@
+#include "muduo/base/AsyncLogging.h"
+#include "muduo/base/LogFile.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+// Writes log files to current directory, in MB/s.
+
+const off_t kRollSize = 1000*1000*1000;
+
+enum Output { kStdio, kUnbuffered, kMapped };
+const char* kOutputNames[] = { "stdio", "unbuffered", "mapped" };
+
+void logThread(muduo::AsyncLogging* log, int64_t bytes)
+{
+  char line[128];
+  int len = snprintf(line, sizeof line,
+                     "20261019 04:05:06.123456Z 12345 INFO  Hello 0123456789"
+                     " abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ - bench.cc:42\n");
+  for (int64_t n = 0; n < bytes; n += len)
+  {
+    log->append(line, len);
+  }
+}
+
+void benchAsyncLogging(Output output, int numThreads, int64_t totalBytes)
+{
+  muduo::Timestamp start(muduo::Timestamp::now());
+  {
+    muduo::AsyncLogging log(muduo::string("asynclogging_bench_") + kOutputNames[output],
+                            kRollSize);
+    log.setOverflowPolicy(muduo::AsyncLogging::kBlock);
+    log.setUnbufferedOutput(output == kUnbuffered);
+    log.setMappedOutput(output == kMapped);
+    log.start();
+    std::vector<std::unique_ptr<muduo::Thread>> threads;
+    for (int i = 0; i < numThreads; ++i)
+    {
+      threads.emplace_back(new muduo::Thread(
+            std::bind(logThread, &log, totalBytes / numThreads)));
+      threads.back()->start();
+    }
+    for (auto& thr : threads)
+    {
+      thr->join();
+    }
+    log.stop();
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  printf("AsyncLogging %-10s threads %2d  %7.1f MB/s\n",
+         kOutputNames[output], numThreads,
+         static_cast<double>(totalBytes) / seconds / 1e6);
+}
+
+// as AsyncLogging did, appends 4MB buffers one by one
+void benchLogFile(Output output, int64_t totalBytes)
+{
+  const int kBufferSize = 4*1000*1000;
+  const int kBuffers = 4;
+  std::vector<char> data(kBufferSize * kBuffers, 'x');
+  muduo::Timestamp start(muduo::Timestamp::now());
+  {
+    muduo::LogFile file(muduo::string("logfile_bench_") + kOutputNames[output],
+                        kRollSize, false, 3, 1024,
+                        output == kUnbuffered, output == kMapped);
+    for (int64_t n = 0; n < totalBytes; n += kBufferSize * kBuffers)
+    {
+      if (output != kStdio)
+      {
+        struct iovec iov[kBuffers];
+        for (int i = 0; i < kBuffers; ++i)
+        {
+          iov[i].iov_base = &data[i * kBufferSize];
+          iov[i].iov_len = kBufferSize;
+        }
+        file.appendv(iov, kBuffers);
+      }
+      else
+      {
+        for (int i = 0; i < kBuffers; ++i)
+        {
+          file.append(&data[i * kBufferSize], kBufferSize);
+        }
+      }
+      file.flush();
+    }
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  printf("LogFile      %-10s             %7.1f MB/s\n",
+         kOutputNames[output],
+         static_cast<double>(totalBytes) / seconds / 1e6);
+}
+
+int main(int argc, char* argv[])
+{
+  int64_t totalBytes = (argc > 1 ? atoi(argv[1]) : 500) * 1000LL * 1000;
+  printf("usage: %s [total_MB]\n", argv[0]);
+
+  const Output kOutputs[] = { kStdio, kUnbuffered, kMapped };
+  for (Output output : kOutputs)
+  {
+    benchLogFile(output, totalBytes);
+  }
+  const int kThreads[] = { 1, 4, 16 };
+  for (int threads : kThreads)
+  {
+    for (Output output : kOutputs)
+    {
+      benchAsyncLogging(output, threads, totalBytes);
+    }
+  }
+}
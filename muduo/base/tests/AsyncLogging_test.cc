@@ -1,8 +1,13 @@
 #include "muduo/base/AsyncLogging.h"
 #include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
 
+#include <vector>
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <unistd.h>
 
@@ -17,8 +22,6 @@ void asyncOutput(const char* msg, int len)
 
 void bench(bool longLog)
 {
-  muduo::Logger::setOutput(asyncOutput);
-
   int cnt = 0;
   const int kBatch = 1000;
   muduo::string empty = " ";
@@ -56,9 +59,33 @@ int main(int argc, char* argv[])
   char name[256] = { '\0' };
   strncpy(name, argv[0], sizeof name - 1);
   muduo::AsyncLogging log(::basename(name), kRollSize);
+  // usage: asynclogging_test [long [threads [block|drop|sample]]]
+  if (argc > 3)
+  {
+    muduo::AsyncLogging::OverflowPolicy policy =
+        strcmp(argv[3], "block") == 0 ? muduo::AsyncLogging::kBlock :
+        strcmp(argv[3], "sample") == 0 ? muduo::AsyncLogging::kSample :
+        muduo::AsyncLogging::kDrop;
+    log.setOverflowPolicy(policy);
+  }
   log.start();
   g_asyncLog = &log;
+  muduo::Logger::setOutput(asyncOutput);
 
-  bool longLog = argc > 1;
+  bool longLog = argc > 1 && strcmp(argv[1], "long") == 0;
+  int numThreads = argc > 2 ? atoi(argv[2]) : 1;
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 1; i < numThreads; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(std::bind(bench, longLog)));
+    threads.back()->start();
+  }
   bench(longLog);
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  printf("dropped %ld messages, %ld bytes\n",
+         static_cast<long>(log.droppedMessages()),
+         static_cast<long>(log.droppedBytes()));
 }
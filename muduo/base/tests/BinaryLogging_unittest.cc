@@ -0,0 +1,135 @@
+#include "muduo/base/BinaryLogging.h"
+
+#include <string>
+
+//#define BOOST_TEST_MODULE BinaryLoggingTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+namespace binlog = muduo::binlog;
+
+namespace
+{
+
+string g_records;
+
+void saveRecord(const char* record, int len)
+{
+  g_records.append(record, len);
+}
+
+// message between "INFO  " and " - "
+string message(const string& line)
+{
+  size_t start = line.find("INFO  ");
+  size_t end = line.rfind(" - ");
+  if (start == string::npos || end == string::npos || end < start)
+  {
+    return line;
+  }
+  return line.substr(start + 6, end - start - 6);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testBinaryLoggingRender)
+{
+  muduo::BinaryLogger::setOutput(saveRecord);
+  g_records.clear();
+  string name("conn");
+  LOGB_INFO("{} read {} bytes, {} {} {}", name, 42, 3.5, 'x', true);
+  LOGB_INFO("{} and {}", muduo::StringPiece("a"));
+  LOGB_INFO("no placeholder", -1L, 2ULL);
+  LOGB_DEBUG("debug {}", 1);  // below log level
+
+  binlog::Decoder decoder;
+  decoder.setUseRegistry(true);
+  string text;
+  BOOST_CHECK_EQUAL(decoder.decode(g_records.data(), g_records.size(), &text),
+                    g_records.size());
+  BOOST_CHECK_EQUAL(decoder.badRecords(), 0);
+
+  size_t first = text.find('\n');
+  size_t second = text.find('\n', first + 1);
+  BOOST_REQUIRE(second != string::npos);
+  BOOST_CHECK_EQUAL(text.size(), text.find('\n', second + 1) + 1);
+  BOOST_CHECK_EQUAL(message(text.substr(0, first)), "conn read 42 bytes, 3.5 x 1");
+  BOOST_CHECK_EQUAL(message(text.substr(first + 1, second - first - 1)), "a and {}");
+  BOOST_CHECK_EQUAL(message(text.substr(second + 1)), "no placeholder -1 2");
+  BOOST_CHECK(text.find(" - BinaryLogging_unittest.cc:") != string::npos);
+  BOOST_CHECK_EQUAL(text[24], 'Z');  // 20261019 04:05:06.123456Z
+}
+
+BOOST_AUTO_TEST_CASE(testBinaryLoggingFrames)
+{
+  muduo::BinaryLogger::setOutput(saveRecord);
+  g_records.clear();
+  string longString(2 * binlog::kMaxRecordSize, 'x');
+  LOGB_WARN("long {} {}", longString, 1);
+  LOGB_INFO("short");
+
+  binlog::Decoder unknown;
+  string text;
+  BOOST_CHECK_EQUAL(unknown.decode(g_records.data(), g_records.size(), &text),
+                    g_records.size());
+  BOOST_CHECK_EQUAL(unknown.badRecords(), 2);
+  BOOST_CHECK(text.find("UNKNOWN site") != string::npos);
+
+  // as written by AsyncLogging::setRawBinaryOutput()
+  string frames;
+  size_t first = binlog::frameLength(g_records.data(), g_records.size());
+  BOOST_REQUIRE(first > 0 && first <= static_cast<size_t>(binlog::kMaxRecordSize));
+  binlog::RecordHeader header;
+  for (size_t pos = 0; pos < g_records.size(); pos += header.frame.length)
+  {
+    memcpy(&header, g_records.data() + pos, sizeof header);
+    binlog::appendSite(*muduo::LogSite::find(header.site), &frames);
+  }
+  frames += g_records;
+
+  binlog::Decoder decoder;
+  text.clear();
+  // an incomplete frame is left
+  size_t n = decoder.decode(frames.data(), frames.size() - 1, &text);
+  BOOST_CHECK_EQUAL(n, frames.size() - (g_records.size() - first));
+  BOOST_CHECK_EQUAL(decoder.decode(frames.data() + n, frames.size() - n, &text),
+                    frames.size() - n);
+  BOOST_CHECK_EQUAL(decoder.badRecords(), 0);
+  BOOST_CHECK(text.find("WARN  long xxx") != string::npos);
+  BOOST_CHECK(text.find("x 1 - ") == string::npos);  // 1 does not fit
+  BOOST_CHECK(text.find("INFO  short - BinaryLogging_unittest.cc:") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(testBinaryLoggingBadSiteId)
+{
+  muduo::BinaryLogger::setOutput(saveRecord);
+  g_records.clear();
+  LOGB_INFO("site {}", 1);
+  binlog::RecordHeader header;
+  memcpy(&header, g_records.data(), sizeof header);
+  string site;
+  binlog::appendSite(*muduo::LogSite::find(header.site), &site);
+
+  // site ids from a corrupted file
+  string frames;
+  const int32_t ids[] = { -1, binlog::kMaxSites, INT32_MAX };
+  for (int32_t id : ids)
+  {
+    string bad(site);
+    memcpy(&bad[sizeof(binlog::FrameHeader)], &id, sizeof id);
+    frames += bad;
+  }
+  binlog::Decoder decoder;
+  string text;
+  BOOST_CHECK_EQUAL(decoder.decode(frames.data(), frames.size(), &text), frames.size());
+  BOOST_CHECK_EQUAL(decoder.badRecords(), 3);
+  BOOST_CHECK(text.empty());
+
+  // good ones still decode
+  frames = site + g_records;
+  BOOST_CHECK_EQUAL(decoder.decode(frames.data(), frames.size(), &text), frames.size());
+  BOOST_CHECK_EQUAL(decoder.badRecords(), 3);
+  BOOST_CHECK_EQUAL(message(text.substr(0, text.size() - 1)), "site 1");
+}
@@ -1,14 +1,19 @@
 #include "muduo/base/BlockingQueue.h"
+#include "muduo/base/BoundedBlockingQueue.h"
 #include "muduo/base/CountDownLatch.h"
+#include "muduo/base/MpmcQueue.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <vector>
 #include <stdio.h>
 #include <unistd.h>
 
+using std::placeholders::_1;
+
 class Bench
 {
  public:
@@ -96,11 +101,151 @@ class Bench
   std::vector<std::unique_ptr<muduo::Thread>> threads_;
 };
 
+// Throughput of items passed from producers to consumers.
+const int kStop = -1;
+const size_t kBatch = 64;
+
+template<typename Queue>
+void produce(Queue* queue, int n)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    queue->put(i);
+  }
+}
+
+void produceBatch(muduo::MpmcQueue<int>* queue, int n)
+{
+  int items[kBatch];
+  int i = 0;
+  while (i < n)
+  {
+    size_t k = 0;
+    while (k < kBatch && i < n)
+    {
+      items[k++] = i++;
+    }
+    queue->putBatch(items, k);
+  }
+}
+
+template<typename Queue>
+void consume(Queue* queue, std::atomic<int64_t>* count)
+{
+  int64_t n = 0;
+  while (queue->take() != kStop)
+  {
+    ++n;
+  }
+  *count += n;
+}
+
+void consumeBatch(muduo::MpmcQueue<int>* queue, std::atomic<int64_t>* count)
+{
+  int items[kBatch];
+  int64_t n = 0;
+  bool running = true;
+  while (running)
+  {
+    size_t k = queue->takeBatch(items, kBatch);
+    for (size_t i = 0; i < k; ++i)
+    {
+      if (items[i] == kStop)
+      {
+        // stops are put after all items, leave the rest for other consumers
+        for (size_t j = i + 1; j < k; ++j)
+        {
+          queue->put(kStop);
+        }
+        running = false;
+        break;
+      }
+      ++n;
+    }
+  }
+  *count += n;
+}
+
+template<typename Queue>
+void benchThroughput(const char* name, Queue* queue,
+                     int producers, int consumers, int items,
+                     const std::function<void (int)>& producer,
+                     const std::function<void (std::atomic<int64_t>*)>& consumer)
+{
+  std::atomic<int64_t> count(0);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (int i = 0; i < consumers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(std::bind(consumer, &count), "consumer"));
+    threads.back()->start();
+  }
+  std::vector<std::unique_ptr<muduo::Thread>> producerThreads;
+  for (int i = 0; i < producers; ++i)
+  {
+    producerThreads.emplace_back(new muduo::Thread(std::bind(producer, items / producers),
+                                                   "producer"));
+    producerThreads.back()->start();
+  }
+  for (auto& thr : producerThreads)
+  {
+    thr->join();
+  }
+  for (int i = 0; i < consumers; ++i)
+  {
+    queue->put(kStop);
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  int64_t expected = static_cast<int64_t>(items / producers) * producers;
+  printf("%-20s producers %d consumers %d  %.3f s  %10.0f items/s%s\n",
+         name, producers, consumers, seconds,
+         static_cast<double>(count) / seconds,
+         count == expected ? "" : "  WRONG COUNT");
+}
+
+void benchAllThroughput(int items)
+{
+  const int kCapacity = 1024;
+  const int kCounts[] = { 1, 2, 4 };
+  for (int producers : kCounts)
+  {
+    for (int consumers : kCounts)
+    {
+      muduo::BlockingQueue<int> blocking;
+      benchThroughput("BlockingQueue", &blocking, producers, consumers, items,
+                      std::bind(produce<muduo::BlockingQueue<int>>, &blocking, _1),
+                      std::bind(consume<muduo::BlockingQueue<int>>, &blocking, _1));
+
+      muduo::BoundedBlockingQueue<int> bounded(kCapacity);
+      benchThroughput("BoundedBlockingQueue", &bounded, producers, consumers, items,
+                      std::bind(produce<muduo::BoundedBlockingQueue<int>>, &bounded, _1),
+                      std::bind(consume<muduo::BoundedBlockingQueue<int>>, &bounded, _1));
+
+      muduo::MpmcQueue<int> mpmc(kCapacity);
+      benchThroughput("MpmcQueue", &mpmc, producers, consumers, items,
+                      std::bind(produce<muduo::MpmcQueue<int>>, &mpmc, _1),
+                      std::bind(consume<muduo::MpmcQueue<int>>, &mpmc, _1));
+
+      muduo::MpmcQueue<int> batch(kCapacity);
+      benchThroughput("MpmcQueue batch", &batch, producers, consumers, items,
+                      std::bind(produceBatch, &batch, _1),
+                      std::bind(consumeBatch, &batch, _1));
+    }
+  }
+}
+
 int main(int argc, char* argv[])
 {
   int threads = argc > 1 ? atoi(argv[1]) : 1;
+  int items = argc > 2 ? atoi(argv[2]) : 1000000;
 
   Bench t(threads);
   t.run(10000);
   t.joinAll();
+
+  benchAllThroughput(items);
 }
@@ -0,0 +1,67 @@
+#include "muduo/base/FileUtil.h"
+
+#include <sys/uio.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+
+BOOST_AUTO_TEST_CASE(testMappedAppendFile)
+{
+  const char* filename = "/tmp/muduo_fileutil_unittest_mapped";
+  ::unlink(filename);
+  string expected;
+  {
+    // a page per segment, lines cross segments
+    FileUtil::MappedAppendFile file(filename, 1);
+    for (int i = 0; i < 1000; ++i)
+    {
+      char line[64];
+      int len = snprintf(line, sizeof line, "line %d of mapped file\n", i);
+      file.append(line, len);
+      expected.append(line, len);
+      if (i % 100 == 0)
+      {
+        file.flush();
+      }
+    }
+    struct iovec iov[2] = {
+      { const_cast<char*>("iov0 "), 5 },
+      { const_cast<char*>("iov1\n"), 5 },
+    };
+    file.appendv(iov, 2);
+    expected += "iov0 iov1\n";
+    BOOST_CHECK_EQUAL(file.writtenBytes(), static_cast<off_t>(expected.size()));
+  }
+  {
+    // appends after existing records
+    FileUtil::MappedAppendFile file(filename, 64*1024);
+    file.append("reopened\n", 9);
+    expected += "reopened\n";
+  }
+  string content;
+  int64_t size = 0;
+  int err = FileUtil::readFile(filename, 1024*1024, &content, &size);
+  BOOST_CHECK_EQUAL(err, 0);
+  BOOST_CHECK_EQUAL(size, static_cast<int64_t>(expected.size()));
+  BOOST_CHECK(content == expected);
+  ::unlink(filename);
+}
+
+BOOST_AUTO_TEST_CASE(testAppendFileWriteError)
+{
+  // every write(2) fails with ENOSPC
+  FileUtil::AppendFile file("/dev/full", true);
+  file.append("lost\n", 5);
+  BOOST_CHECK_EQUAL(file.writtenBytes(), 0);
+  struct iovec iov[2] = {
+    { const_cast<char*>("iov0 "), 5 },
+    { const_cast<char*>("iov1\n"), 5 },
+  };
+  file.appendv(iov, 2);
+  BOOST_CHECK_EQUAL(file.writtenBytes(), 0);
+}
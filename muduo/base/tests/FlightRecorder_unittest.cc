@@ -0,0 +1,235 @@
+#include "muduo/base/FlightRecorder.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/FileUtil.h"
+#include "muduo/base/Thread.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE FlightRecorderTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::FlightRecorder;
+using muduo::Logger;
+using muduo::string;
+
+namespace
+{
+
+string g_output;
+char g_dumpFile[64];
+
+void saveOutput(const char* msg, int len)
+{
+  g_output.append(msg, len);
+}
+
+int count(const string& text, const string& word)
+{
+  int n = 0;
+  for (size_t pos = text.find(word); pos != string::npos; pos = text.find(word, pos + 1))
+  {
+    ++n;
+  }
+  return n;
+}
+
+struct RecorderFixture
+{
+  RecorderFixture()
+  {
+    if (!FlightRecorder::started())
+    {
+      snprintf(g_dumpFile, sizeof g_dumpFile, "/tmp/flightrecorder_unittest.%d", getpid());
+      FlightRecorder::start(g_dumpFile, Logger::DEBUG, 4096);
+    }
+    Logger::setLogLevel(Logger::INFO);
+    Logger::setOutput(saveOutput);
+    g_output.clear();
+  }
+};
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_CASE(testRecordBelowLogLevel, RecorderFixture)
+{
+  BOOST_CHECK_EQUAL(Logger::logLevel(), Logger::INFO);
+  BOOST_CHECK_EQUAL(Logger::minLogLevel(), Logger::DEBUG);
+  LOG_TRACE << "trace 1";
+  LOG_DEBUG << "debug 1";
+  LOG_INFO << "info 1";
+  BOOST_CHECK_EQUAL(count(g_output, "debug 1"), 0);
+  BOOST_CHECK_EQUAL(count(g_output, "info 1"), 1);
+
+  string text = FlightRecorder::snapshot();
+  BOOST_CHECK_EQUAL(count(text, "trace 1"), 0);
+  size_t debug = text.find("DEBUG test_method debug 1");
+  size_t info = text.find("INFO  info 1");
+  BOOST_CHECK(debug != string::npos);
+  BOOST_CHECK(info != string::npos);
+  BOOST_CHECK(debug < info);
+}
+
+BOOST_FIXTURE_TEST_CASE(testWrapAround, RecorderFixture)
+{
+  for (int i = 0; i < 1000; ++i)
+  {
+    LOG_DEBUG << "wrap " << i << " ";
+  }
+  string text = FlightRecorder::snapshot();
+  BOOST_CHECK_EQUAL(count(text, "wrap 0 "), 0);
+  BOOST_CHECK_EQUAL(count(text, "wrap 999 "), 1);
+  // whole lines only, and the newest kept
+  int lines = count(text, "\n");
+  BOOST_CHECK(lines > 10 && lines < 100);
+  BOOST_CHECK_EQUAL(count(text, "wrap "), lines);
+  BOOST_CHECK_EQUAL(count(text, "wrap " + std::to_string(1000 - lines) + " "), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(testThreads, RecorderFixture)
+{
+  // alive together, a ring of each
+  muduo::CountDownLatch done(1);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < 4; ++i)
+  {
+    muduo::CountDownLatch logged(1);
+    threads.emplace_back(new muduo::Thread([i, &logged, &done] {
+      for (int j = 0; j < 10; ++j)
+      {
+        LOG_DEBUG << "thread " << i << " line " << j;
+      }
+      logged.countDown();
+      done.wait();
+    }));
+    threads.back()->start();
+    logged.wait();
+  }
+  done.countDown();
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  string text = FlightRecorder::snapshot();
+  for (int i = 0; i < 4; ++i)
+  {
+    BOOST_CHECK_EQUAL(count(text, "thread " + std::to_string(i) + " line "), 10);
+  }
+  // ordered by time across threads
+  BOOST_CHECK(text.find("thread 0 line 9") < text.find("thread 3 line 0"));
+}
+
+BOOST_FIXTURE_TEST_CASE(testDump, RecorderFixture)
+{
+  LOG_DEBUG << "dumped line";
+  BOOST_REQUIRE(FlightRecorder::dump());
+  string data;
+  BOOST_REQUIRE_EQUAL(muduo::FileUtil::readFile(g_dumpFile, 64*1024*1024, &data), 0);
+  string text;
+  BOOST_CHECK(FlightRecorder::decode(data.data(), data.size(), &text) > 0);
+  BOOST_CHECK_EQUAL(text, FlightRecorder::snapshot());
+  BOOST_CHECK_EQUAL(count(text, "dumped line"), 1);
+  BOOST_CHECK_EQUAL(FlightRecorder::decode("not a dump", 10, &text), -1);
+  ::unlink(g_dumpFile);
+}
+
+BOOST_FIXTURE_TEST_CASE(testFatalSignal, RecorderFixture)
+{
+  pid_t child = fork();
+  if (child == 0)
+  {
+    // not the handler of Boost.Test
+    ::signal(SIGSEGV, SIG_DFL);
+    FlightRecorder::installSignalHandlers();
+    LOG_DEBUG << "last words";
+    ::raise(SIGSEGV);
+    _exit(0);
+  }
+  int status = 0;
+  BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+  BOOST_CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+
+  string data;
+  BOOST_REQUIRE_EQUAL(muduo::FileUtil::readFile(g_dumpFile, 64*1024*1024, &data), 0);
+  string text;
+  FlightRecorder::decode(data.data(), data.size(), &text);
+  BOOST_CHECK_EQUAL(count(text, "last words"), 1);
+  ::unlink(g_dumpFile);
+}
+
+BOOST_FIXTURE_TEST_CASE(testChainedSignalHandler, RecorderFixture)
+{
+  pid_t child = fork();
+  if (child == 0)
+  {
+    ::signal(SIGSEGV, [](int) { _exit(42); });
+    FlightRecorder::installSignalHandlers();
+    stack_t ss;
+    if (::sigaltstack(NULL, &ss) < 0 || (ss.ss_flags & SS_DISABLE))
+    {
+      _exit(1);
+    }
+    LOG_DEBUG << "chained";
+    ::raise(SIGSEGV);
+    _exit(0);
+  }
+  int status = 0;
+  BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+  BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 42);
+
+  string data;
+  BOOST_REQUIRE_EQUAL(muduo::FileUtil::readFile(g_dumpFile, 64*1024*1024, &data), 0);
+  string text;
+  FlightRecorder::decode(data.data(), data.size(), &text);
+  BOOST_CHECK_EQUAL(count(text, "chained"), 1);
+  ::unlink(g_dumpFile);
+}
+
+BOOST_FIXTURE_TEST_CASE(testRingReused, RecorderFixture)
+{
+  muduo::Thread first([] { LOG_DEBUG << "first owner"; });
+  first.start();
+  first.join();
+  BOOST_CHECK_EQUAL(count(FlightRecorder::snapshot(), "first owner"), 1);
+
+  // takes the ring released by first
+  muduo::Thread second([] { LOG_DEBUG << "second owner"; });
+  second.start();
+  second.join();
+  string text = FlightRecorder::snapshot();
+  BOOST_CHECK_EQUAL(count(text, "first owner"), 0);
+  BOOST_CHECK_EQUAL(count(text, "second owner"), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(testLogFromKeyDestructor, RecorderFixture)
+{
+  static pthread_key_t key;
+  static int secondRound;
+  // logs in 2nd round of key destructors, after the ring is released
+  pthread_key_create(&key, [](void* round) {
+    if (round != &secondRound)
+    {
+      pthread_setspecific(key, &secondRound);
+    }
+    else
+    {
+      LOG_DEBUG << "key destructor";
+    }
+  });
+  muduo::Thread thread([] {
+    LOG_DEBUG << "thread exiting";
+    pthread_setspecific(key, &key);
+  });
+  thread.start();
+  thread.join();
+  pthread_key_delete(key);
+
+  string text = FlightRecorder::snapshot();
+  BOOST_CHECK_EQUAL(count(text, "thread exiting"), 1);
+  BOOST_CHECK_EQUAL(count(text, "key destructor"), 0);
+}
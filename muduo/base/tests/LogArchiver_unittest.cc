@@ -0,0 +1,154 @@
+#include "muduo/base/LogArchiver.h"
+#include "muduo/base/GzipFile.h"
+#include "muduo/base/LogFile.h"
+#include "muduo/base/Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+
+namespace
+{
+
+// runs all tests in a temporary directory
+struct TempDir
+{
+  TempDir()
+  {
+    snprintf(dir, sizeof dir, "/tmp/logarchiver_unittest.XXXXXX");
+    if (::mkdtemp(dir) == NULL || ::chdir(dir) != 0)
+    {
+      perror("TempDir");
+      abort();
+    }
+  }
+
+  ~TempDir()
+  {
+    if (::system((string("rm -rf ") + dir).c_str()) != 0)
+    {
+      fprintf(stderr, "failed to remove %s\n", dir);
+    }
+  }
+
+  char dir[64];
+};
+
+bool exists(const string& filename)
+{
+  struct stat statbuf;
+  return ::stat(filename.c_str(), &statbuf) == 0;
+}
+
+string gunzip(const string& filename)
+{
+  string content;
+  muduo::GzipFile gz = muduo::GzipFile::openForRead(filename);
+  BOOST_REQUIRE(gz.valid());
+  char buf[4096];
+  int n = 0;
+  while ((n = gz.read(buf, sizeof buf)) > 0)
+  {
+    content.append(buf, n);
+  }
+  return content;
+}
+
+string makeLog(int day, int lines)
+{
+  char filename[64];
+  snprintf(filename, sizeof filename, "archived.202610%02d-000000.host.1.log", day);
+  FILE* fp = ::fopen(filename, "w");
+  BOOST_REQUIRE(fp != NULL);
+  for (int i = 0; i < lines; ++i)
+  {
+    fprintf(fp, "day %d line %d of a log file to be compressed\n", day, i);
+  }
+  ::fclose(fp);
+  return filename;
+}
+
+}  // namespace
+
+BOOST_GLOBAL_FIXTURE(TempDir);
+
+BOOST_AUTO_TEST_CASE(testRetention)
+{
+  muduo::LogArchiver archiver("archived");
+  archiver.setMaxFiles(2);
+  archiver.setRateLimit(0);
+  archiver.start();
+  string oldest;
+  string newest;
+  for (int day = 1; day <= 3; ++day)
+  {
+    newest = makeLog(day, 1000);
+    if (day == 1)
+    {
+      oldest = newest;
+    }
+    archiver.archive(newest);
+  }
+  FILE* fp = ::fopen(newest.c_str(), "r");
+  string expected(100*1000, '\0');
+  expected.resize(::fread(&expected[0], 1, expected.size(), fp));
+  ::fclose(fp);
+  archiver.stop();
+
+  BOOST_CHECK_EQUAL(archiver.archivedFiles(), 3);
+  BOOST_CHECK(!exists(newest));
+  BOOST_CHECK(!exists(newest + ".gz.tmp"));
+  BOOST_CHECK(exists(newest + ".gz"));
+  BOOST_CHECK(gunzip(newest + ".gz") == expected);
+  // the oldest removed
+  BOOST_CHECK(!exists(oldest + ".gz"));
+  BOOST_CHECK(!exists(oldest));
+}
+
+BOOST_AUTO_TEST_CASE(testGzipCloseError)
+{
+  // small enough to stay buffered until close
+  muduo::GzipFile gz = muduo::GzipFile::openForWriteTruncate("/dev/full");
+  BOOST_REQUIRE(gz.valid());
+  BOOST_CHECK_EQUAL(gz.write("hello"), 5);
+  BOOST_CHECK(gz.close() != Z_OK);
+  BOOST_CHECK(!gz.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testRateLimit)
+{
+  muduo::LogArchiver archiver("limited");
+  archiver.setRateLimit(1000*1000);
+  archiver.start();
+  string filename = makeLog(9, 10*1000);  // about 500KB
+  ::rename(filename.c_str(), "limited.log");
+  muduo::Timestamp start(muduo::Timestamp::now());
+  archiver.archive("limited.log");
+  archiver.stop();
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  BOOST_CHECK(exists("limited.log.gz"));
+  BOOST_CHECK_GT(seconds, 0.2);
+}
+
+BOOST_AUTO_TEST_CASE(testLogFileRoll)
+{
+  muduo::LogArchiver archiver("rolled");
+  archiver.start();
+  {
+    muduo::LogFile file("rolled", 1000*1000);
+    file.setRollCallback(std::bind(&muduo::LogArchiver::archive, &archiver, std::placeholders::_1));
+    file.append("first file\n", 11);
+    ::sleep(1);
+    BOOST_CHECK(file.rollFile());
+    file.append("second file\n", 12);
+  }
+  archiver.stop();
+  BOOST_CHECK_EQUAL(archiver.archivedFiles(), 1);
+}
@@ -1,3 +1,4 @@
+#include "muduo/base/BinaryLogging.h"
 #include "muduo/base/LogStream.h"
 #include "muduo/base/Timestamp.h"
 
@@ -55,6 +56,108 @@ void benchLogStream()
   printf("benchLogStream %f\n", timeDifference(end, start));
 }
 
+// prices and latencies, not integers
+double price(size_t i)
+{
+  return static_cast<double>(i % 100000) * 0.01 + 100;
+}
+
+void benchDoubles()
+{
+  char buf[64];
+  double sum = 0;
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+  {
+    snprintf(buf, sizeof buf, "%.17g", price(i));
+    sum += buf[0];
+  }
+  Timestamp end(Timestamp::now());
+  printf("benchPrintf %%.17g %f\n", timeDifference(end, start));
+
+  LogStream os;
+  start = Timestamp::now();
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << price(i);
+    os.resetBuffer();
+  }
+  end = Timestamp::now();
+  printf("benchLogStream shortest %f\n", timeDifference(end, start));
+
+  start = Timestamp::now();
+  for (size_t i = 0; i < N; ++i)
+  {
+    snprintf(buf, sizeof buf, "%.4f", price(i));
+    sum += buf[0];
+  }
+  end = Timestamp::now();
+  printf("benchPrintf %%.4f %f\n", timeDifference(end, start));
+
+  start = Timestamp::now();
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << Fmt("%.4f", price(i));
+    os.resetBuffer();
+  }
+  end = Timestamp::now();
+  printf("benchFmt %%.4f %f\n", timeDifference(end, start));
+  (void)sum;
+}
+
+void nullOutput(const char*, int)
+{
+}
+
+string g_records;
+
+void saveRecord(const char* record, int len)
+{
+  g_records.append(record, len);
+}
+
+// whole log statements, to an output which discards
+void benchLogging()
+{
+  Logger::setLogLevel(Logger::DEBUG);
+  Logger::setOutput(nullOutput);
+  BinaryLogger::setOutput(nullOutput);
+  const char* name = "127.0.0.1:2000";
+
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+  {
+    LOG_DEBUG << "conn " << name << " read " << i << " bytes " << 0.5;
+  }
+  Timestamp end(Timestamp::now());
+  printf("benchLogDebug %f\n", timeDifference(end, start));
+
+  start = Timestamp::now();
+  for (size_t i = 0; i < N; ++i)
+  {
+    LOGB_DEBUG("conn {} read {} bytes {}", name, i, 0.5);
+  }
+  end = Timestamp::now();
+  printf("benchLogBinaryDebug %f\n", timeDifference(end, start));
+
+  // cost moved to the background thread
+  g_records.reserve(N * 64);
+  BinaryLogger::setOutput(saveRecord);
+  for (size_t i = 0; i < N; ++i)
+  {
+    LOGB_DEBUG("conn {} read {} bytes {}", name, i, 0.5);
+  }
+  binlog::Decoder decoder;
+  decoder.setUseRegistry(true);
+  string text;
+  text.reserve(N * 128);
+  start = Timestamp::now();
+  decoder.decode(g_records.data(), g_records.size(), &text);
+  end = Timestamp::now();
+  printf("benchLogBinaryRender %f\n", timeDifference(end, start));
+  Logger::setLogLevel(Logger::INFO);
+}
+
 int main()
 {
   benchPrintf<int>("%d");
@@ -79,4 +182,9 @@ int main()
   benchStringStream<void*>();
   benchLogStream<void*>();
 
+  puts("prices");
+  benchDoubles();
+
+  puts("logging");
+  benchLogging();
 }
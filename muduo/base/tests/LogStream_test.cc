@@ -1,7 +1,11 @@
 #include "muduo/base/LogStream.h"
 
+#include <cmath>
 #include <limits>
+#include <random>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 //#define BOOST_TEST_MODULE LogStreamTest
 #define BOOST_TEST_MAIN
@@ -151,7 +155,7 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
   os.resetBuffer();
 
   os << a+b;
-  BOOST_CHECK_EQUAL(buf.toString(), string("0.15"));
+  BOOST_CHECK_EQUAL(buf.toString(), string("0.15000000000000002"));
   os.resetBuffer();
 
   BOOST_CHECK(a+b != c);
@@ -167,6 +171,119 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
   os << -123.456;
   BOOST_CHECK_EQUAL(buf.toString(), string("-123.456"));
   os.resetBuffer();
+
+  os << 1e23 << ' ' << 1e-5 << ' ' << 0.0001 << ' ' << 1e16 << ' ' << 1e17;
+  BOOST_CHECK_EQUAL(buf.toString(), string("1e+23 1e-05 0.0001 10000000000000000 1e+17"));
+  os.resetBuffer();
+
+  os << -0.0 << ' ' << 5e-324 << ' ' << std::numeric_limits<double>::max();
+  BOOST_CHECK_EQUAL(buf.toString(), string("-0 5e-324 1.7976931348623157e+308"));
+  os.resetBuffer();
+
+  os << std::numeric_limits<double>::infinity() << ' '
+     << -std::numeric_limits<double>::infinity() << ' '
+     << std::numeric_limits<double>::quiet_NaN();
+  BOOST_CHECK_EQUAL(buf.toString(), string("inf -inf nan"));
+  os.resetBuffer();
+}
+
+namespace
+{
+
+// digits and exponent, e.g. "-12345e-3" of "-12.345" and "1.2345e+1"
+string canonical(const string& str)
+{
+  string sign(str[0] == '-' ? "-" : "");
+  string digits;
+  int point = -1;
+  size_t i = sign.size();
+  for (; i < str.size() && str[i] != 'e'; ++i)
+  {
+    if (str[i] == '.')
+      point = static_cast<int>(digits.size());
+    else
+      digits += str[i];
+  }
+  int exponent = i < str.size() ? atoi(str.c_str() + i + 1) : 0;
+  exponent += (point < 0 ? 0 : point - static_cast<int>(digits.size()));
+  digits.erase(0, std::min(digits.find_first_not_of('0'), digits.size() - 1));
+  while (digits.size() > 1 && digits[digits.size() - 1] == '0')
+  {
+    digits.erase(digits.size() - 1);
+    ++exponent;
+  }
+  return sign + digits + "e" + std::to_string(exponent);
+}
+
+double randomDouble(std::mt19937_64& rng, int i)
+{
+  if (i % 3 == 0)
+  {
+    return static_cast<double>(rng() % 10000000) / 100.0;  // prices
+  }
+  if (i % 3 == 1)
+  {
+    return static_cast<double>(rng() % 100000) * 1e-6;  // latencies
+  }
+  uint64_t bits = rng();
+  double v = 0;
+  memcpy(&v, &bits, sizeof v);
+  return std::isfinite(v) ? v : 1.0;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testLogStreamShortestDoubles)
+{
+  std::mt19937_64 rng(42);
+  muduo::LogStream os;
+  const muduo::LogStream::Buffer& buf = os.buffer();
+  for (int i = 0; i < 100000; ++i)
+  {
+    double v = randomDouble(rng, i);
+    os << v;
+    string str = buf.toString();
+    os.resetBuffer();
+    BOOST_CHECK_EQUAL(strtod(str.c_str(), NULL), v);
+
+    // the least precision of snprintf(3) which reads back
+    char expected[64];
+    for (int precision = 0; precision < 17; ++precision)
+    {
+      snprintf(expected, sizeof expected, "%.*e", precision, v);
+      if (strtod(expected, NULL) == v)
+        break;
+    }
+    BOOST_CHECK_EQUAL(canonical(str), canonical(expected));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testLogStreamFixedDoubles)
+{
+  std::mt19937_64 rng(43);
+  char expected[512];
+  for (int i = 0; i < 30000; ++i)
+  {
+    double v = randomDouble(rng, i);
+    for (int precision = 0; precision <= 17; ++precision)
+    {
+      snprintf(expected, sizeof expected, "%.*f", precision, v);
+      if (strlen(expected) < 32)
+      {
+        muduo::Fmt fmt(muduo::Fmt::fixed(v, precision));
+        BOOST_CHECK_EQUAL(string(fmt.data(), fmt.length()), string(expected));
+      }
+    }
+  }
+
+  muduo::LogStream os;
+  const muduo::LogStream::Buffer& buf = os.buffer();
+  os << muduo::Fmt("%.2f", 2.675) << ' ' << muduo::Fmt("%.2f", 0.125) << ' '
+     << muduo::Fmt("%.0f", 2.5) << ' ' << muduo::Fmt("%f", -0.0) << ' '
+     << muduo::Fmt("%.0f", 1e20f) << ' ' << muduo::Fmt::fixed(1.5, 18);
+  // beyond 2^64 or of precision 18, by snprintf(3)
+  BOOST_CHECK_EQUAL(buf.toString(), string("2.67 0.12 2 -0.000000 100000002004087734272"
+                                           " 1.500000000000000000"));
 }
 
 BOOST_AUTO_TEST_CASE(testLogStreamVoid)
@@ -0,0 +1,232 @@
+// LOG_TRACE and LOG_DEBUG are removed at compile time
+#define MUDUO_MIN_LOG_LEVEL 2
+
+#include "muduo/base/BinaryLogging.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/TimeZone.h"
+
+//#define BOOST_TEST_MODULE LoggingTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+
+#include <stdio.h>
+#include <unistd.h>
+
+using muduo::Logger;
+using muduo::string;
+
+namespace
+{
+
+string g_output;
+
+void saveOutput(const char* msg, int len)
+{
+  g_output.append(msg, len);
+}
+
+void saveRecord(const char* record, int len)
+{
+  g_output.append(record, len);
+}
+
+int lines()
+{
+  int n = 0;
+  for (char c : g_output)
+  {
+    n += c == '\n';
+  }
+  return n;
+}
+
+int g_evaluated = 0;
+
+int evaluate()
+{
+  return ++g_evaluated;
+}
+
+}  // namespace
+
+static_assert(Logger::SourceFile::basenameOffset("") == 0, "empty");
+static_assert(Logger::SourceFile::basenameOffset("a.cc") == 0, "no slash");
+static_assert(Logger::SourceFile::basenameOffset("/a/bc/d.cc") == 6, "path");
+static_assert(Logger::SourceFile::basenameOffset("dir/") == 4, "directory");
+
+BOOST_AUTO_TEST_CASE(testSourceFile)
+{
+  Logger::SourceFile file("/usr/src/muduo/Logging.cc");
+  BOOST_CHECK_EQUAL(string(file.data_, file.size_), "Logging.cc");
+  Logger::SourceFile path(MUDUO_SOURCE_FILE);
+  BOOST_CHECK_EQUAL(string(path.data_, path.size_), "Logging_unittest.cc");
+  const char* name = "base/Timestamp.cc";
+  Logger::SourceFile runtime(name);
+  BOOST_CHECK_EQUAL(string(runtime.data_, runtime.size_), "Timestamp.cc");
+}
+
+BOOST_AUTO_TEST_CASE(testMinLogLevel)
+{
+  Logger::setOutput(saveOutput);
+  Logger::setLogLevel(Logger::TRACE);
+  LOG_TRACE << "trace " << evaluate();
+  LOG_DEBUG << "debug " << evaluate();
+  BOOST_CHECK_EQUAL(g_evaluated, 0);
+  BOOST_CHECK(g_output.empty());
+
+  LOG_INFO << "info " << evaluate();
+  BOOST_CHECK_EQUAL(g_evaluated, 1);
+  BOOST_CHECK(g_output.find("INFO  info 1 - Logging_unittest.cc:") != string::npos);
+
+  g_output.clear();
+  muduo::BinaryLogger::setOutput(saveRecord);
+  LOGB_DEBUG("debug {}", evaluate());
+  BOOST_CHECK_EQUAL(g_evaluated, 1);
+  BOOST_CHECK(g_output.empty());
+  LOGB_INFO("info {}", evaluate());
+  BOOST_CHECK_EQUAL(g_evaluated, 2);
+  BOOST_CHECK(!g_output.empty());
+  Logger::setLogLevel(Logger::INFO);
+}
+
+BOOST_AUTO_TEST_CASE(testLogEveryN)
+{
+  Logger::setOutput(saveOutput);
+  g_output.clear();
+  for (int i = 0; i < 10; ++i)
+  {
+    LOG_EVERY_N(INFO, 3) << "every3 " << i;
+  }
+  BOOST_CHECK_EQUAL(lines(), 4);
+  BOOST_CHECK(g_output.find("every3 9") != string::npos);
+
+  g_output.clear();
+  for (int i = 0; i < 10; ++i)
+  {
+    LOG_FIRST_N(WARN, 2) << "first2 " << i;
+    LOG_EVERY_N(DEBUG, 1) << "removed";
+  }
+  BOOST_CHECK_EQUAL(lines(), 2);
+  BOOST_CHECK(g_output.find("first2 1") != string::npos);
+
+  g_output.clear();
+  for (int i = 0; i < 2; ++i)
+  {
+    for (int j = 0; j < 10; ++j)
+    {
+      LOG_EVERY_T(INFO, 0.05) << "everyT " << i;
+    }
+    usleep(100 * 1000);
+  }
+  BOOST_CHECK_EQUAL(lines(), 2);
+  BOOST_CHECK(g_output.find("INFO  everyT 0") != string::npos);
+  BOOST_CHECK(g_output.find("INFO  [suppressed 9] everyT 1") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(testIfElse)
+{
+  Logger::setOutput(saveOutput);
+  g_output.clear();
+  bool good = g_output.size() > 0;
+  // no -Wdangling-else, the else belongs to the outer if
+  if (good)
+    LOG_INFO << "good news";
+  else
+    LOG_WARN << "bad news";
+  if (good)
+    LOG_EVERY_N(INFO, 1) << "good again";
+  else
+    LOG_ERROR << "bad again";
+  BOOST_CHECK(g_output.find("bad news") != string::npos);
+  BOOST_CHECK(g_output.find("bad again") != string::npos);
+  BOOST_CHECK_EQUAL(lines(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(testRateLimit)
+{
+  Logger::setOutput(saveOutput);
+  g_output.clear();
+  Logger::setRateLimit(Logger::WARN, 10, 5);
+  g_evaluated = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    LOG_WARN << "flood " << evaluate();
+  }
+  int admitted = lines();
+  BOOST_CHECK(admitted >= 5 && admitted <= 6);
+  // operands of dropped lines are not evaluated
+  BOOST_CHECK_EQUAL(g_evaluated, admitted);
+  BOOST_CHECK_EQUAL(Logger::suppressedMessages(Logger::WARN), 100 - admitted);
+  BOOST_CHECK_EQUAL(Logger::suppressedMessages(Logger::INFO), 0);
+
+  g_output.clear();
+  usleep(200 * 1000);
+  LOG_WARN << "recovered";
+  LOG_INFO << "unlimited";
+  BOOST_CHECK(g_output.find("[suppressed " + std::to_string(100 - admitted) + "] recovered")
+              != string::npos);
+  BOOST_CHECK_EQUAL(lines(), 2);
+
+  Logger::setRateLimit(Logger::WARN, 0, 0);
+  g_output.clear();
+  for (int i = 0; i < 100; ++i)
+  {
+    LOG_WARN << "flood " << i;
+  }
+  BOOST_CHECK_EQUAL(lines(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(testLocalTime)
+{
+  Logger::setOutput(saveOutput);
+  Logger::setTimeZone(muduo::TimeZone(8*3600, "CST"));
+  g_output.clear();
+  time_t before = time(NULL);
+  LOG_INFO << "local";
+  time_t after = time(NULL);
+  Logger::setTimeZone(muduo::TimeZone());
+  LOG_INFO << "utc";
+
+  // "YYYYMMDD HH:MM:SS.uuuuuu ", no 'Z'
+  BOOST_REQUIRE(g_output.size() > 26);
+  BOOST_CHECK_EQUAL(g_output[24], ' ');
+  bool matched = false;
+  for (time_t t = before; t <= after; ++t)
+  {
+    struct tm local = muduo::TimeZone::toUtcTime(t + 8*3600);
+    char expected[64];
+    snprintf(expected, sizeof expected, "%4d%02d%02d %02d:%02d:%02d.",
+             local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+             local.tm_hour, local.tm_min, local.tm_sec);
+    matched = matched || g_output.compare(0, 18, expected) == 0;
+  }
+  BOOST_CHECK(matched);
+  size_t utc = g_output.find('\n') + 1;
+  BOOST_CHECK_EQUAL(g_output[utc + 24], 'Z');
+}
+
+BOOST_AUTO_TEST_CASE(testSetTimeZoneWhileLogging)
+{
+  static std::atomic<int> outputs(0);
+  Logger::setOutput([](const char*, int) { outputs.fetch_add(1); });
+  const int kLines = 20000;
+  muduo::Thread thread([] {
+    for (int i = 0; i < kLines; ++i)
+    {
+      LOG_INFO << i;
+    }
+  });
+  thread.start();
+  for (int i = 0; i < 1000; ++i)
+  {
+    Logger::setTimeZone(i % 2 ? muduo::TimeZone() : muduo::TimeZone(8*3600, "CST"));
+  }
+  thread.join();
+  Logger::setTimeZone(muduo::TimeZone());
+  Logger::setOutput(saveOutput);
+  BOOST_CHECK_EQUAL(outputs.load(), kLines);
+}
@@ -0,0 +1,155 @@
+#include "muduo/base/MpmcQueue.h"
+#include "muduo/base/Thread.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+//#define BOOST_TEST_MODULE MpmcQueueTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::MpmcQueue;
+
+BOOST_AUTO_TEST_CASE(testMpmcQueueSingleThread)
+{
+  MpmcQueue<std::string> queue(3);
+  BOOST_CHECK_EQUAL(queue.capacity(), 4u);
+  BOOST_CHECK(queue.empty());
+
+  std::string x;
+  BOOST_CHECK(!queue.tryTake(&x));
+  for (int i = 0; i < 4; ++i)
+  {
+    BOOST_CHECK(queue.tryPut(std::to_string(i)));
+  }
+  BOOST_CHECK(queue.full());
+  std::string extra("extra");
+  BOOST_CHECK(!queue.tryPut(std::move(extra)));
+  BOOST_CHECK_EQUAL(extra, "extra");
+
+  BOOST_CHECK(queue.tryTake(&x));
+  BOOST_CHECK_EQUAL(x, "0");
+  BOOST_CHECK_EQUAL(queue.take(), "1");
+  BOOST_CHECK_EQUAL(queue.size(), 2u);
+
+  std::string items[4] = { "a", "b", "c", "d" };
+  BOOST_CHECK_EQUAL(queue.tryPutBatch(items, 4), 2u);
+  BOOST_CHECK_EQUAL(items[2], "c");
+
+  std::string taken[8];
+  BOOST_CHECK_EQUAL(queue.tryTakeBatch(taken, 8), 4u);
+  BOOST_CHECK_EQUAL(taken[0], "2");
+  BOOST_CHECK_EQUAL(taken[1], "3");
+  BOOST_CHECK_EQUAL(taken[2], "a");
+  BOOST_CHECK_EQUAL(taken[3], "b");
+  BOOST_CHECK(queue.empty());
+  BOOST_CHECK_EQUAL(queue.tryTakeBatch(taken, 8), 0u);
+}
+
+namespace
+{
+
+const int kProducers = 4;
+const int kConsumers = 4;
+const int kItems = 100000;  // per producer
+
+// item = producer * kItems + sequence
+void produce(MpmcQueue<int>* queue, int producer)
+{
+  int batch[16];
+  int n = 0;
+  for (int i = 0; i < kItems; ++i)
+  {
+    int item = producer * kItems + i;
+    if (producer % 2 == 0)
+    {
+      queue->put(item);
+    }
+    else
+    {
+      batch[n++] = item;
+      if (n == 16 || i == kItems - 1)
+      {
+        queue->putBatch(batch, n);
+        n = 0;
+      }
+    }
+  }
+}
+
+// every consumer sees items of a producer in order
+void consume(MpmcQueue<int>* queue, int consumer,
+             std::atomic<int64_t>* count, std::atomic<int64_t>* sum,
+             std::atomic<int>* errors)
+{
+  std::vector<int> last(kProducers, -1);
+  int items[16];
+  for (;;)
+  {
+    size_t n = consumer % 2 == 0 ? queue->takeBatch(items, 16)
+                                 : (items[0] = queue->take(), 1);
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (items[i] < 0)
+      {
+        for (size_t j = i + 1; j < n; ++j)
+        {
+          queue->put(-1);
+        }
+        return;
+      }
+      int producer = items[i] / kItems;
+      if (items[i] <= last[producer])
+      {
+        ++*errors;
+      }
+      last[producer] = items[i];
+      ++*count;
+      *sum += items[i];
+    }
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testMpmcQueueThreads)
+{
+  MpmcQueue<int> queue(64);
+  std::atomic<int64_t> count(0);
+  std::atomic<int64_t> sum(0);
+  std::atomic<int> errors(0);
+
+  std::vector<std::unique_ptr<muduo::Thread>> consumers;
+  for (int i = 0; i < kConsumers; ++i)
+  {
+    consumers.emplace_back(new muduo::Thread(
+          std::bind(consume, &queue, i, &count, &sum, &errors)));
+    consumers.back()->start();
+  }
+  std::vector<std::unique_ptr<muduo::Thread>> producers;
+  for (int i = 0; i < kProducers; ++i)
+  {
+    producers.emplace_back(new muduo::Thread(std::bind(produce, &queue, i)));
+    producers.back()->start();
+  }
+  for (auto& thr : producers)
+  {
+    thr->join();
+  }
+  for (int i = 0; i < kConsumers; ++i)
+  {
+    queue.put(-1);
+  }
+  for (auto& thr : consumers)
+  {
+    thr->join();
+  }
+
+  int64_t total = static_cast<int64_t>(kProducers) * kItems;
+  BOOST_CHECK_EQUAL(count.load(), total);
+  BOOST_CHECK_EQUAL(sum.load(), total * (total - 1) / 2);
+  BOOST_CHECK_EQUAL(errors.load(), 0);
+  BOOST_CHECK(queue.empty());
+}
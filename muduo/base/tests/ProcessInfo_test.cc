@@ -13,5 +13,10 @@ int main()
   printf("opened files = %d\n", muduo::ProcessInfo::openedFiles());
   printf("threads = %zd\n", muduo::ProcessInfo::threads().size());
   printf("num threads = %d\n", muduo::ProcessInfo::numThreads());
+  std::vector<std::vector<int>> nodes = muduo::ProcessInfo::numaNodeCpus();
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    printf("numa node %zd: %zd cpus\n", i, nodes[i].size());
+  }
   printf("status = %s\n", muduo::ProcessInfo::procStatus().c_str());
 }
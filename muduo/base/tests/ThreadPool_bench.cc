@@ -0,0 +1,188 @@
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/WorkStealingThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Timestamp.h"
+
+#include <atomic>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using muduo::CountDownLatch;
+using muduo::ThreadPool;
+using muduo::Timestamp;
+using muduo::WorkStealingThreadPool;
+
+// counts finished tasks, and wakes up the main thread after the last one
+class Counter
+{
+ public:
+  explicit Counter(int total)
+    : total_(total),
+      done_(0),
+      latch_(1)
+  {
+  }
+
+  void done()
+  {
+    if (done_.fetch_add(1) + 1 == total_)
+    {
+      latch_.countDown();
+    }
+  }
+
+  void wait()
+  {
+    latch_.wait();
+    if (done_ != total_)
+    {
+      fprintf(stderr, "%d tasks done, expect %d\n", done_.load(), total_);
+      abort();
+    }
+  }
+
+ private:
+  const int total_;
+  std::atomic<int> done_;
+  CountDownLatch latch_;
+};
+
+void tiny(Counter* counter)
+{
+  counter->done();
+}
+
+volatile double g_sink;
+
+void cpu(Counter* counter, int iterations)
+{
+  double x = 0;
+  for (int i = 1; i <= iterations; ++i)
+  {
+    x += 1.0 / i;
+  }
+  g_sink = x;
+  counter->done();
+}
+
+// a node forks two children until depth reaches zero,
+// 2^(depth+1)-1 tasks in total
+template<typename Pool>
+void forkTask(Pool* pool, Counter* counter, int depth);
+
+void forkChildren(ThreadPool* pool, Counter* counter, int depth)
+{
+  pool->run(std::bind(&forkTask<ThreadPool>, pool, counter, depth));
+  pool->run(std::bind(&forkTask<ThreadPool>, pool, counter, depth));
+}
+
+void forkChildren(WorkStealingThreadPool* pool, Counter* counter, int depth)
+{
+  pool->runLocal(std::bind(&forkTask<WorkStealingThreadPool>, pool, counter, depth));
+  pool->runLocal(std::bind(&forkTask<WorkStealingThreadPool>, pool, counter, depth));
+}
+
+template<typename Pool>
+void forkTask(Pool* pool, Counter* counter, int depth)
+{
+  if (depth > 0)
+  {
+    forkChildren(pool, counter, depth - 1);
+  }
+  counter->done();
+}
+
+void report(const char* pool, const char* workload, int threads,
+            int tasks, Timestamp start)
+{
+  double seconds = timeDifference(Timestamp::now(), start);
+  printf("%-12s %-8s threads %2d  %8d tasks  %7.3f s  %10.0f tasks/s\n",
+         pool, workload, threads, tasks, seconds, tasks / seconds);
+}
+
+template<typename Pool>
+void benchTiny(Pool* pool, const char* name, int threads, int tasks)
+{
+  Counter counter(tasks);
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < tasks; ++i)
+  {
+    pool->run(std::bind(tiny, &counter));
+  }
+  counter.wait();
+  report(name, "tiny", threads, tasks, start);
+}
+
+void benchTinyBatch(WorkStealingThreadPool* pool, int threads, int tasks)
+{
+  const size_t kBatch = 256;
+  Counter counter(tasks);
+  Timestamp start(Timestamp::now());
+  std::vector<WorkStealingThreadPool::Task> batch;
+  batch.reserve(kBatch);
+  for (int i = 0; i < tasks; ++i)
+  {
+    batch.push_back(std::bind(tiny, &counter));
+    if (batch.size() == kBatch || i == tasks - 1)
+    {
+      pool->runBatch(&batch);
+    }
+  }
+  counter.wait();
+  report("WorkStealing", "batch", threads, tasks, start);
+}
+
+template<typename Pool>
+void benchCpu(Pool* pool, const char* name, int threads, int tasks)
+{
+  Counter counter(tasks);
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < tasks; ++i)
+  {
+    pool->run(std::bind(cpu, &counter, 1000));
+  }
+  counter.wait();
+  report(name, "cpu", threads, tasks, start);
+}
+
+template<typename Pool>
+void benchFork(Pool* pool, const char* name, int threads, int depth)
+{
+  int tasks = (2 << depth) - 1;
+  Counter counter(tasks);
+  Timestamp start(Timestamp::now());
+  pool->run(std::bind(&forkTask<Pool>, pool, &counter, depth));
+  counter.wait();
+  report(name, "fork", threads, tasks, start);
+}
+
+int main(int argc, char* argv[])
+{
+  int tasks = argc > 1 ? atoi(argv[1]) : 1000000;
+  int maxThreads = argc > 2 ? atoi(argv[2]) : 8;
+  int depth = 19;  // about 1M tasks
+  printf("usage: %s [tasks] [max_threads]\n", argv[0]);
+
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    {
+    ThreadPool pool("ThreadPool");
+    pool.start(threads);
+    benchTiny(&pool, "ThreadPool", threads, tasks);
+    benchCpu(&pool, "ThreadPool", threads, tasks / 10);
+    benchFork(&pool, "ThreadPool", threads, depth);
+    pool.stop();
+    }
+    {
+    WorkStealingThreadPool pool("WorkStealing");
+    pool.start(threads);
+    benchTiny(&pool, "WorkStealing", threads, tasks);
+    benchTinyBatch(&pool, threads, tasks);
+    benchCpu(&pool, "WorkStealing", threads, tasks / 10);
+    benchFork(&pool, "WorkStealing", threads, depth);
+    pool.stop();
+    }
+  }
+}
@@ -0,0 +1,153 @@
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/BlockingQueue.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>  // usleep
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::CountDownLatch;
+using muduo::ThreadPool;
+
+namespace
+{
+
+void append(std::vector<int>* order, int x)
+{
+  order->push_back(x);
+}
+
+void saveTid(int* tid)
+{
+  *tid = muduo::CurrentThread::tid();
+}
+
+int add(int a, int b)
+{
+  return a + b;
+}
+
+int fail()
+{
+  throw std::runtime_error("fail");
+}
+
+// has the queueInLoop() of EventLoop
+class FakeLoop
+{
+ public:
+  void queueInLoop(ThreadPool::Task task)
+  {
+    queue_.put(std::move(task));
+  }
+
+  void runOne()
+  {
+    queue_.take()();
+  }
+
+ private:
+  muduo::BlockingQueue<ThreadPool::Task> queue_;
+};
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testPriority)
+{
+  ThreadPool pool("PriorityThreadPool");
+  pool.start(1);
+
+  // blocks the only thread, until all tasks are queued
+  CountDownLatch latch(1);
+  pool.run(std::bind(&CountDownLatch::wait, &latch));
+  std::vector<int> order;
+  pool.run(std::bind(append, &order, 3), ThreadPool::kLowPriority);
+  pool.run(std::bind(append, &order, 2));
+  pool.run(std::bind(append, &order, 1), ThreadPool::kHighPriority);
+  pool.run(std::bind(append, &order, 4), ThreadPool::kLowPriority);
+  CountDownLatch done(1);
+  pool.run(std::bind(&CountDownLatch::countDown, &done), ThreadPool::kLowPriority);
+  latch.countDown();
+  done.wait();
+  pool.stop();
+  BOOST_REQUIRE_EQUAL(order.size(), 4U);
+  BOOST_CHECK_EQUAL(order[0], 1);
+  BOOST_CHECK_EQUAL(order[1], 2);
+  BOOST_CHECK_EQUAL(order[2], 3);
+  BOOST_CHECK_EQUAL(order[3], 4);
+}
+
+BOOST_AUTO_TEST_CASE(testTryRun)
+{
+  ThreadPool pool("TryRunThreadPool");
+  pool.setMaxQueueSize(2);
+  pool.start(1);
+
+  CountDownLatch latch(1);
+  pool.run(std::bind(&CountDownLatch::wait, &latch));
+  std::vector<int> order;
+  while (pool.queueSize() > 0)  // until the thread takes the blocking task
+  {
+    usleep(1000);
+  }
+  BOOST_CHECK(pool.tryRun(std::bind(append, &order, 1)));
+  BOOST_CHECK(pool.tryRun(std::bind(append, &order, 2), ThreadPool::kReject,
+                          ThreadPool::kLowPriority));
+  BOOST_CHECK(!pool.tryRun(std::bind(append, &order, 3)));
+  BOOST_CHECK_EQUAL(pool.numRejected(), 1);
+  // drops 2, which is of lower priority
+  BOOST_CHECK(pool.tryRun(std::bind(append, &order, 4), ThreadPool::kDropOldest));
+  // 1 and 4 are of higher priority
+  BOOST_CHECK(!pool.tryRun(std::bind(append, &order, 5), ThreadPool::kDropOldest,
+                           ThreadPool::kLowPriority));
+  BOOST_CHECK_EQUAL(pool.numDropped(), 1);
+  BOOST_CHECK_EQUAL(pool.numRejected(), 2);
+  int tid = 0;
+  BOOST_CHECK(pool.tryRun(std::bind(saveTid, &tid), ThreadPool::kCallerRuns));
+  BOOST_CHECK_EQUAL(tid, muduo::CurrentThread::tid());
+  latch.countDown();
+  CountDownLatch done(1);
+  pool.run(std::bind(&CountDownLatch::countDown, &done));
+  done.wait();
+  pool.stop();
+  BOOST_REQUIRE_EQUAL(order.size(), 2U);
+  BOOST_CHECK_EQUAL(order[0], 1);
+  BOOST_CHECK_EQUAL(order[1], 4);
+}
+
+BOOST_AUTO_TEST_CASE(testSubmit)
+{
+  ThreadPool pool("SubmitThreadPool");
+  pool.setCollectStats(true);
+  pool.start(2);
+
+  std::future<int> sum = pool.submit(std::bind(add, 1, 2));
+  std::future<int> error = pool.submit(fail, ThreadPool::kHighPriority);
+  BOOST_CHECK_EQUAL(sum.get(), 3);
+  BOOST_CHECK_THROW(error.get(), std::runtime_error);
+
+  FakeLoop loop;
+  std::vector<int> results;
+  BOOST_CHECK(pool.trySubmit(std::bind(add, 20, 22), &loop,
+                             std::bind(append, &results, std::placeholders::_1)));
+  loop.runOne();
+  BOOST_REQUIRE_EQUAL(results.size(), 1U);
+  BOOST_CHECK_EQUAL(results[0], 42);
+
+  for (int i = 0; i < 100; ++i)
+  {
+    pool.run([] {});
+  }
+  CountDownLatch latch(1);
+  pool.run(std::bind(&CountDownLatch::countDown, &latch));
+  latch.wait();
+  pool.stop();
+  BOOST_CHECK_EQUAL(pool.queueTimeHistogram().count(), 104);
+  BOOST_CHECK_EQUAL(pool.runTimeHistogram().count(), 104);
+}
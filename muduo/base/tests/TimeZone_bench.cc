@@ -0,0 +1,104 @@
+#include "muduo/base/Logging.h"
+#include "muduo/base/TimeZone.h"
+#include "muduo/base/Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using muduo::TimeZone;
+using muduo::Timestamp;
+
+const int kNumber = 1000*1000;
+const time_t kStart = 1288000000;  // 2010-10-25, a week before end of DST in New York
+int64_t g_sum = 0;  // keeps the loops from being optimized away
+
+// one call per second, as Logger does for a new second
+int64_t benchLocaltime(const TimeZone&)
+{
+  int64_t sum = 0;
+  for (int i = 0; i < kNumber; ++i)
+  {
+    time_t t = kStart + i;
+    struct tm tm_time;
+    ::localtime_r(&t, &tm_time);
+    sum += tm_time.tm_sec + tm_time.tm_gmtoff;
+  }
+  return sum;
+}
+
+int64_t benchToLocalTime(const TimeZone& tz)
+{
+  int64_t sum = 0;
+  for (int i = 0; i < kNumber; ++i)
+  {
+    struct tm tm_time = tz.toLocalTime(kStart + i);
+    sum += tm_time.tm_sec + tm_time.tm_gmtoff;
+  }
+  return sum;
+}
+
+int64_t benchWindow(const TimeZone& tz)
+{
+  int64_t sum = 0;
+  TimeZone::Window window = tz.windowOf(kStart);
+  for (int i = 0; i < kNumber; ++i)
+  {
+    time_t t = kStart + i;
+    if (t < window.start || t >= window.end)
+    {
+      window = tz.windowOf(t);
+    }
+    time_t local = t + window.gmtOffset;
+    sum += local % 60 + window.gmtOffset;
+  }
+  return sum;
+}
+
+void bench(const char* name, int64_t (*func)(const TimeZone&), const TimeZone& tz)
+{
+  Timestamp start(Timestamp::now());
+  g_sum += func(tz);
+  Timestamp end(Timestamp::now());
+  double seconds = timeDifference(end, start);
+  printf("%-20s %8.2f ns/call\n", name, seconds * 1e9 / kNumber);
+}
+
+void nullOutput(const char*, int)
+{
+}
+
+void benchLogging(const char* name, const TimeZone& tz)
+{
+  const int kLines = 1000*1000;
+  muduo::Logger::setTimeZone(tz);
+  muduo::Logger::setOutput(nullOutput);
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kLines; ++i)
+  {
+    LOG_INFO << "Hello " << i;
+  }
+  Timestamp end(Timestamp::now());
+  printf("%-20s %8.2f ns/line\n", name, timeDifference(end, start) * 1e9 / kLines);
+}
+
+int main(int argc, char* argv[])
+{
+  const char* zonefile = argc > 1 ? argv[1] : "/usr/share/zoneinfo/America/New_York";
+  printf("usage: %s [zonefile]\n", argv[0]);
+  TimeZone tz(zonefile);
+  if (!tz.valid())
+  {
+    fprintf(stderr, "cannot read %s\n", zonefile);
+    return 1;
+  }
+  setenv("TZ", zonefile, 1);
+  tzset();
+
+  bench("localtime_r", benchLocaltime, tz);
+  bench("toLocalTime", benchToLocalTime, tz);
+  bench("windowOf cached", benchWindow, tz);
+  benchLogging("LOG_INFO UTC", TimeZone());
+  benchLogging("LOG_INFO local", tz);
+  printf("%ld\n", static_cast<long>(g_sum % 10));
+}
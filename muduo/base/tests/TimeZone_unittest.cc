@@ -1,6 +1,8 @@
 #include "muduo/base/TimeZone.h"
 #include "muduo/base/Types.h"
 
+#include <limits>
+
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -265,6 +267,47 @@ void testFixedTimezone()
   }
 }
 
+void testWindow(const TimeZone& tz)
+{
+  time_t start = getGmt("2005-12-31 00:00:00");
+  time_t end = getGmt("2013-01-01 00:00:00");
+  for (time_t t = start; t < end; t += 1847)
+  {
+    TimeZone::Window window = tz.windowOf(t);
+    struct tm local = tz.toLocalTime(t);
+    if (!(window.start <= t && t < window.end)
+        || window.gmtOffset != local.tm_gmtoff
+        || window.isDst != (local.tm_isdst != 0))
+    {
+      printf("WRONG window: %ld in [%ld, %ld) %d\n", static_cast<long>(t),
+             static_cast<long>(window.start), static_cast<long>(window.end),
+             window.gmtOffset);
+      assert(0);
+    }
+    if (window.end != std::numeric_limits<time_t>::max()
+        && tz.toLocalTime(window.end).tm_gmtoff == local.tm_gmtoff
+        && tz.toLocalTime(window.end).tm_isdst == local.tm_isdst)
+    {
+      printf("WRONG window end: %ld\n", static_cast<long>(window.end));
+      assert(0);
+    }
+  }
+}
+
+void testWindows()
+{
+  testWindow(TimeZone("/usr/share/zoneinfo/America/New_York"));
+  testWindow(TimeZone("/usr/share/zoneinfo/Europe/London"));
+  testWindow(TimeZone("/usr/share/zoneinfo/Australia/Sydney"));
+
+  TimeZone tz(8*3600, "CST");
+  TimeZone::Window window = tz.windowOf(getGmt("2014-04-03 00:00:00"));
+  assert(window.start == std::numeric_limits<time_t>::min());
+  assert(window.end == std::numeric_limits<time_t>::max());
+  assert(window.gmtOffset == 8*3600);
+  (void)window;
+}
+
 int main()
 {
   testNewYork();
@@ -272,5 +315,6 @@ int main()
   testSydney();
   testHongKong();
   testFixedTimezone();
+  testWindows();
   testUtc();
 }
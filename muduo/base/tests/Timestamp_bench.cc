@@ -0,0 +1,74 @@
+#include "muduo/base/Timestamp.h"
+
+#include <stdio.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+using muduo::Timestamp;
+
+const int kNumber = 10*1000*1000;
+int64_t g_sum = 0;  // keeps the loops from being optimized away
+
+int64_t benchNow()
+{
+  int64_t sum = 0;
+  for (int i = 0; i < kNumber; ++i)
+  {
+    sum += Timestamp::now().microSecondsSinceEpoch();
+  }
+  return sum;
+}
+
+int64_t benchCachedNow()
+{
+  int64_t sum = 0;
+  for (int i = 0; i < kNumber; ++i)
+  {
+    sum += Timestamp::cachedNow().microSecondsSinceEpoch();
+  }
+  return sum;
+}
+
+void bench(const char* name, int64_t (*func)())
+{
+  Timestamp start(Timestamp::now());
+  g_sum += func();
+  Timestamp end(Timestamp::now());
+  double seconds = timeDifference(end, start);
+  printf("%-20s %6.2f ns/call\n", name, seconds * 1e9 / kNumber);
+}
+
+int main()
+{
+  struct
+  {
+    const char* name;
+    Timestamp::Clock clock;
+  } clocks[] =
+  {
+    { "gettimeofday", Timestamp::kGettimeofday },
+    { "realtime_coarse", Timestamp::kRealtimeCoarse },
+    { "tsc", Timestamp::kTsc },
+  };
+
+  for (const auto& c : clocks)
+  {
+    if (Timestamp::setClock(c.clock))
+    {
+      Timestamp now(Timestamp::now());
+      Timestamp::setClock(Timestamp::kGettimeofday);
+      printf("%-20s error %" PRId64 " us\n", c.name,
+             Timestamp::now().microSecondsSinceEpoch() - now.microSecondsSinceEpoch());
+      Timestamp::setClock(c.clock);
+      bench(c.name, benchNow);
+    }
+    else
+    {
+      printf("%-20s not available\n", c.name);
+    }
+  }
+
+  Timestamp::setClock(Timestamp::kGettimeofday);
+  Timestamp::setCachedNow(Timestamp::now());
+  bench("cached", benchCachedNow);
+}
@@ -1,6 +1,8 @@
 #include "muduo/base/Timestamp.h"
 #include <vector>
 #include <stdio.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 using muduo::Timestamp;
 
@@ -55,6 +57,39 @@ void benchmark()
   }
 }
 
+// kTsc is rebased every second, stays close to gettimeofday
+void tscClock()
+{
+  if (!Timestamp::setClock(Timestamp::kTsc))
+  {
+    printf("no invariant TSC\n");
+    return;
+  }
+  int64_t maxDiff = 0;
+  for (int i = 0; i < 30; ++i)
+  {
+    ::usleep(100*1000);
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t tod = static_cast<int64_t>(tv.tv_sec) * Timestamp::kMicroSecondsPerSecond + tv.tv_usec;
+    int64_t diff = Timestamp::now().microSecondsSinceEpoch() - tod;
+    if (diff < 0)
+    {
+      diff = -diff;
+    }
+    if (diff > maxDiff)
+    {
+      maxDiff = diff;
+    }
+  }
+  printf("tsc max diff %d us\n", static_cast<int>(maxDiff));
+  if (maxDiff > 1000)
+  {
+    printf("too far!\n");
+  }
+  Timestamp::setClock(Timestamp::kGettimeofday);
+}
+
 int main()
 {
   Timestamp now(Timestamp::now());
@@ -62,5 +97,6 @@ int main()
   passByValue(now);
   passByConstReference(now);
   benchmark();
+  tscClock();
 }
 
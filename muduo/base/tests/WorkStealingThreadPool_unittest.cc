@@ -0,0 +1,153 @@
+#include "muduo/base/WorkStealingThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+
+#include <atomic>
+#include <memory>
+#include <set>
+
+#include <unistd.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+
+namespace
+{
+
+// polls for up to 5 seconds
+bool waitFor(const std::function<bool()>& cond)
+{
+  for (int i = 0; i < 500 && !cond(); ++i)
+  {
+    ::usleep(10*1000);
+  }
+  return cond();
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testNoThreads)
+{
+  WorkStealingThreadPool pool;
+  pool.start(0);
+  int count = 0;
+  pool.run([&] { ++count; });
+  pool.runLocal([&] { ++count; });
+  std::vector<WorkStealingThreadPool::Task> tasks(3, [&] { ++count; });
+  pool.runBatch(&tasks);
+  BOOST_CHECK(tasks.empty());
+  BOOST_CHECK_EQUAL(count, 5);
+  pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(testCompletionCounts)
+{
+  const int kTasks = 1000;
+  // each task forks two subtasks
+  const int kTotal = 2 * kTasks * 3;
+  WorkStealingThreadPool pool;
+  pool.start(3);
+  std::atomic<int> count(0);
+  std::atomic<bool> inWorker(true);
+  CountDownLatch latch(kTotal);
+  auto leaf = [&] { ++count; latch.countDown(); };
+  auto task = [&] {
+    if (!pool.inWorkerThread())
+    {
+      inWorker = false;
+    }
+    pool.runLocal(leaf);
+    pool.run(leaf);
+    leaf();
+  };
+
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run(task);
+  }
+  std::vector<WorkStealingThreadPool::Task> tasks(kTasks, task);
+  pool.runBatch(&tasks);
+  BOOST_CHECK(tasks.empty());
+  BOOST_CHECK(!pool.inWorkerThread());
+
+  latch.wait();
+  BOOST_CHECK_EQUAL(count.load(), kTotal);
+  BOOST_CHECK(inWorker.load());
+  BOOST_CHECK(waitFor([&] { return pool.queueSize() == 0; }));
+  pool.stop();
+  BOOST_CHECK_EQUAL(count.load(), kTotal);
+}
+
+BOOST_AUTO_TEST_CASE(testStealing)
+{
+  const int kSubtasks = 64;
+  WorkStealingThreadPool pool;
+  pool.start(4);
+  std::atomic<int> done(0);
+  std::atomic<bool> ownerRan(false);
+  std::atomic<bool> allDone(false);
+  CountDownLatch finished(1);
+
+  pool.run([&] {
+    int owner = CurrentThread::tid();
+    for (int i = 0; i < kSubtasks; ++i)
+    {
+      pool.runLocal([&, owner] {
+        if (CurrentThread::tid() == owner)
+        {
+          ownerRan = true;
+        }
+        ++done;
+      });
+    }
+    // blocks its worker, subtasks in its deque must be stolen
+    allDone = waitFor([&] { return done == kSubtasks; });
+    finished.countDown();
+  });
+  finished.wait();
+
+  BOOST_CHECK(allDone.load());
+  BOOST_CHECK(!ownerRan.load());
+  BOOST_CHECK_EQUAL(done.load(), kSubtasks);
+  pool.stop();
+}
+
+BOOST_AUTO_TEST_CASE(testStopDiscardsQueuedTasks)
+{
+  WorkStealingThreadPool pool;
+  pool.start(2);
+  CountDownLatch blocked(2);
+  CountDownLatch release(1);
+  for (int i = 0; i < 2; ++i)
+  {
+    pool.run([&] { blocked.countDown(); release.wait(); });
+  }
+  blocked.wait();
+
+  // both workers are busy, these stay queued
+  std::shared_ptr<int> token(new int(0));
+  std::atomic<int> ran(0);
+  for (int i = 0; i < 100; ++i)
+  {
+    pool.run([&ran, token] { ++ran; });
+  }
+  BOOST_CHECK_EQUAL(pool.queueSize(), 100U);
+  BOOST_CHECK_EQUAL(token.use_count(), 101);
+
+  Thread releaser([&] {
+    ::usleep(100*1000);
+    release.countDown();
+  });
+  releaser.start();
+  // waits for running tasks, discards queued ones
+  pool.stop();
+  releaser.join();
+
+  BOOST_CHECK_EQUAL(ran.load(), 0);
+  BOOST_CHECK_EQUAL(pool.queueSize(), 0U);
+  // deleted, not leaked
+  BOOST_CHECK_EQUAL(token.use_count(), 1);
+}
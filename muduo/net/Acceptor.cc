@@ -27,7 +27,11 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
     acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
     acceptChannel_(loop, acceptSocket_.fd()),
     listenning_(false),
-    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    paused_(false),
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+    maxConnections_(0),
+    maxConnectionsPerIp_(0),
+    numConnections_(0)
 {
   assert(idleFd_ >= 0);
   acceptSocket_.setReuseAddr(true);
@@ -52,6 +56,79 @@ void Acceptor::listen()
   acceptChannel_.enableReading();
 }
 
+void Acceptor::setConnectionLimits(int maxConnections, int maxConnectionsPerIp)
+{
+  assert(!listenning_);
+  assert(maxConnections >= 0 && maxConnectionsPerIp >= 0);
+  maxConnections_ = maxConnections;
+  maxConnectionsPerIp_ = maxConnectionsPerIp;
+}
+
+bool Acceptor::admit(const InetAddress& peerAddr)
+{
+  if (maxConnectionsPerIp_ > 0)
+  {
+    int& count = connectionsPerIp_[peerAddr.toIp()];
+    if (count >= maxConnectionsPerIp_)
+    {
+      // at most once a second under a connect flood, with the number skipped
+      LOG_EVERY_T(WARN, 1.0) << "Acceptor::admit - too many connections from "
+                             << peerAddr.toIp() << ", rejected";
+      return false;
+    }
+    ++count;
+  }
+  ++numConnections_;
+  if (maxConnections_ > 0 && numConnections_ >= maxConnections_)
+  {
+    pause();
+  }
+  return true;
+}
+
+void Acceptor::connectionClosed(const InetAddress& peerAddr)
+{
+  loop_->assertInLoopThread();
+  assert(numConnections_ > 0);
+  --numConnections_;
+  if (maxConnectionsPerIp_ > 0)
+  {
+    std::map<string, int>::iterator it = connectionsPerIp_.find(peerAddr.toIp());
+    assert(it != connectionsPerIp_.end());
+    if (it != connectionsPerIp_.end() && --it->second == 0)
+    {
+      connectionsPerIp_.erase(it);
+    }
+  }
+  if (paused_ && numConnections_ < maxConnections_)
+  {
+    resume();
+  }
+}
+
+void Acceptor::pause()
+{
+  if (!paused_)
+  {
+    LOG_WARN << "Acceptor::pause - reached max connections " << maxConnections_;
+    paused_ = true;
+    acceptChannel_.disableReading();
+  }
+}
+
+void Acceptor::resume()
+{
+  if (paused_)
+  {
+    LOG_INFO << "Acceptor::resume - connections " << numConnections_;
+    paused_ = false;
+    if (listenning_)
+    {
+      acceptChannel_.enableReading();
+    }
+  }
+}
+
 void Acceptor::handleRead()
 {
   loop_->assertInLoopThread();
@@ -62,7 +139,7 @@ void Acceptor::handleRead()
   {
     // string hostport = peerAddr.toIpPort();
     // LOG_TRACE << "Accepts of " << hostport;
-    if (newConnectionCallback_)
+    if (newConnectionCallback_ && admit(peerAddr))
     {
       newConnectionCallback_(connfd, peerAddr);
     }
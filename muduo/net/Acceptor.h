@@ -12,7 +12,9 @@
 #define MUDUO_NET_ACCEPTOR_H
 
 #include <functional>
+#include <map>
 
+#include "muduo/base/Types.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/Socket.h"
 
@@ -41,15 +43,37 @@ class Acceptor : noncopyable
   bool listenning() const { return listenning_; }
   void listen();
 
+  /// Limits concurrent connections, 0 means unlimited.
+  /// Stops accepting when @c maxConnections is reached,
+  /// resumes when connections drop below it.
+  /// Connections exceeding @c maxConnectionsPerIp from one peer IP
+  /// are closed right after accept(2).
+  /// Must be called before @c listen
+  void setConnectionLimits(int maxConnections, int maxConnectionsPerIp);
+
+  /// Tells that a connection accepted by us has gone.
+  void connectionClosed(const InetAddress& peerAddr);
+
+  int numConnections() const { return numConnections_; }
+  bool paused() const { return paused_; }
+
  private:
   void handleRead();
+  bool admit(const InetAddress& peerAddr);
+  void pause();
+  void resume();
 
   EventLoop* loop_;
   Socket acceptSocket_;
   Channel acceptChannel_;
   NewConnectionCallback newConnectionCallback_;
   bool listenning_;
+  bool paused_;
   int idleFd_;
+  int maxConnections_;
+  int maxConnectionsPerIp_;
+  int numConnections_;
+  std::map<string, int> connectionsPerIp_;
 };
 
 }  // namespace net
@@ -0,0 +1,103 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BUFFERSLICE_H
+#define MUDUO_NET_BUFFERSLICE_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Buffer.h"
+
+#include <memory>
+
+#include <assert.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// A slice of immutable, reference counted bytes.
+///
+/// Copying a slice copies a reference, so a payload sent to many
+/// TcpConnections is stored once, and freed after the last connection
+/// writes it, see TcpConnection::send(const BufferSlice&).
+///
+class BufferSlice : public muduo::copyable
+{
+ public:
+  BufferSlice()
+    : offset_(0),
+      length_(0)
+  {
+  }
+
+  explicit BufferSlice(string data)
+    : storage_(std::make_shared<const string>(std::move(data))),
+      offset_(0),
+      length_(storage_->size())
+  {
+  }
+
+  explicit BufferSlice(const std::shared_ptr<const string>& data)
+    : storage_(data),
+      offset_(0),
+      length_(data ? data->size() : 0)
+  {
+  }
+
+  /// Takes all readable bytes of @c buf.
+  explicit BufferSlice(Buffer* buf)
+    : storage_(std::make_shared<const string>(buf->retrieveAllAsString())),
+      offset_(0),
+      length_(storage_->size())
+  {
+  }
+
+  const char* data() const { return storage_ ? storage_->data() + offset_ : NULL; }
+  size_t size() const { return length_; }
+  bool empty() const { return length_ == 0; }
+
+  StringPiece toStringPiece() const
+  { return StringPiece(data(), static_cast<int>(length_)); }
+
+  /// Shares the same bytes.
+  BufferSlice slice(size_t offset, size_t len) const
+  {
+    assert(offset + len <= length_);
+    BufferSlice result(*this);
+    result.offset_ += offset;
+    result.length_ = len;
+    return result;
+  }
+
+  /// Drops first @c len bytes from this slice, the bytes are intact.
+  void retrieve(size_t len)
+  {
+    assert(len <= length_);
+    offset_ += len;
+    length_ -= len;
+  }
+
+  /// Number of slices sharing the bytes.
+  long useCount() const { return storage_.use_count(); }
+
+ private:
+  std::shared_ptr<const string> storage_;
+  size_t offset_;
+  size_t length_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BUFFERSLICE_H
@@ -68,6 +68,9 @@ EventLoop::EventLoop()
     callingPendingFunctors_(false),
     iteration_(0),
     threadId_(CurrentThread::tid()),
+    busyPollUsec_(0),
+    timerSlack_(0.0),
+    spinning_(false),
     poller_(Poller::newDefaultPoller(this)),
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
@@ -110,8 +113,10 @@ void EventLoop::loop()
 
   while (!quit_)
   {
+    int64_t timeoutUsec = pollTimeoutUsec();
     activeChannels_.clear();
-    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    pollReturnTime_ = poller_->pollUsec(timeoutUsec, &activeChannels_);
+    Timestamp::setCachedNow(pollReturnTime_);
     ++iteration_;
     if (Logger::logLevel() <= Logger::TRACE)
     {
@@ -126,13 +131,70 @@ void EventLoop::loop()
     }
     currentActiveChannel_ = NULL;
     eventHandling_ = false;
-    doPendingFunctors();
+    if (!timerQueue_->usesTimerfd())
+    {
+      timerQueue_->runExpired(pollReturnTime_);
+    }
+    size_t numFunctors = doPendingFunctors();
+    if (busyPollUsec_ > 0 && (!activeChannels_.empty() || numFunctors > 0))
+    {
+      lastBusyTime_ = pollReturnTime_;
+    }
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
+  Timestamp::setCachedNow(Timestamp::invalid());
+  spinning_ = false;
   looping_ = false;
 }
 
+void EventLoop::setBusyPoll(int usec)
+{
+  assertInLoopThread();
+  assert(usec >= 0);
+  busyPollUsec_ = usec;
+  lastBusyTime_ = Timestamp::now();
+}
+
+int64_t EventLoop::pollTimeoutUsec()
+{
+  if (busyPollUsec_ > 0)
+  {
+    int64_t idleUsec = Timestamp::now().microSecondsSinceEpoch()
+                       - lastBusyTime_.microSecondsSinceEpoch();
+    if (idleUsec < busyPollUsec_)
+    {
+      spinning_ = true;
+      return 0;
+    }
+  }
+  // also after setBusyPoll(0) while spinning
+  if (spinning_)
+  {
+    // Going to block, producers which queue a functor after this
+    // see spinning_ == false under mutex_ and wake us up.
+    MutexLockGuard lock(mutex_);
+    spinning_ = false;
+    if (!pendingFunctors_.empty())
+    {
+      spinning_ = true;
+      return 0;
+    }
+  }
+  int64_t timeoutUsec = kPollTimeMs * 1000;
+  if (!timerQueue_->usesTimerfd())
+  {
+    Timestamp nextExpire = timerQueue_->nextExpiration();
+    if (nextExpire.valid())
+    {
+      int64_t untilNext = nextExpire.microSecondsSinceEpoch()
+                          - Timestamp::now().microSecondsSinceEpoch();
+      timeoutUsec = std::max<int64_t>(0, std::min(untilNext, timeoutUsec));
+    }
+  }
+  return timeoutUsec;
+}
+
 void EventLoop::quit()
 {
   quit_ = true;
@@ -159,12 +221,15 @@ void EventLoop::runInLoop(Functor cb)
 
 void EventLoop::queueInLoop(Functor cb)
 {
+  bool spinning = false;
   {
   MutexLockGuard lock(mutex_);
   pendingFunctors_.push_back(std::move(cb));
+  spinning = spinning_;
   }
 
-  if (!isInLoopThread() || callingPendingFunctors_)
+  // a spinning loop checks pendingFunctors_ in next iteration anyway.
+  if ((!isInLoopThread() || callingPendingFunctors_) && !spinning)
   {
     wakeup();
   }
@@ -183,14 +248,24 @@ TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
 
 TimerId EventLoop::runAfter(double delay, TimerCallback cb)
 {
-  Timestamp time(addTime(Timestamp::now(), delay));
-  return runAt(time, std::move(cb));
+  return runAfter(delay, timerSlack_, std::move(cb));
 }
 
 TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+  return runEvery(interval, timerSlack_, std::move(cb));
+}
+
+TimerId EventLoop::runAfter(double delay, double slack, TimerCallback cb)
+{
+  Timestamp time(addTime(Timestamp::now(), delay));
+  return timerQueue_->addTimer(std::move(cb), time, 0.0, slack);
+}
+
+TimerId EventLoop::runEvery(double interval, double slack, TimerCallback cb)
 {
   Timestamp time(addTime(Timestamp::now(), interval));
-  return timerQueue_->addTimer(std::move(cb), time, interval);
+  return timerQueue_->addTimer(std::move(cb), time, interval, slack);
 }
 
 void EventLoop::cancel(TimerId timerId)
@@ -251,7 +326,7 @@ void EventLoop::handleRead()
   }
 }
 
-void EventLoop::doPendingFunctors()
+size_t EventLoop::doPendingFunctors()
 {
   std::vector<Functor> functors;
   callingPendingFunctors_ = true;
@@ -266,6 +341,7 @@ void EventLoop::doPendingFunctors()
     functor();
   }
   callingPendingFunctors_ = false;
+  return functors.size();
 }
 
 void EventLoop::printActiveChannels() const
@@ -60,10 +60,23 @@ class EventLoop : noncopyable
   ///
   /// Time when poll returns, usually means data arrival.
   ///
+  /// Also cached for the loop thread, see Timestamp::cachedNow().
   Timestamp pollReturnTime() const { return pollReturnTime_; }
 
   int64_t iteration() const { return iteration_; }
 
+  ///
+  /// Enables adaptive busy polling, for latency-critical loops.
+  ///
+  /// After handling events or functors, the loop keeps polling with zero
+  /// timeout for @c usec microseconds before blocking in poll again.
+  /// Other threads skip the eventfd wakeup while the loop is spinning.
+  /// It burns a CPU, so only use it when the loop has a dedicated core,
+  /// see EventLoopThreadPool::setCpuAffinity(). 0 disables it, the default.
+  /// Must be called in the loop thread.
+  void setBusyPoll(int usec);
+  bool spinning() const { return spinning_; }
+
   /// Runs callback immediately in the loop thread.
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
@@ -77,6 +90,9 @@ class EventLoop : noncopyable
   size_t queueSize() const;
 
   // timers
+  // Armed with a timerfd, or with the poll timeout if environment
+  // variable MUDUO_NO_TIMERFD is set, which saves timerfd_settime()
+  // calls when the earliest timer changes often.
 
   ///
   /// Runs callback at 'time'.
@@ -84,16 +100,31 @@ class EventLoop : noncopyable
   ///
   TimerId runAt(Timestamp time, TimerCallback cb);
   ///
-  /// Runs callback after @c delay seconds.
+  /// Runs callback after @c delay seconds, up to timerSlack() later.
   /// Safe to call from other threads.
   ///
   TimerId runAfter(double delay, TimerCallback cb);
   ///
-  /// Runs callback every @c interval seconds.
+  /// Runs callback every @c interval seconds, up to timerSlack() later.
+  /// Periods are counted from the first expiration, so it doesn't drift.
   /// Safe to call from other threads.
   ///
   TimerId runEvery(double interval, TimerCallback cb);
   ///
+  /// Same as above, with a timer-specific slack in seconds.
+  ///
+  TimerId runAfter(double delay, double slack, TimerCallback cb);
+  TimerId runEvery(double interval, double slack, TimerCallback cb);
+  ///
+  /// Default slack of runAfter() and runEvery(), in seconds.
+  ///
+  /// Timers are rounded up to a multiple of slack, so that timers with
+  /// close expirations fire in one batch, eg. 100k heartbeats with 1s slack
+  /// cause at most one wakeup per second. 0.0 means exact, the default.
+  /// Call it before adding timers.
+  void setTimerSlack(double seconds) { timerSlack_ = seconds; }
+  double timerSlack() const { return timerSlack_; }
+  ///
   /// Cancels the timer.
   /// Safe to call from other threads.
   ///
@@ -131,7 +162,8 @@ class EventLoop : noncopyable
  private:
   void abortNotInLoopThread();
   void handleRead();  // waked up
-  void doPendingFunctors();
+  size_t doPendingFunctors();
+  int64_t pollTimeoutUsec();
 
   void printActiveChannels() const; // DEBUG
 
@@ -144,6 +176,10 @@ class EventLoop : noncopyable
   int64_t iteration_;
   const pid_t threadId_;
   Timestamp pollReturnTime_;
+  int busyPollUsec_;
+  Timestamp lastBusyTime_;
+  double timerSlack_;
+  std::atomic<bool> spinning_;
   std::unique_ptr<Poller> poller_;
   std::unique_ptr<TimerQueue> timerQueue_;
   int wakeupFd_;
@@ -37,10 +37,20 @@ EventLoopThread::~EventLoopThread()
 }
 
 EventLoop* EventLoopThread::startLoop()
+{
+  startThread();
+  return waitForLoop();
+}
+
+void EventLoopThread::startThread()
 {
   assert(!thread_.started());
   thread_.start();
+}
 
+EventLoop* EventLoopThread::waitForLoop()
+{
+  assert(thread_.started());
   EventLoop* loop = NULL;
   {
     MutexLockGuard lock(mutex_);
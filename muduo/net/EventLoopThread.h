@@ -30,8 +30,19 @@ class EventLoopThread : noncopyable
   EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(),
                   const string& name = string());
   ~EventLoopThread();
+
+  /// Must be called before starting, see Thread::setCpuAffinity().
+  void setCpuAffinity(const Thread::CpuSet& cpus)
+  { thread_.setCpuAffinity(cpus); }
+
+  /// Starts the thread and waits for its loop.
   EventLoop* startLoop();
 
+  /// Starts the thread without waiting, so that several threads
+  /// can be brought up in parallel, then call @c waitForLoop.
+  void startThread();
+  EventLoop* waitForLoop();
+
  private:
   void threadFunc();
 
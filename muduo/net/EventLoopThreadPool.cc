@@ -43,7 +43,15 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
     EventLoopThread* t = new EventLoopThread(cb, buf);
     threads_.push_back(std::unique_ptr<EventLoopThread>(t));
-    loops_.push_back(t->startLoop());
+    if (!cpuSets_.empty())
+    {
+      t->setCpuAffinity(cpuSets_[i % cpuSets_.size()]);
+    }
+    t->startThread();
+  }
+  for (const auto& t : threads_)
+  {
+    loops_.push_back(t->waitForLoop());
   }
   if (numThreads_ == 0 && cb)
   {
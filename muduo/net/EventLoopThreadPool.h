@@ -12,6 +12,7 @@
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include "muduo/base/noncopyable.h"
+#include "muduo/base/Thread.h"
 #include "muduo/base/Types.h"
 
 #include <functional>
@@ -35,6 +36,21 @@ class EventLoopThreadPool : noncopyable
   EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+
+  /// Pins the i-th loop thread to cpuSets[i % cpuSets.size()].
+  ///
+  /// Threads are pinned before their EventLoop is constructed, so the loop
+  /// and the buffers growing in it live on the local NUMA node.
+  /// Pass ProcessInfo::numaNodeCpus() to spread loops over NUMA nodes.
+  /// Must be called before @c start
+  void setCpuAffinity(const std::vector<Thread::CpuSet>& cpuSets)
+  { cpuSets_ = cpuSets; }
+
+  /// Starts all threads in parallel, returns when all loops are running.
+  ///
+  /// @c cb runs in each loop thread, concurrently with the others, so it
+  /// must lock any state it shares.  Or runs @c cb(baseLoop) in the
+  /// calling thread if there are no threads.
   void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
   // valid after calling start()
@@ -59,6 +75,7 @@ class EventLoopThreadPool : noncopyable
   bool started_;
   int numThreads_;
   int next_;
+  std::vector<Thread::CpuSet> cpuSets_;
   std::vector<std::unique_ptr<EventLoopThread>> threads_;
   std::vector<EventLoop*> loops_;
 };
@@ -0,0 +1,152 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOOPMESSENGER_H
+#define MUDUO_NET_LOOPMESSENGER_H
+
+#include "muduo/base/SpscQueue.h"
+#include "muduo/net/EventLoop.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Passes typed messages between a fixed set of event loops,
+/// eg. EventLoopThreadPool::getAllLoops().
+///
+/// Each ordered pair of loops has its own bounded SpscQueue, so sending
+/// takes no lock and allocates no std::function.  A receiving loop is
+/// woken through queueInLoop() only when its inbox goes from idle to busy,
+/// then drains all of its queues at most once per iteration, in batch.
+///
+/// Must outlive the loops' iterations, eg. destroy it after loops quit.
+///
+template<typename T>
+class LoopMessenger : noncopyable
+{
+ public:
+  /// Called in the receiving loop thread.
+  typedef std::function<void (size_t from, size_t to, T& message)> MessageCallback;
+
+  LoopMessenger(const std::vector<EventLoop*>& loops,
+                size_t capacity,
+                const MessageCallback& cb)
+    : loops_(loops),
+      messageCallback_(cb)
+  {
+    for (size_t to = 0; to < loops_.size(); ++to)
+    {
+      inboxes_.emplace_back(new Inbox);
+      for (size_t from = 0; from < loops_.size(); ++from)
+      {
+        inboxes_[to]->queues.emplace_back(new SpscQueue<T>(capacity));
+      }
+    }
+  }
+
+  size_t numLoops() const { return loops_.size(); }
+
+  /// Returns index of @c loop, or numLoops() if not found.
+  size_t indexOf(EventLoop* loop) const
+  {
+    size_t i = 0;
+    while (i < loops_.size() && loops_[i] != loop)
+    {
+      ++i;
+    }
+    return i;
+  }
+
+  ///
+  /// Sends @c message to loop @c to.
+  /// Must be called in the thread of loop @c from.
+  ///
+  /// Returns false if the queue is full, which is the backpressure signal,
+  /// the caller should drop, or retry later.
+  bool send(size_t from, size_t to, T message)
+  {
+    loops_[from]->assertInLoopThread();
+    Inbox* inbox = inboxes_[to].get();
+    if (!inbox->queues[from]->tryPut(std::move(message)))
+    {
+      return false;
+    }
+    // pairs with the exchange in drain(), either drain() sees the message,
+    // or we see the inbox idle and schedule another drain().
+    if (!inbox->scheduled.exchange(true, std::memory_order_acq_rel))
+    {
+      loops_[to]->queueInLoop(Drain(this, to));
+    }
+    return true;
+  }
+
+  /// Messages sent from @c from to @c to but not yet received,
+  /// exact in the sending thread.
+  size_t backlog(size_t from, size_t to) const
+  {
+    return inboxes_[to]->queues[from]->size();
+  }
+
+ private:
+  struct Inbox
+  {
+    Inbox() : scheduled(false) { }
+
+    std::atomic<bool> scheduled;
+    std::vector<std::unique_ptr<SpscQueue<T>>> queues;  // indexed by sender
+  };
+
+  // small enough to be stored in std::function without allocation
+  struct Drain
+  {
+    Drain(LoopMessenger* m, size_t t) : messenger(m), to(t) { }
+    void operator()() const { messenger->drain(to); }
+
+    LoopMessenger* messenger;
+    size_t to;
+  };
+
+  void drain(size_t to)
+  {
+    Inbox* inbox = inboxes_[to].get();
+    // a read-modify-write, not a store: if a sender's exchange(true) comes
+    // first, we acquire its message, a plain store could be reordered
+    // after the loads of queues below and miss it.
+    inbox->scheduled.exchange(false, std::memory_order_acq_rel);
+    T message;
+    for (size_t from = 0; from < inbox->queues.size(); ++from)
+    {
+      // at most one queue-full per sender, so that a busy sender can't
+      // starve other senders, or other events of this loop.
+      SpscQueue<T>* queue = inbox->queues[from].get();
+      for (size_t n = queue->capacity(); n > 0 && queue->tryTake(&message); --n)
+      {
+        messageCallback_(from, to, message);
+      }
+      if (!queue->empty() && !inbox->scheduled.exchange(true, std::memory_order_acq_rel))
+      {
+        loops_[to]->queueInLoop(Drain(this, to));
+      }
+    }
+  }
+
+  const std::vector<EventLoop*> loops_;
+  const MessageCallback messageCallback_;
+  std::vector<std::unique_ptr<Inbox>> inboxes_;  // indexed by receiver
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_LOOPMESSENGER_H
@@ -27,3 +27,10 @@ bool Poller::hasChannel(Channel* channel) const
   return it != channels_.end() && it->second == channel;
 }
 
+
+Timestamp Poller::pollUsec(int64_t timeoutUsec, ChannelList* activeChannels)
+{
+  // round up, never returns before the timeout
+  int timeoutMs = timeoutUsec < 0 ? -1 : static_cast<int>((timeoutUsec + 999) / 1000);
+  return poll(timeoutMs, activeChannels);
+}
@@ -40,6 +40,11 @@ class Poller : noncopyable
   /// Must be called in the loop thread.
   virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels) = 0;
 
+  /// Polls with microsecond timeout, negative means forever.
+  /// The default rounds up to milliseconds and calls poll().
+  /// Must be called in the loop thread.
+  virtual Timestamp pollUsec(int64_t timeoutUsec, ChannelList* activeChannels);
+
   /// Changes the interested I/O events.
   /// Must be called in the loop thread.
   virtual void updateChannel(Channel* channel) = 0;
@@ -79,6 +79,11 @@ class Socket : noncopyable
   ///
   void setKeepAlive(bool on);
 
+  ///
+  /// Enable/disable SO_ZEROCOPY, returns false if not supported.
+  ///
+  bool setZeroCopy(bool on);
+
  private:
   const int sockfd_;
 };
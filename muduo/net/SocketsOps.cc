@@ -15,8 +15,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>  // snprintf
+#include <linux/errqueue.h>
 #include <sys/socket.h>
-#include <sys/uio.h>  // readv
+#include <sys/uio.h>  // readv, writev
 #include <unistd.h>
 
 using namespace muduo;
@@ -176,6 +177,47 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+  return ::writev(sockfd, iov, iovcnt);
+}
+
+ssize_t sockets::sendZeroCopy(int sockfd, const void *buf, size_t count)
+{
+  return ::send(sockfd, buf, count, MSG_ZEROCOPY);
+}
+
+bool sockets::readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied)
+{
+  char control[128];
+  struct msghdr msg;
+  memZero(&msg, sizeof msg);
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof control;
+  while (::recvmsg(sockfd, &msg, MSG_ERRQUEUE) >= 0)
+  {
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+    {
+      if ((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+          || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+      {
+        struct sock_extended_err serr;
+        memcpy(&serr, CMSG_DATA(cm), sizeof serr);
+        if (serr.ee_errno == 0 && serr.ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+        {
+          *lo = serr.ee_info;
+          *hi = serr.ee_data;
+          *copied = (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+          return true;
+        }
+      }
+    }
+    // not a zerocopy notification, skip it
+    msg.msg_controllen = sizeof control;
+  }
+  return false;
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
@@ -32,6 +32,14 @@ int  accept(int sockfd, struct sockaddr_in6* addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
+/// send(2) with MSG_ZEROCOPY, requires SO_ZEROCOPY.
+ssize_t sendZeroCopy(int sockfd, const void *buf, size_t count);
+/// Reads one MSG_ZEROCOPY notification from the error queue,
+/// sends [*lo, *hi] have completed, *copied tells the kernel
+/// fell back to copying the data.
+/// Returns false if the error queue holds no more notification.
+bool readZeroCopyCompletion(int sockfd, uint32_t* lo, uint32_t* hi, bool* copied);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
@@ -15,11 +15,20 @@
 #include "muduo/net/Socket.h"
 #include "muduo/net/SocketsOps.h"
 
+#include <algorithm>
+
 #include <errno.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+// seconds between polls of a destroyed connection for zero-copy completions
+const double kZeroCopyLingerInterval = 0.1;
+}  // namespace
+
 void muduo::net::defaultConnectionCallback(const TcpConnectionPtr& conn)
 {
   LOG_TRACE << conn->localAddress().toIpPort() << " -> "
@@ -48,7 +57,11 @@ TcpConnection::TcpConnection(EventLoop* loop,
     channel_(new Channel(loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    outputQueueBytes_(0),
+    zeroCopyThreshold_(0),
+    nextZeroCopyId_(0),
+    zeroCopyStats_()
 {
   channel_->setReadCallback(
       std::bind(&TcpConnection::handleRead, this, _1));
@@ -69,6 +82,10 @@ TcpConnection::~TcpConnection()
             << " fd=" << channel_->fd()
             << " state=" << stateToString();
   assert(state_ == kDisconnected);
+  if (!zeroCopySends_.empty())
+  {
+    lingerZeroCopySends();
+  }
 }
 
 bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
@@ -131,6 +148,29 @@ void TcpConnection::send(Buffer* buf)
   }
 }
 
+void TcpConnection::send(const BufferSlice& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendSliceInLoop(message);
+    }
+    else
+    {
+      loop_->runInLoop(
+          std::bind(&TcpConnection::sendSliceInLoop,
+                    this,     // FIXME
+                    message));
+    }
+  }
+}
+
+void TcpConnection::send(const std::shared_ptr<const string>& message)
+{
+  send(BufferSlice(message));
+}
+
 void TcpConnection::sendInLoop(const StringPiece& message)
 {
   sendInLoop(message.data(), message.size());
@@ -148,7 +188,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     return;
   }
   // if no thing in output queue, try writing directly
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0 && outputQueue_.empty())
   {
     nwrote = sockets::write(channel_->fd(), data, len);
     if (nwrote >= 0)
@@ -176,14 +216,24 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
   assert(remaining <= len);
   if (!faultError && remaining > 0)
   {
-    size_t oldLen = outputBuffer_.readableBytes();
+    size_t oldLen = outputBuffer_.readableBytes() + outputQueueBytes_;
     if (oldLen + remaining >= highWaterMark_
         && oldLen < highWaterMark_
         && highWaterMarkCallback_)
     {
       loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
     }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    if (outputQueue_.empty())
+    {
+      outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    }
+    else
+    {
+      // keep the order with payloads queued before
+      outputQueue_.push_back(
+          BufferSlice(string(static_cast<const char*>(data)+nwrote, remaining)));
+      outputQueueBytes_ += remaining;
+    }
     if (!channel_->isWriting())
     {
       channel_->enableWriting();
@@ -191,6 +241,229 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
   }
 }
 
+void TcpConnection::sendSliceInLoop(const BufferSlice& message)
+{
+  loop_->assertInLoopThread();
+  size_t nwrote = 0;
+  bool faultError = false;
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  if (zeroCopyThreshold_ > 0 && !useZeroCopy(message))
+  {
+    ++zeroCopyStats_.copies;
+  }
+  // if no thing in output queue, try writing directly
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0 && outputQueue_.empty())
+  {
+    ssize_t n = writeSlice(message);
+    if (n >= 0)
+    {
+      nwrote = n;
+      if (nwrote == message.size() && writeCompleteCallback_)
+      {
+        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    }
+    else if (errno != EWOULDBLOCK)
+    {
+      LOG_SYSERR << "TcpConnection::sendSliceInLoop";
+      if (errno == EPIPE || errno == ECONNRESET)
+      {
+        faultError = true;
+      }
+    }
+  }
+
+  if (!faultError && nwrote < message.size())
+  {
+    size_t remaining = message.size() - nwrote;
+    size_t oldLen = outputBuffer_.readableBytes() + outputQueueBytes_;
+    if (oldLen + remaining >= highWaterMark_
+        && oldLen < highWaterMark_
+        && highWaterMarkCallback_)
+    {
+      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+    }
+    // queued by reference, not copied
+    outputQueue_.push_back(message.slice(nwrote, remaining));
+    outputQueueBytes_ += remaining;
+    if (!channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+  }
+}
+
+ssize_t TcpConnection::writeSlice(const BufferSlice& slice)
+{
+  if (useZeroCopy(slice))
+  {
+    ssize_t n = sockets::sendZeroCopy(channel_->fd(), slice.data(), slice.size());
+    if (n >= 0)
+    {
+      // the kernel numbers every successful MSG_ZEROCOPY send
+      ZeroCopySend zc = { nextZeroCopyId_++, false, slice };
+      zeroCopySends_.push_back(std::move(zc));
+      ++zeroCopyStats_.sends;
+      return n;
+    }
+    else if (errno != ENOBUFS)
+    {
+      return n;
+    }
+    // exceeds optmem_max, falls back to copying
+    ++zeroCopyStats_.copies;
+  }
+  return sockets::write(channel_->fd(), slice.data(), slice.size());
+}
+
+ssize_t TcpConnection::writeOutput()
+{
+  if (outputBuffer_.readableBytes() == 0
+      && !outputQueue_.empty()
+      && useZeroCopy(outputQueue_.front()))
+  {
+    return writeSlice(outputQueue_.front());
+  }
+
+  // gathers outputBuffer_ and queued slices, up to a zero-copy one
+  const int kMaxIovecs = 64;
+  struct iovec vec[kMaxIovecs];
+  int iovcnt = 0;
+  if (outputBuffer_.readableBytes() > 0)
+  {
+    vec[iovcnt].iov_base = const_cast<char*>(outputBuffer_.peek());
+    vec[iovcnt].iov_len = outputBuffer_.readableBytes();
+    ++iovcnt;
+  }
+  for (const BufferSlice& slice : outputQueue_)
+  {
+    if (iovcnt == kMaxIovecs || useZeroCopy(slice))
+    {
+      break;
+    }
+    vec[iovcnt].iov_base = const_cast<char*>(slice.data());
+    vec[iovcnt].iov_len = slice.size();
+    ++iovcnt;
+  }
+  if (iovcnt == 1)
+  {
+    return sockets::write(channel_->fd(), vec[0].iov_base, vec[0].iov_len);
+  }
+  return sockets::writev(channel_->fd(), vec, iovcnt);
+}
+
+void TcpConnection::retrieveOutput(size_t len)
+{
+  size_t n = std::min(len, outputBuffer_.readableBytes());
+  outputBuffer_.retrieve(n);
+  len -= n;
+  while (len > 0)
+  {
+    assert(!outputQueue_.empty());
+    BufferSlice& front = outputQueue_.front();
+    n = std::min(len, front.size());
+    front.retrieve(n);
+    outputQueueBytes_ -= n;
+    len -= n;
+    if (front.empty())
+    {
+      outputQueue_.pop_front();
+    }
+  }
+}
+
+bool TcpConnection::setZeroCopy(size_t threshold)
+{
+  loop_->assertInLoopThread();
+  if (threshold > 0 && !socket_->setZeroCopy(true))
+  {
+    return false;
+  }
+  zeroCopyThreshold_ = threshold;
+  return true;
+}
+
+void TcpConnection::handleZeroCopyCompletions()
+{
+  reapZeroCopyCompletions(channel_->fd(), &zeroCopySends_, &zeroCopyStats_);
+}
+
+// return true if no send is pending
+bool TcpConnection::reapZeroCopyCompletions(int sockfd,
+                                            std::deque<ZeroCopySend>* sends,
+                                            ZeroCopyStats* stats)
+{
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  bool copied = false;
+  while (sockets::readZeroCopyCompletion(sockfd, &lo, &hi, &copied))
+  {
+    uint32_t count = hi - lo + 1;
+    stats->completions += count;
+    if (copied)
+    {
+      stats->kernelCopies += count;
+    }
+    // usually in order, but not guaranteed
+    for (ZeroCopySend& zc : *sends)
+    {
+      if (zc.id - lo <= hi - lo)
+      {
+        zc.completed = true;
+      }
+    }
+  }
+  while (!sends->empty() && sends->front().completed)
+  {
+    sends->pop_front();
+  }
+  return sends->empty();
+}
+
+// The kernel keeps reading the pinned pages of a MSG_ZEROCOPY send,
+// for transmit or retransmit, until its completion.  Freeing them
+// earlier lets malloc reuse the memory for something else, which
+// goes out on the wire.  So the payloads outlive the connection,
+// with the socket, closing it loses the completions.
+// TCP retransmission timeout bounds the wait, they're released
+// anyway if the loop quits first.
+struct TcpConnection::ZeroCopyLinger : noncopyable
+{
+  std::unique_ptr<Socket> socket;
+  std::deque<ZeroCopySend> sends;
+  ZeroCopyStats stats;
+  TimerId timer;
+};
+
+void TcpConnection::lingerZeroCopySends()
+{
+  std::shared_ptr<ZeroCopyLinger> linger(new ZeroCopyLinger);
+  linger->socket = std::move(socket_);
+  linger->sends.swap(zeroCopySends_);
+  linger->stats = zeroCopyStats_;
+  LOG_DEBUG << "TcpConnection::lingerZeroCopySends [" << name_
+            << "] fd=" << linger->socket->fd()
+            << " pending=" << linger->sends.size();
+  EventLoop* loop = loop_;
+  // no channel, polls the error queue
+  loop_->runInLoop([loop, linger] {
+    if (!reapZeroCopyCompletions(linger->socket->fd(), &linger->sends, &linger->stats))
+    {
+      linger->timer = loop->runEvery(kZeroCopyLingerInterval, [loop, linger] {
+        if (reapZeroCopyCompletions(linger->socket->fd(), &linger->sends, &linger->stats))
+        {
+          // the timer owns linger, closes the socket
+          loop->cancel(linger->timer);
+        }
+      });
+    }
+  });
+}
+
 void TcpConnection::shutdown()
 {
   // FIXME: use compare and swap
@@ -370,13 +643,11 @@ void TcpConnection::handleWrite()
   loop_->assertInLoopThread();
   if (channel_->isWriting())
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
+    ssize_t n = writeOutput();
     if (n > 0)
     {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0)
+      retrieveOutput(n);
+      if (outputBuffer_.readableBytes() == 0 && outputQueue_.empty())
       {
         channel_->disableWriting();
         if (writeCompleteCallback_)
@@ -422,8 +693,17 @@ void TcpConnection::handleClose()
 
 void TcpConnection::handleError()
 {
+  bool zeroCopy = zeroCopyThreshold_ > 0 || !zeroCopySends_.empty();
+  if (zeroCopy)
+  {
+    // MSG_ZEROCOPY completions come with POLLERR
+    handleZeroCopyCompletions();
+  }
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
-            << "] - SO_ERROR = " << err << " " << strerror_tl(err);
+  if (!zeroCopy || err != 0)
+  {
+    LOG_ERROR << "TcpConnection::handleError [" << name_
+              << "] - SO_ERROR = " << err << " " << strerror_tl(err);
+  }
 }
 
@@ -16,8 +16,10 @@
 #include "muduo/base/Types.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Buffer.h"
+#include "muduo/net/BufferSlice.h"
 #include "muduo/net/InetAddress.h"
 
+#include <deque>
 #include <memory>
 
 #include <boost/any.hpp>
@@ -67,11 +69,38 @@ class TcpConnection : noncopyable,
   void send(const StringPiece& message);
   // void send(Buffer&& message); // C++11
   void send(Buffer* message);  // this one will swap data
+  /// Sends a shared payload, which is referenced instead of copied
+  /// until it's fully written, or until the kernel completes the
+  /// zero-copy transmit, see @c setZeroCopy.
+  /// Queued slices are written together with writev(2).
+  void send(const BufferSlice& message);
+  void send(const std::shared_ptr<const string>& message);
   void shutdown(); // NOT thread safe, no simultaneous calling
   // void shutdownAndForceCloseAfter(double seconds); // NOT thread safe, no simultaneous calling
   void forceClose();
   void forceCloseWithDelay(double seconds);
   void setTcpNoDelay(bool on);
+
+  struct ZeroCopyStats
+  {
+    int64_t sends;         // send(2) calls with MSG_ZEROCOPY
+    int64_t completions;   // sends completed by the kernel
+    int64_t kernelCopies;  // completed, but the kernel copied the data
+    int64_t copies;        // messages below threshold, sent with write(2)
+  };
+
+  /// Sends shared payloads of at least @c threshold bytes with MSG_ZEROCOPY,
+  /// 0 disables it. Smaller messages are copied as usual.
+  /// Returns false if the kernel doesn't support SO_ZEROCOPY.
+  /// Must be called in the loop thread, eg. in ConnectionCallback.
+  bool setZeroCopy(size_t threshold);
+  const ZeroCopyStats& zeroCopyStats() const { return zeroCopyStats_; }
+
+  /// Bytes accepted by send() but not yet written to the socket.
+  /// Not thread safe, may race with sending in loop thread.
+  size_t outputBacklog() const
+  { return outputBuffer_.readableBytes() + outputQueueBytes_; }
+
   // reading or not
   void startRead();
   void stopRead();
@@ -123,6 +152,14 @@ class TcpConnection : noncopyable,
   // void sendInLoop(string&& message);
   void sendInLoop(const StringPiece& message);
   void sendInLoop(const void* message, size_t len);
+  void sendSliceInLoop(const BufferSlice& message);
+  bool useZeroCopy(const BufferSlice& slice) const
+  { return zeroCopyThreshold_ > 0 && slice.size() >= zeroCopyThreshold_; }
+  ssize_t writeSlice(const BufferSlice& slice);
+  ssize_t writeOutput();
+  void retrieveOutput(size_t len);
+  void handleZeroCopyCompletions();
+  void lingerZeroCopySends();
   void shutdownInLoop();
   // void shutdownAndForceCloseInLoop(double seconds);
   void forceCloseInLoop();
@@ -148,6 +185,27 @@ class TcpConnection : noncopyable,
   size_t highWaterMark_;
   Buffer inputBuffer_;
   Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
+
+  // shared payloads waiting for writing, after outputBuffer_
+  std::deque<BufferSlice> outputQueue_;
+  size_t outputQueueBytes_;
+
+  // payloads referenced by the kernel, until MSG_ZEROCOPY completions
+  struct ZeroCopySend
+  {
+    uint32_t id;
+    bool completed;
+    BufferSlice data;
+  };
+  struct ZeroCopyLinger;
+  static bool reapZeroCopyCompletions(int sockfd,
+                                      std::deque<ZeroCopySend>* sends,
+                                      ZeroCopyStats* stats);
+  std::deque<ZeroCopySend> zeroCopySends_;
+  size_t zeroCopyThreshold_;
+  uint32_t nextZeroCopyId_;
+  ZeroCopyStats zeroCopyStats_;
+
   boost::any context_;
   // FIXME: creationTime_, lastReceiveTime_
   //        bytesReceived_, bytesSent_
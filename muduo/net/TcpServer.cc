@@ -14,11 +14,45 @@
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/SocketsOps.h"
 
+#include <set>
+
 #include <stdio.h>  // snprintf
 
 using namespace muduo;
 using namespace muduo::net;
 
+// Tasks queued to io loops hold it, not TcpServer, so they are safe
+// to run after TcpServer is gone.
+struct TcpServer::LoopConnections : noncopyable
+{
+  typedef std::set<TcpConnectionPtr> ConnectionSet;
+
+  LoopConnections(EventLoop* loopArg, const string& nameArg,
+                  size_t maxBacklogArg, SlowConsumerPolicy policy)
+    : loop(loopArg),
+      name(nameArg),
+      maxBacklog(maxBacklogArg),
+      slowConsumerPolicy(policy)
+  {
+  }
+
+  void connectEstablished(const TcpConnectionPtr& conn);
+  void connectDestroyed(const TcpConnectionPtr& conn);
+  void destroyAll();
+  void joinGroup(const TcpConnectionPtr& conn, const string& group);
+  void leaveGroup(const TcpConnectionPtr& conn, const string& group);
+  void send(const string& group, const BufferSlice& message);
+  void sendToConnection(const TcpConnectionPtr& conn, const BufferSlice& message);
+
+  EventLoop* const loop;
+  const string name;
+  const size_t maxBacklog;
+  const SlowConsumerPolicy slowConsumerPolicy;
+  // connection to its groups
+  std::map<TcpConnectionPtr, std::set<string>> connections;
+  std::map<string, ConnectionSet> groups;
+};
+
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
                      const string& nameArg,
@@ -30,6 +64,10 @@ TcpServer::TcpServer(EventLoop* loop,
     threadPool_(new EventLoopThreadPool(loop, name_)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
+    maxConnections_(0),
+    maxConnectionsPerIp_(0),
+    maxBacklog_(0),
+    slowConsumerPolicy_(kSkipSlowConsumer),
     nextConnId_(1)
 {
   acceptor_->setNewConnectionCallback(
@@ -41,13 +79,13 @@ TcpServer::~TcpServer()
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
-  for (auto& item : connections_)
+  // after tasks queued before, which hold LoopConnections, not this
+  for (const auto& item : loopConnections_)
   {
-    TcpConnectionPtr conn(item.second);
-    item.second.reset();
-    conn->getLoop()->runInLoop(
-      std::bind(&TcpConnection::connectDestroyed, conn));
+    std::shared_ptr<LoopConnections> local(item.second);
+    item.first->runInLoop([local] { local->destroyAll(); });
   }
+  connections_.clear();
 }
 
 void TcpServer::setThreadNum(int numThreads)
@@ -56,13 +94,41 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setMaxConnections(int maxConnections)
+{
+  assert(0 <= maxConnections);
+  assert(started_.get() == 0);
+  maxConnections_ = maxConnections;
+}
+
+void TcpServer::setMaxConnectionsPerIp(int maxConnectionsPerIp)
+{
+  assert(0 <= maxConnectionsPerIp);
+  assert(started_.get() == 0);
+  maxConnectionsPerIp_ = maxConnectionsPerIp;
+}
+
+void TcpServer::setSlowConsumerPolicy(size_t maxBacklog, SlowConsumerPolicy policy)
+{
+  assert(started_.get() == 0);
+  maxBacklog_ = maxBacklog;
+  slowConsumerPolicy_ = policy;
+}
+
 void TcpServer::start()
 {
   if (started_.getAndSet(1) == 0)
   {
     threadPool_->start(threadInitCallback_);
+    // read-only from now on
+    for (EventLoop* ioLoop : threadPool_->getAllLoops())
+    {
+      loopConnections_[ioLoop] = std::make_shared<LoopConnections>(
+          ioLoop, name_, maxBacklog_, slowConsumerPolicy_);
+    }
 
     assert(!acceptor_->listenning());
+    acceptor_->setConnectionLimits(maxConnections_, maxConnectionsPerIp_);
     loop_->runInLoop(
         std::bind(&Acceptor::listen, get_pointer(acceptor_)));
   }
@@ -94,7 +160,8 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
       std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
-  ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+  std::shared_ptr<LoopConnections> local(loopConnections(ioLoop));
+  ioLoop->runInLoop([local, conn] { local->connectEstablished(conn); });
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
@@ -111,8 +178,156 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
   size_t n = connections_.erase(conn->name());
   (void)n;
   assert(n == 1);
+  acceptor_->connectionClosed(conn->peerAddress());
   EventLoop* ioLoop = conn->getLoop();
-  ioLoop->queueInLoop(
-      std::bind(&TcpConnection::connectDestroyed, conn));
+  std::shared_ptr<LoopConnections> local(loopConnections(ioLoop));
+  ioLoop->queueInLoop([local, conn] { local->connectDestroyed(conn); });
+}
+
+const std::shared_ptr<TcpServer::LoopConnections>&
+TcpServer::loopConnections(EventLoop* ioLoop) const
+{
+  auto it = loopConnections_.find(ioLoop);
+  assert(it != loopConnections_.end());
+  return it->second;
+}
+
+void TcpServer::joinGroup(const TcpConnectionPtr& conn, const string& group)
+{
+  std::shared_ptr<LoopConnections> local(loopConnections(conn->getLoop()));
+  conn->getLoop()->runInLoop([local, conn, group] { local->joinGroup(conn, group); });
+}
+
+void TcpServer::leaveGroup(const TcpConnectionPtr& conn, const string& group)
+{
+  std::shared_ptr<LoopConnections> local(loopConnections(conn->getLoop()));
+  conn->getLoop()->runInLoop([local, conn, group] { local->leaveGroup(conn, group); });
+}
+
+void TcpServer::broadcast(const BufferSlice& message)
+{
+  postToAllLoops(string(), message);
+}
+
+void TcpServer::multicast(const string& group, const BufferSlice& message)
+{
+  assert(!group.empty());
+  postToAllLoops(group, message);
+}
+
+void TcpServer::postToAllLoops(const string& group, const BufferSlice& message)
+{
+  assert(started_.get() == 1);
+  for (const auto& item : loopConnections_)
+  {
+    std::shared_ptr<LoopConnections> local(item.second);
+    item.first->runInLoop([local, group, message] { local->send(group, message); });
+  }
 }
 
+void TcpServer::LoopConnections::connectEstablished(const TcpConnectionPtr& conn)
+{
+  loop->assertInLoopThread();
+  connections[conn];
+  conn->connectEstablished();
+}
+
+void TcpServer::LoopConnections::connectDestroyed(const TcpConnectionPtr& conn)
+{
+  loop->assertInLoopThread();
+  auto it = connections.find(conn);
+  // or destroyed by destroyAll() already
+  if (it != connections.end())
+  {
+    for (const string& group : it->second)
+    {
+      auto git = groups.find(group);
+      git->second.erase(conn);
+      if (git->second.empty())
+      {
+        groups.erase(git);
+      }
+    }
+    connections.erase(it);
+    conn->connectDestroyed();
+  }
+}
+
+void TcpServer::LoopConnections::destroyAll()
+{
+  loop->assertInLoopThread();
+  for (const auto& item : connections)
+  {
+    item.first->connectDestroyed();
+  }
+  connections.clear();
+  groups.clear();
+}
+
+void TcpServer::LoopConnections::joinGroup(const TcpConnectionPtr& conn, const string& group)
+{
+  loop->assertInLoopThread();
+  auto it = connections.find(conn);
+  // ignores connections already destroyed
+  if (it != connections.end() && it->second.insert(group).second)
+  {
+    groups[group].insert(conn);
+  }
+}
+
+void TcpServer::LoopConnections::leaveGroup(const TcpConnectionPtr& conn, const string& group)
+{
+  loop->assertInLoopThread();
+  auto it = connections.find(conn);
+  if (it != connections.end() && it->second.erase(group) == 1)
+  {
+    auto git = groups.find(group);
+    git->second.erase(conn);
+    if (git->second.empty())
+    {
+      groups.erase(git);
+    }
+  }
+}
+
+void TcpServer::LoopConnections::send(const string& group, const BufferSlice& message)
+{
+  loop->assertInLoopThread();
+  if (group.empty())
+  {
+    for (const auto& item : connections)
+    {
+      sendToConnection(item.first, message);
+    }
+  }
+  else
+  {
+    auto git = groups.find(group);
+    if (git != groups.end())
+    {
+      for (const TcpConnectionPtr& conn : git->second)
+      {
+        sendToConnection(conn, message);
+      }
+    }
+  }
+}
+
+void TcpServer::LoopConnections::sendToConnection(const TcpConnectionPtr& conn,
+                                                  const BufferSlice& message)
+{
+  if (maxBacklog > 0 && conn->outputBacklog() > maxBacklog)
+  {
+    if (slowConsumerPolicy == kDisconnectSlowConsumer && conn->connected())
+    {
+      LOG_WARN << "TcpServer::sendToConnection [" << name
+               << "] - disconnects slow consumer " << conn->name()
+               << " with " << conn->outputBacklog() << " bytes backlog";
+      conn->forceClose();
+    }
+  }
+  else
+  {
+    conn->send(message);
+  }
+}
@@ -62,12 +62,27 @@ class TcpServer : noncopyable
   /// - N means a thread pool with N threads, new connections
   ///   are assigned on a round-robin basis.
   void setThreadNum(int numThreads);
+  /// Runs in io loop threads concurrently, see EventLoopThreadPool::start().
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
   /// valid after calling start()
   std::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
 
+  /// Limits the number of concurrent connections, 0 means unlimited.
+  ///
+  /// Enforced by the acceptor before any TcpConnection is created,
+  /// it stops accepting when the limit is reached,
+  /// and resumes when connections drop below it.
+  /// Must be called before @c start
+  void setMaxConnections(int maxConnections);
+
+  /// Limits concurrent connections from one peer IP, 0 means unlimited.
+  ///
+  /// Excess connections are closed right after accepting.
+  /// Must be called before @c start
+  void setMaxConnectionsPerIp(int maxConnectionsPerIp);
+
   /// Starts the server if it's not listenning.
   ///
   /// It's harmless to call it multiple times.
@@ -89,6 +104,34 @@ class TcpServer : noncopyable
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }
 
+  enum SlowConsumerPolicy
+  {
+    kSkipSlowConsumer,
+    kDisconnectSlowConsumer,
+  };
+
+  /// What broadcast() and multicast() do to a connection whose
+  /// TcpConnection::outputBacklog() exceeds @c maxBacklog bytes,
+  /// 0 means unlimited, the default.
+  /// Must be called before @c start
+  void setSlowConsumerPolicy(size_t maxBacklog, SlowConsumerPolicy policy);
+
+  /// Sends @c message to all connections.
+  ///
+  /// Posts one task per io loop, which sends to its own connections,
+  /// all of them share @c message.
+  /// Thread safe, after @c start.
+  void broadcast(const BufferSlice& message);
+
+  /// Sends @c message to connections in @c group, same as broadcast().
+  /// Thread safe, after @c start.
+  void multicast(const string& group, const BufferSlice& message);
+
+  /// Connections leave all groups when disconnected.
+  /// Thread safe.
+  void joinGroup(const TcpConnectionPtr& conn, const string& group);
+  void leaveGroup(const TcpConnectionPtr& conn, const string& group);
+
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);
@@ -97,18 +140,29 @@ class TcpServer : noncopyable
   /// Not thread safe, but in loop
   void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
+  // connections of one io loop, only touched in that loop
+  struct LoopConnections;
+  const std::shared_ptr<LoopConnections>& loopConnections(EventLoop* ioLoop) const;
+  void postToAllLoops(const string& group, const BufferSlice& message);
+
   typedef std::map<string, TcpConnectionPtr> ConnectionMap;
 
   EventLoop* loop_;  // the acceptor loop
   const string ipPort_;
   const string name_;
   std::unique_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+  // filled in start(), emptied in io loops after dtor
+  std::map<EventLoop*, std::shared_ptr<LoopConnections>> loopConnections_;
   std::shared_ptr<EventLoopThreadPool> threadPool_;
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
   WriteCompleteCallback writeCompleteCallback_;
   ThreadInitCallback threadInitCallback_;
   AtomicInt32 started_;
+  int maxConnections_;
+  int maxConnectionsPerIp_;
+  size_t maxBacklog_;
+  SlowConsumerPolicy slowConsumerPolicy_;
   // always in loop thread
   int nextConnId_;
   ConnectionMap connections_;
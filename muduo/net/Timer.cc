@@ -8,6 +8,8 @@
 
 #include "muduo/net/Timer.h"
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -17,10 +19,32 @@ void Timer::restart(Timestamp now)
 {
   if (repeat_)
   {
-    expiration_ = addTime(now, interval_);
+    // schedules from last deadline instead of now, so it doesn't drift,
+    // skips missed periods if we are falling behind.
+    int64_t interval = std::max<int64_t>(1,
+        static_cast<int64_t>(interval_ * Timestamp::kMicroSecondsPerSecond));
+    int64_t next = deadline_.microSecondsSinceEpoch() + interval;
+    int64_t late = now.microSecondsSinceEpoch() - next;
+    if (late >= 0)
+    {
+      next += (late / interval + 1) * interval;
+    }
+    deadline_ = Timestamp(next);
+    expiration_ = coalesce(deadline_, slack_);
   }
   else
   {
     expiration_ = Timestamp::invalid();
   }
 }
+
+Timestamp Timer::coalesce(Timestamp when, double slack)
+{
+  int64_t granularity = static_cast<int64_t>(slack * Timestamp::kMicroSecondsPerSecond);
+  if (granularity <= 1)
+  {
+    return when;
+  }
+  int64_t microSeconds = when.microSecondsSinceEpoch() + granularity - 1;
+  return Timestamp(microSeconds - microSeconds % granularity);
+}
@@ -26,10 +26,12 @@ namespace net
 class Timer : noncopyable
 {
  public:
-  Timer(TimerCallback cb, Timestamp when, double interval)
+  Timer(TimerCallback cb, Timestamp when, double interval, double slack)
     : callback_(std::move(cb)),
-      expiration_(when),
+      deadline_(when),
+      expiration_(coalesce(when, slack)),
       interval_(interval),
+      slack_(slack),
       repeat_(interval > 0.0),
       sequence_(s_numCreated_.incrementAndGet())
   { }
@@ -47,10 +49,16 @@ class Timer : noncopyable
 
   static int64_t numCreated() { return s_numCreated_.get(); }
 
+  /// Rounds @c when up to a multiple of @c slack seconds,
+  /// so that timers with same slack share expirations.
+  static Timestamp coalesce(Timestamp when, double slack);
+
  private:
   const TimerCallback callback_;
+  Timestamp deadline_;  // as requested, before coalescing
   Timestamp expiration_;
   const double interval_;
+  const double slack_;
   const bool repeat_;
   const int64_t sequence_;
 
@@ -17,6 +17,7 @@
 #include "muduo/net/Timer.h"
 #include "muduo/net/TimerId.h"
 
+#include <stdlib.h>
 #include <sys/timerfd.h>
 #include <unistd.h>
 
@@ -90,22 +91,28 @@ using namespace muduo::net::detail;
 
 TimerQueue::TimerQueue(EventLoop* loop)
   : loop_(loop),
-    timerfd_(createTimerfd()),
+    timerfd_(::getenv("MUDUO_NO_TIMERFD") ? -1 : createTimerfd()),
     timerfdChannel_(loop, timerfd_),
     timers_(),
     callingExpiredTimers_(false)
 {
-  timerfdChannel_.setReadCallback(
-      std::bind(&TimerQueue::handleRead, this));
-  // we are always reading the timerfd, we disarm it with timerfd_settime.
-  timerfdChannel_.enableReading();
+  if (usesTimerfd())
+  {
+    timerfdChannel_.setReadCallback(
+        std::bind(&TimerQueue::handleRead, this, _1));
+    // we are always reading the timerfd, we disarm it with timerfd_settime.
+    timerfdChannel_.enableReading();
+  }
 }
 
 TimerQueue::~TimerQueue()
 {
-  timerfdChannel_.disableAll();
-  timerfdChannel_.remove();
-  ::close(timerfd_);
+  if (usesTimerfd())
+  {
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+  }
   // do not remove channel, since we're in EventLoop::dtor();
   for (const Entry& timer : timers_)
   {
@@ -115,9 +122,10 @@ TimerQueue::~TimerQueue()
 
 TimerId TimerQueue::addTimer(TimerCallback cb,
                              Timestamp when,
-                             double interval)
+                             double interval,
+                             double slack)
 {
-  Timer* timer = new Timer(std::move(cb), when, interval);
+  Timer* timer = new Timer(std::move(cb), when, interval, slack);
   loop_->runInLoop(
       std::bind(&TimerQueue::addTimerInLoop, this, timer));
   return TimerId(timer, timer->sequence());
@@ -134,7 +142,7 @@ void TimerQueue::addTimerInLoop(Timer* timer)
   loop_->assertInLoopThread();
   bool earliestChanged = insert(timer);
 
-  if (earliestChanged)
+  if (earliestChanged && usesTimerfd())
   {
     resetTimerfd(timerfd_, timer->expiration());
   }
@@ -160,12 +168,32 @@ void TimerQueue::cancelInLoop(TimerId timerId)
   assert(timers_.size() == activeTimers_.size());
 }
 
-void TimerQueue::handleRead()
+void TimerQueue::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
-  Timestamp now(Timestamp::now());
+  // poll return time, saves a clock read
+  Timestamp now(receiveTime);
   readTimerfd(timerfd_, now);
+  handleExpired(now);
+}
+
+Timestamp TimerQueue::nextExpiration() const
+{
+  return timers_.empty() ? Timestamp::invalid() : timers_.begin()->first;
+}
 
+void TimerQueue::runExpired(Timestamp now)
+{
+  loop_->assertInLoopThread();
+  assert(!usesTimerfd());
+  if (!timers_.empty() && !(now < timers_.begin()->first))
+  {
+    handleExpired(now);
+  }
+}
+
+void TimerQueue::handleExpired(Timestamp now)
+{
   std::vector<Entry> expired = getExpired(now);
 
   callingExpiredTimers_ = true;
@@ -226,7 +254,7 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
     nextExpire = timers_.begin()->second->expiration();
   }
 
-  if (nextExpire.valid())
+  if (nextExpire.valid() && usesTimerfd())
   {
     resetTimerfd(timerfd_, nextExpire);
   }
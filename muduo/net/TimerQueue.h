@@ -41,14 +41,26 @@ class TimerQueue : noncopyable
   ///
   /// Schedules the callback to be run at given time,
   /// repeats if @c interval > 0.0.
+  /// Expiration may be delayed up to @c slack seconds to share
+  /// a wakeup with other timers, see Timer::coalesce().
   ///
   /// Must be thread safe. Usually be called from other threads.
   TimerId addTimer(TimerCallback cb,
                    Timestamp when,
-                   double interval);
+                   double interval,
+                   double slack = 0.0);
 
   void cancel(TimerId timerId);
 
+  ///
+  /// Without timerfd, EventLoop polls until nextExpiration(),
+  /// and calls runExpired() after poll returns.
+  /// Set environment variable MUDUO_NO_TIMERFD to use this mode.
+  ///
+  bool usesTimerfd() const { return timerfd_ >= 0; }
+  Timestamp nextExpiration() const;
+  void runExpired(Timestamp now);
+
  private:
 
   // FIXME: use unique_ptr<Timer> instead of raw pointers.
@@ -62,7 +74,8 @@ class TimerQueue : noncopyable
   void addTimerInLoop(Timer* timer);
   void cancelInLoop(TimerId timerId);
   // called when timerfd alarms
-  void handleRead();
+  void handleRead(Timestamp receiveTime);
+  void handleExpired(Timestamp now);
   // move out all expired timers
   std::vector<Entry> getExpired(Timestamp now);
   void reset(const std::vector<Entry>& expired, Timestamp now);
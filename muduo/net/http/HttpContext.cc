@@ -10,6 +10,12 @@
 #include "muduo/net/Buffer.h"
 #include "muduo/net/http/HttpContext.h"
 
+#include <algorithm>
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -56,6 +62,244 @@ bool HttpContext::processRequestLine(const char* begin, const char* end)
   return succeed;
 }
 
+namespace
+{
+
+// field names are case-insensitive, NULL if not found
+const string* findHeader(const HttpRequest& request, const char* field)
+{
+  for (const auto& header : request.headers())
+  {
+    if (strcasecmp(header.first.c_str(), field) == 0)
+    {
+      return &header.second;
+    }
+  }
+  return NULL;
+}
+
+// Content-Length or Transfer-Encoding again, in any case, would be
+// a way of request smuggling if either one was taken, RFC 7230 3.3.3
+bool isRepeatedFraming(const HttpRequest& request, const char* begin, const char* colon)
+{
+  string field(begin, colon);
+  return (strcasecmp(field.c_str(), "Content-Length") == 0
+          || strcasecmp(field.c_str(), "Transfer-Encoding") == 0)
+      && findHeader(request, field.c_str()) != NULL;
+}
+
+int hexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  else if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  else
+    return c - 'A' + 10;
+}
+
+}  // namespace
+
+bool detail::isChunked(StringPiece transferEncoding)
+{
+  const int len = static_cast<int>(strlen("chunked"));
+  const int pos = transferEncoding.size();
+  const char* data = transferEncoding.data();
+  return pos >= len
+      && strncasecmp(data + pos - len, "chunked", len) == 0
+      && (pos == len || data[pos - len - 1] == ',' || data[pos - len - 1] == ' ');
+}
+
+HttpResponse::HttpStatusCode detail::parseContentLength(StringPiece value,
+                                                        size_t maxBodyBytes,
+                                                        size_t* length)
+{
+  if (value.empty())
+  {
+    return HttpResponse::k400BadRequest;
+  }
+  *length = 0;
+  for (int i = 0; i < value.size(); ++i)
+  {
+    if (!isdigit(value[i]))
+    {
+      return HttpResponse::k400BadRequest;
+    }
+    *length = *length * 10 + static_cast<size_t>(value[i] - '0');
+    if (*length > maxBodyBytes)
+    {
+      return HttpResponse::k413PayloadTooLarge;
+    }
+  }
+  return HttpResponse::kUnknown;
+}
+
+bool detail::isValidFieldName(const char* begin, const char* colon)
+{
+  return begin < colon
+      && std::find_if(begin, colon, [](char c) { return c == ' ' || c == '\t'; }) == colon;
+}
+
+HttpResponse::HttpStatusCode detail::parseChunkSize(const char* begin,
+                                                    const char* end,
+                                                    size_t* size)
+{
+  *size = 0;
+  const char* p = begin;
+  while (p < end && isxdigit(*p))
+  {
+    *size = *size * 16 + static_cast<size_t>(hexValue(*p));
+    if (++p - begin > 15)
+    {
+      return HttpResponse::k413PayloadTooLarge;
+    }
+  }
+  const char* digitsEnd = p;
+  while (p < end && (*p == ' ' || *p == '\t'))
+  {
+    ++p;
+  }
+  // chunk extensions after ';' are ignored
+  if (digitsEnd == begin || (p != end && *p != ';'))
+  {
+    return HttpResponse::k400BadRequest;
+  }
+  return HttpResponse::kUnknown;
+}
+
+bool HttpContext::fail(HttpResponse::HttpStatusCode error)
+{
+  error_ = error;
+  return false;
+}
+
+bool HttpContext::processHeadersEnd()
+{
+  const string* transferEncoding = findHeader(request_, "Transfer-Encoding");
+  const string* contentLength = findHeader(request_, "Content-Length");
+  if (transferEncoding)
+  {
+    // both are a way of request smuggling, RFC 7230 3.3.3
+    if (contentLength || !detail::isChunked(*transferEncoding))
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    state_ = kExpectChunkSize;
+  }
+  else if (contentLength)
+  {
+    size_t length = 0;
+    HttpResponse::HttpStatusCode error =
+        detail::parseContentLength(*contentLength, maxBodyBytes_, &length);
+    if (error != HttpResponse::kUnknown)
+    {
+      return fail(error);
+    }
+    bodyRemaining_ = length;
+    state_ = length > 0 ? kExpectBody : kGotAll;
+    request_.reserveBody(length);
+  }
+  else
+  {
+    state_ = kGotAll;
+  }
+
+  const string* expect = findHeader(request_, "Expect");
+  expectContinue_ = state_ != kGotAll && expect
+      && strcasecmp(expect->c_str(), "100-continue") == 0;
+  return true;
+}
+
+bool HttpContext::processChunkSize(const char* begin, const char* end)
+{
+  size_t size = 0;
+  HttpResponse::HttpStatusCode error = detail::parseChunkSize(begin, end, &size);
+  if (error != HttpResponse::kUnknown)
+  {
+    return fail(error);
+  }
+  if (request_.body().size() + size > maxBodyBytes_)
+  {
+    return fail(HttpResponse::k413PayloadTooLarge);
+  }
+  bodyRemaining_ = size;
+  state_ = size > 0 ? kExpectChunkData : kExpectChunkTrailer;
+  return true;
+}
+
+// moves body from buf to request
+bool HttpContext::processBody(Buffer* buf)
+{
+  size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+  request_.appendBody(buf->peek(), n);
+  buf->retrieve(n);
+  bodyRemaining_ -= n;
+  if (bodyRemaining_ == 0)
+  {
+    if (state_ == kExpectBody)
+    {
+      state_ = kGotAll;
+    }
+    else if (buf->readableBytes() >= 2)
+    {
+      // CRLF after chunk data
+      if (buf->peek()[0] != '\r' || buf->peek()[1] != '\n')
+      {
+        return fail(HttpResponse::k400BadRequest);
+      }
+      buf->retrieve(2);
+      state_ = kExpectChunkSize;
+    }
+  }
+  return true;
+}
+
+// request line, a header, a chunk size or a trailer, without CRLF
+bool HttpContext::processLine(const char* begin, const char* end, Timestamp receiveTime)
+{
+  if (state_ == kExpectRequestLine)
+  {
+    if (!processRequestLine(begin, end))
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    request_.setReceiveTime(receiveTime);
+    state_ = kExpectHeaders;
+    return true;
+  }
+  else if (state_ == kExpectChunkSize)
+  {
+    return processChunkSize(begin, end);
+  }
+
+  const char* colon = std::find(begin, end, ':');
+  if (begin != end)
+  {
+    if (colon == end || !detail::isValidFieldName(begin, colon))
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    else if (state_ == kExpectChunkTrailer)
+    {
+      // trailers are discarded, so they can't override headers, RFC 7230 4.1.2
+      return true;
+    }
+    else if (isRepeatedFraming(request_, begin, colon))
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    request_.addHeader(begin, colon, end);
+    return true;
+  }
+  else if (state_ == kExpectHeaders)
+  {
+    // empty line, end of header
+    return processHeadersEnd();
+  }
+  state_ = kGotAll;
+  return true;
+}
+
 // return false if any error
 bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
 {
@@ -63,56 +307,35 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
   bool hasMore = true;
   while (hasMore)
   {
-    if (state_ == kExpectRequestLine)
+    const HttpRequestParseState state = state_;
+    const size_t readable = buf->readableBytes();
+    if (state_ == kExpectBody || state_ == kExpectChunkData)
+    {
+      ok = processBody(buf);
+    }
+    else if (state_ != kGotAll)
     {
       const char* crlf = buf->findCRLF();
-      if (crlf)
+      const size_t lineBytes = crlf ? crlf + 2 - buf->peek() : readable;
+      // a partial line counts too, so a peer can not grow buf for ever
+      if (state_ == kExpectChunkSize)
       {
-        ok = processRequestLine(buf->peek(), crlf);
-        if (ok)
-        {
-          request_.setReceiveTime(receiveTime);
-          buf->retrieveUntil(crlf + 2);
-          state_ = kExpectHeaders;
-        }
-        else
-        {
-          hasMore = false;
-        }
+        ok = lineBytes <= detail::kMaxChunkSizeLine || fail(HttpResponse::k400BadRequest);
       }
       else
       {
-        hasMore = false;
+        ok = headerBytes_ + lineBytes <= maxHeaderBytes_
+            || fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+        headerBytes_ += crlf ? lineBytes : 0;
       }
-    }
-    else if (state_ == kExpectHeaders)
-    {
-      const char* crlf = buf->findCRLF();
-      if (crlf)
+      if (ok && crlf)
       {
-        const char* colon = std::find(buf->peek(), crlf, ':');
-        if (colon != crlf)
-        {
-          request_.addHeader(buf->peek(), colon, crlf);
-        }
-        else
-        {
-          // empty line, end of header
-          // FIXME:
-          state_ = kGotAll;
-          hasMore = false;
-        }
+        ok = processLine(buf->peek(), crlf, receiveTime);
         buf->retrieveUntil(crlf + 2);
       }
-      else
-      {
-        hasMore = false;
-      }
-    }
-    else if (state_ == kExpectBody)
-    {
-      // FIXME:
     }
+    hasMore = ok && state_ != kGotAll
+        && (state_ != state || buf->readableBytes() != readable);
   }
   return ok;
 }
@@ -12,8 +12,10 @@
 #define MUDUO_NET_HTTP_HTTPCONTEXT_H
 
 #include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
 
 #include "muduo/net/http/HttpRequest.h"
+#include "muduo/net/http/HttpResponse.h"
 
 namespace muduo
 {
@@ -22,6 +24,31 @@ namespace net
 
 class Buffer;
 
+namespace detail
+{
+
+// Framing shared with HttpParser, status codes are kUnknown if no error.
+
+// longest chunk size line, with extensions
+const size_t kMaxChunkSizeLine = 1024;
+
+// "chunked" is the last transfer coding
+bool isChunked(StringPiece transferEncoding);
+// decimal digits only, at most maxBodyBytes
+HttpResponse::HttpStatusCode parseContentLength(StringPiece value,
+                                                size_t maxBodyBytes,
+                                                size_t* length);
+// name before ':' of a header or trailer, not empty, no SP or HTAB,
+// RFC 7230 3.2.4, so "Content-Length : 5" can't hide from lookups.
+// A line beginning with either is an obs-fold, rejected too.
+bool isValidFieldName(const char* begin, const char* colon);
+// hex digits, then optional extensions
+HttpResponse::HttpStatusCode parseChunkSize(const char* begin,
+                                            const char* end,
+                                            size_t* size);
+
+}  // namespace detail
+
 class HttpContext : public muduo::copyable
 {
  public:
@@ -29,26 +56,63 @@ class HttpContext : public muduo::copyable
   {
     kExpectRequestLine,
     kExpectHeaders,
-    kExpectBody,
+    kExpectBody,        // of Content-Length
+    kExpectChunkSize,
+    kExpectChunkData,
+    kExpectChunkTrailer,
     kGotAll,
   };
 
+  static const size_t kDefaultMaxHeaderBytes = 64*1024;
+  static const size_t kDefaultMaxBodyBytes = 1024*1024;
+
   HttpContext()
-    : state_(kExpectRequestLine)
+    : state_(kExpectRequestLine),
+      maxHeaderBytes_(kDefaultMaxHeaderBytes),
+      maxBodyBytes_(kDefaultMaxBodyBytes),
+      headerBytes_(0),
+      bodyRemaining_(0),
+      expectContinue_(false),
+      error_(HttpResponse::kUnknown)
   {
   }
 
   // default copy-ctor, dtor and assignment are fine
 
+  /// Request line and headers longer than @c maxHeaderBytes are rejected
+  /// with 431, bodies longer than @c maxBodyBytes with 413.
+  void setLimits(size_t maxHeaderBytes, size_t maxBodyBytes)
+  {
+    maxHeaderBytes_ = maxHeaderBytes;
+    maxBodyBytes_ = maxBodyBytes;
+  }
+
   // return false if any error
   bool parseRequest(Buffer* buf, Timestamp receiveTime);
 
   bool gotAll() const
   { return state_ == kGotAll; }
 
+  /// Status to reply after parseRequest() returned false.
+  HttpResponse::HttpStatusCode error() const
+  { return error_; }
+
+  /// True once after headers of "Expect: 100-continue",
+  /// the body is sent after "100 Continue".
+  bool takeExpectContinue()
+  {
+    bool expect = expectContinue_;
+    expectContinue_ = false;
+    return expect;
+  }
+
   void reset()
   {
     state_ = kExpectRequestLine;
+    headerBytes_ = 0;
+    bodyRemaining_ = 0;
+    expectContinue_ = false;
+    error_ = HttpResponse::kUnknown;
     HttpRequest dummy;
     request_.swap(dummy);
   }
@@ -61,9 +125,20 @@ class HttpContext : public muduo::copyable
 
  private:
   bool processRequestLine(const char* begin, const char* end);
+  bool processHeadersEnd();
+  bool processChunkSize(const char* begin, const char* end);
+  bool processBody(Buffer* buf);
+  bool processLine(const char* begin, const char* end, Timestamp receiveTime);
+  bool fail(HttpResponse::HttpStatusCode error);
 
   HttpRequestParseState state_;
   HttpRequest request_;
+  size_t maxHeaderBytes_;
+  size_t maxBodyBytes_;
+  size_t headerBytes_;    // request line, headers and trailers
+  size_t bodyRemaining_;  // of Content-Length or current chunk
+  bool expectContinue_;
+  HttpResponse::HttpStatusCode error_;
 };
 
 }  // namespace net
@@ -0,0 +1,363 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/http/HttpParser.h"
+
+#include "muduo/net/Buffer.h"
+
+#include <algorithm>
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+struct KnownHeaderName
+{
+  const char* name;
+  size_t length;
+  HttpRequestView::KnownHeader header;
+};
+
+#define KNOWN_HEADER(name, header) { name, sizeof(name) - 1, HttpRequestView::header }
+
+const KnownHeaderName kKnownHeaders[] =
+{
+  KNOWN_HEADER("Host", kHost),
+  KNOWN_HEADER("Connection", kConnection),
+  KNOWN_HEADER("Content-Length", kContentLength),
+  KNOWN_HEADER("Content-Type", kContentType),
+  KNOWN_HEADER("Transfer-Encoding", kTransferEncoding),
+  KNOWN_HEADER("Expect", kExpect),
+  KNOWN_HEADER("Accept-Encoding", kAcceptEncoding),
+  KNOWN_HEADER("User-Agent", kUserAgent),
+  KNOWN_HEADER("Cookie", kCookie),
+  KNOWN_HEADER("Authorization", kAuthorization),
+};
+
+#undef KNOWN_HEADER
+
+HttpRequestView::KnownHeader classify(const char* field, size_t length)
+{
+  for (const KnownHeaderName& known : kKnownHeaders)
+  {
+    if (known.length == length && strncasecmp(known.name, field, length) == 0)
+    {
+      return known.header;
+    }
+  }
+  return HttpRequestView::kOtherHeader;
+}
+
+// memchr(3) is vectorized, memmem(3) of a short needle is not
+const char* findCRLF(const char* begin, const char* end)
+{
+  const char* cr = begin;
+  while ((cr = static_cast<const char*>(memchr(cr, '\r', end - cr))) != NULL)
+  {
+    if (cr + 1 < end && cr[1] == '\n')
+    {
+      return cr;
+    }
+    ++cr;
+  }
+  return NULL;
+}
+
+HttpRequestView::Method parseMethod(const char* begin, const char* end)
+{
+  switch (end - begin)
+  {
+    case 3:
+      if (memcmp(begin, "GET", 3) == 0)
+        return HttpRequest::kGet;
+      if (memcmp(begin, "PUT", 3) == 0)
+        return HttpRequest::kPut;
+      break;
+    case 4:
+      if (memcmp(begin, "POST", 4) == 0)
+        return HttpRequest::kPost;
+      if (memcmp(begin, "HEAD", 4) == 0)
+        return HttpRequest::kHead;
+      break;
+    case 6:
+      if (memcmp(begin, "DELETE", 6) == 0)
+        return HttpRequest::kDelete;
+      break;
+    default:
+      break;
+  }
+  return HttpRequest::kInvalid;
+}
+
+}  // namespace
+
+bool HttpParser::fail(HttpResponse::HttpStatusCode error)
+{
+  error_ = error;
+  return false;
+}
+
+bool HttpParser::parseRequestLine(const char* begin, const char* end)
+{
+  const char* base = request_.base_;
+  const char* space = std::find(begin, end, ' ');
+  if (space == end)
+  {
+    return false;
+  }
+  request_.method_ = parseMethod(begin, space);
+  if (request_.method_ == HttpRequest::kInvalid)
+  {
+    return false;
+  }
+  const char* start = space + 1;
+  space = std::find(start, end, ' ');
+  if (space == end)
+  {
+    return false;
+  }
+  const char* question = std::find(start, space, '?');
+  request_.path_.offset = static_cast<uint32_t>(start - base);
+  request_.path_.length = static_cast<uint32_t>(question - start);
+  request_.query_.offset = static_cast<uint32_t>(question - base);
+  request_.query_.length = static_cast<uint32_t>(space - question);
+
+  start = space + 1;
+  if (end - start != 8 || memcmp(start, "HTTP/1.", 7) != 0)
+  {
+    return false;
+  }
+  if (start[7] == '1')
+  {
+    request_.version_ = HttpRequest::kHttp11;
+  }
+  else if (start[7] == '0')
+  {
+    request_.version_ = HttpRequest::kHttp10;
+  }
+  return request_.version_ != HttpRequest::kUnknown;
+}
+
+// same trimming as HttpRequest::addHeader(), return false if any error
+bool HttpParser::addHeader(const char* begin, const char* colon, const char* end)
+{
+  const char* base = request_.base_;
+  const char* value = colon + 1;
+  while (value < end && isspace(*value))
+  {
+    ++value;
+  }
+  while (end > value && isspace(end[-1]))
+  {
+    --end;
+  }
+  HttpRequestView::Header header;
+  header.field.offset = static_cast<uint32_t>(begin - base);
+  header.field.length = static_cast<uint32_t>(colon - begin);
+  header.value.offset = static_cast<uint32_t>(value - base);
+  header.value.length = static_cast<uint32_t>(end - value);
+  header.kind = classify(begin, header.field.length);
+
+  if (header.kind == HttpRequestView::kContentLength
+      || header.kind == HttpRequestView::kTransferEncoding)
+  {
+    // again, in any case, would be a way of request smuggling, RFC 7230 3.3.3
+    if (request_.known_[header.kind] >= 0)
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    // must be found by processHeadersEnd()
+    if (request_.headers_.size() >= INT16_MAX)
+    {
+      return fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+    }
+  }
+  if (header.kind != HttpRequestView::kOtherHeader
+      && request_.known_[header.kind] < 0
+      && request_.headers_.size() < INT16_MAX)
+  {
+    request_.known_[header.kind] = static_cast<int16_t>(request_.headers_.size());
+  }
+  request_.headers_.push_back(header);
+  return true;
+}
+
+// request line or a header, without CRLF
+bool HttpParser::processHeadLine(const char* begin, const char* end, Timestamp receiveTime)
+{
+  if (request_.method_ == HttpRequest::kInvalid)
+  {
+    request_.receiveTime_ = receiveTime;
+    return parseRequestLine(begin, end) || fail(HttpResponse::k400BadRequest);
+  }
+  else if (begin == end)
+  {
+    // empty line, end of header
+    return processHeadersEnd();
+  }
+  const char* colon = std::find(begin, end, ':');
+  if (colon == end || !detail::isValidFieldName(begin, colon))
+  {
+    return fail(HttpResponse::k400BadRequest);
+  }
+  return addHeader(begin, colon, end);
+}
+
+bool HttpParser::processHeadersEnd()
+{
+  StringPiece transferEncoding = request_.getHeader(HttpRequestView::kTransferEncoding);
+  StringPiece contentLength = request_.getHeader(HttpRequestView::kContentLength);
+  bool hasContentLength = request_.known_[HttpRequestView::kContentLength] >= 0;
+  if (request_.known_[HttpRequestView::kTransferEncoding] >= 0)
+  {
+    // both are a way of request smuggling, RFC 7230 3.3.3
+    if (hasContentLength || !detail::isChunked(transferEncoding))
+    {
+      return fail(HttpResponse::k400BadRequest);
+    }
+    request_.chunkedBody_ = &chunkedBody_;
+    state_ = kExpectChunkSize;
+  }
+  else if (hasContentLength)
+  {
+    HttpResponse::HttpStatusCode error =
+        detail::parseContentLength(contentLength, maxBodyBytes_, &bodyRemaining_);
+    if (error != HttpResponse::kUnknown)
+    {
+      return fail(error);
+    }
+    state_ = bodyRemaining_ > 0 ? kExpectBody : kGotAll;
+  }
+  else
+  {
+    state_ = kGotAll;
+  }
+
+  StringPiece expect = request_.getHeader(HttpRequestView::kExpect);
+  expectContinue_ = state_ != kGotAll && expect.size() == 12
+      && strncasecmp(expect.data(), "100-continue", 12) == 0;
+  return true;
+}
+
+bool HttpParser::processChunkSize(const char* begin, const char* end)
+{
+  size_t size = 0;
+  HttpResponse::HttpStatusCode error = detail::parseChunkSize(begin, end, &size);
+  if (error != HttpResponse::kUnknown)
+  {
+    return fail(error);
+  }
+  if (chunkedBody_.size() + size > maxBodyBytes_)
+  {
+    return fail(HttpResponse::k413PayloadTooLarge);
+  }
+  bodyRemaining_ = size;
+  state_ = size > 0 ? kExpectChunkData : kExpectChunkTrailer;
+  return true;
+}
+
+// return false if any error
+bool HttpParser::parse(const Buffer* buf, Timestamp receiveTime)
+{
+  // Buffer may have moved its data since last call
+  const char* base = buf->peek();
+  const char* end = base + buf->readableBytes();
+  const size_t readable = buf->readableBytes();
+  request_.base_ = base;
+  if (request_.chunkedBody_)
+  {
+    request_.chunkedBody_ = &chunkedBody_;
+  }
+
+  bool ok = true;
+  bool hasMore = true;
+  while (ok && hasMore)
+  {
+    hasMore = false;
+    const char* begin = base + pos_;
+    if (state_ == kExpectHead)
+    {
+      // lines are parsed as they arrive, headers are offsets into buf
+      const char* crlf = findCRLF(begin, end);
+      size_t headBytes = crlf ? crlf + 2 - base : readable;
+      ok = headBytes <= maxHeaderBytes_ || fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+      if (ok && crlf)
+      {
+        ok = processHeadLine(begin, crlf, receiveTime);
+        pos_ = headBytes;
+        hasMore = true;
+      }
+    }
+    else if (state_ == kExpectBody)
+    {
+      if (readable - pos_ >= bodyRemaining_)
+      {
+        request_.body_.offset = static_cast<uint32_t>(pos_);
+        request_.body_.length = static_cast<uint32_t>(bodyRemaining_);
+        pos_ += bodyRemaining_;
+        bodyRemaining_ = 0;
+        state_ = kGotAll;
+      }
+    }
+    else if (state_ == kExpectChunkSize)
+    {
+      const char* crlf = findCRLF(begin, end);
+      if (crlf == NULL)
+      {
+        ok = readable - pos_ <= detail::kMaxChunkSizeLine
+            || fail(HttpResponse::k400BadRequest);
+      }
+      else
+      {
+        ok = processChunkSize(begin, crlf);
+        pos_ = crlf + 2 - base;
+        hasMore = true;
+      }
+    }
+    else if (state_ == kExpectChunkData)
+    {
+      // whole chunk with its CRLF
+      if (readable - pos_ >= bodyRemaining_ + 2)
+      {
+        const char* crlf = begin + bodyRemaining_;
+        ok = (crlf[0] == '\r' && crlf[1] == '\n') || fail(HttpResponse::k400BadRequest);
+        chunkedBody_.append(begin, bodyRemaining_);
+        pos_ += bodyRemaining_ + 2;
+        bodyRemaining_ = 0;
+        state_ = kExpectChunkSize;
+        hasMore = true;
+      }
+    }
+    else if (state_ == kExpectChunkTrailer)
+    {
+      const char* crlf = findCRLF(begin, end);
+      size_t lineBytes = crlf ? crlf + 2 - begin : end - begin;
+      ok = trailerBytes_ + lineBytes <= maxHeaderBytes_
+          || fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+      if (ok && crlf == begin)
+      {
+        pos_ += 2;
+        state_ = kGotAll;
+      }
+      else if (ok && crlf)
+      {
+        // trailers are discarded, so they can't override headers, RFC 7230 4.1.2
+        const char* colon = std::find(begin, crlf, ':');
+        ok = (colon != crlf && detail::isValidFieldName(begin, colon))
+            || fail(HttpResponse::k400BadRequest);
+        trailerBytes_ += lineBytes;
+        pos_ += lineBytes;
+        hasMore = true;
+      }
+    }
+  }
+  return ok;
+}
@@ -0,0 +1,114 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_HTTP_HTTPPARSER_H
+#define MUDUO_NET_HTTP_HTTPPARSER_H
+
+#include "muduo/net/http/HttpContext.h"
+#include "muduo/net/http/HttpRequestView.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+///
+/// Parses requests in place, same framing and limits as HttpContext,
+/// but into an HttpRequestView of offsets into the Buffer, without
+/// copying or allocating.  The Buffer is never retrieved by parse(),
+/// the caller retrieves consumed() bytes once done with request().
+///
+class HttpParser : public muduo::copyable
+{
+ public:
+  HttpParser()
+    : maxHeaderBytes_(HttpContext::kDefaultMaxHeaderBytes),
+      maxBodyBytes_(HttpContext::kDefaultMaxBodyBytes)
+  {
+    reset();
+  }
+
+  // default copy-ctor, dtor and assignment are fine
+
+  void setLimits(size_t maxHeaderBytes, size_t maxBodyBytes)
+  {
+    maxHeaderBytes_ = maxHeaderBytes;
+    maxBodyBytes_ = maxBodyBytes;
+  }
+
+  // return false if any error
+  bool parse(const Buffer* buf, Timestamp receiveTime);
+
+  bool gotAll() const
+  { return state_ == kGotAll; }
+
+  /// Bytes of the request at the beginning of Buffer, after gotAll().
+  size_t consumed() const
+  { return pos_; }
+
+  HttpResponse::HttpStatusCode error() const
+  { return error_; }
+
+  bool takeExpectContinue()
+  {
+    bool expect = expectContinue_;
+    expectContinue_ = false;
+    return expect;
+  }
+
+  /// Keeps capacity for the next request.
+  void reset()
+  {
+    state_ = kExpectHead;
+    pos_ = 0;
+    trailerBytes_ = 0;
+    bodyRemaining_ = 0;
+    expectContinue_ = false;
+    error_ = HttpResponse::kUnknown;
+    chunkedBody_.clear();
+    request_.clear();
+  }
+
+  const HttpRequestView& request() const
+  { return request_; }
+
+ private:
+  enum ParseState
+  {
+    kExpectHead,  // request line and headers
+    kExpectBody,
+    kExpectChunkSize,
+    kExpectChunkData,
+    kExpectChunkTrailer,
+    kGotAll,
+  };
+
+  bool processHeadLine(const char* begin, const char* end, Timestamp receiveTime);
+  bool parseRequestLine(const char* begin, const char* end);
+  bool addHeader(const char* begin, const char* colon, const char* end);
+  bool processHeadersEnd();
+  bool processChunkSize(const char* begin, const char* end);
+  bool fail(HttpResponse::HttpStatusCode error);
+
+  ParseState state_;
+  size_t maxHeaderBytes_;
+  size_t maxBodyBytes_;
+  size_t pos_;      // offset of next byte to parse
+  size_t trailerBytes_;
+  size_t bodyRemaining_;
+  bool expectContinue_;
+  HttpResponse::HttpStatusCode error_;
+  string chunkedBody_;
+  HttpRequestView request_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_HTTP_HTTPPARSER_H
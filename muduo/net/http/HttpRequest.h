@@ -162,6 +162,15 @@ class HttpRequest : public muduo::copyable
   const std::map<string, string>& headers() const
   { return headers_; }
 
+  void appendBody(const char* data, size_t len)
+  { body_.append(data, len); }
+
+  void reserveBody(size_t len)
+  { body_.reserve(len); }
+
+  const string& body() const
+  { return body_; }
+
   void swap(HttpRequest& that)
   {
     std::swap(method_, that.method_);
@@ -170,6 +179,7 @@ class HttpRequest : public muduo::copyable
     query_.swap(that.query_);
     receiveTime_.swap(that.receiveTime_);
     headers_.swap(that.headers_);
+    body_.swap(that.body_);
   }
 
  private:
@@ -179,6 +189,7 @@ class HttpRequest : public muduo::copyable
   string query_;
   Timestamp receiveTime_;
   std::map<string, string> headers_;
+  string body_;
 };
 
 }  // namespace net
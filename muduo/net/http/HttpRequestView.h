@@ -0,0 +1,174 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_HTTP_HTTPREQUESTVIEW_H
+#define MUDUO_NET_HTTP_HTTPREQUESTVIEW_H
+
+#include "muduo/base/StringPiece.h"
+#include "muduo/net/http/HttpRequest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <stdint.h>
+#include <strings.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// A parsed request, of StringPieces into the input Buffer of connection,
+/// valid until the Buffer is retrieved or appended.
+///
+/// Headers are kept in order of arrival in a flat vector, whose capacity is
+/// reused by the next request, so parsing allocates nothing in steady state.
+/// Common headers are classified when parsed, and looked up by KnownHeader
+/// without string compare.
+///
+class HttpRequestView : public muduo::copyable
+{
+ public:
+  typedef HttpRequest::Method Method;
+  typedef HttpRequest::Version Version;
+
+  enum KnownHeader
+  {
+    kHost,
+    kConnection,
+    kContentLength,
+    kContentType,
+    kTransferEncoding,
+    kExpect,
+    kAcceptEncoding,
+    kUserAgent,
+    kCookie,
+    kAuthorization,
+    kNumKnownHeaders,
+    kOtherHeader = kNumKnownHeaders,
+  };
+
+  HttpRequestView()
+    : base_(NULL)
+  {
+    headers_.reserve(16);
+    clear();
+  }
+
+  // default copy-ctor, dtor and assignment are fine
+
+  Method method() const { return method_; }
+  Version getVersion() const { return version_; }
+  StringPiece path() const { return piece(path_); }
+  /// Including the leading '?', as HttpRequest::query().
+  StringPiece query() const { return piece(query_); }
+  Timestamp receiveTime() const { return receiveTime_; }
+
+  /// Body of Content-Length, or chunks joined.
+  StringPiece body() const
+  {
+    return chunkedBody_ ? StringPiece(chunkedBody_->data(), static_cast<int>(chunkedBody_->size()))
+                        : piece(body_);
+  }
+
+  size_t headerCount() const { return headers_.size(); }
+  StringPiece headerField(size_t i) const { return piece(headers_[i].field); }
+  StringPiece headerValue(size_t i) const { return piece(headers_[i].value); }
+  KnownHeader headerKind(size_t i) const { return headers_[i].kind; }
+
+  /// Value of the first such header, empty if none.
+  StringPiece getHeader(KnownHeader header) const
+  {
+    return known_[header] >= 0 ? headerValue(known_[header]) : StringPiece();
+  }
+
+  /// Case-insensitive, empty if none.
+  StringPiece getHeader(StringPiece field) const
+  {
+    for (const Header& header : headers_)
+    {
+      if (static_cast<int>(header.field.length) == field.size()
+          && strncasecmp(base_ + header.field.offset, field.data(), field.size()) == 0)
+      {
+        return piece(header.value);
+      }
+    }
+    return StringPiece();
+  }
+
+  /// Owning copy, for callbacks written for HttpRequest.
+  void copyTo(HttpRequest* request) const
+  {
+    // request line starts at base_
+    request->setMethod(base_, std::find(base_, base_ + path_.offset, ' '));
+    request->setVersion(version_);
+    request->setPath(begin(path_), end(path_));
+    request->setQuery(begin(query_), end(query_));
+    request->setReceiveTime(receiveTime_);
+    for (const Header& header : headers_)
+    {
+      // field is followed by colon in Buffer
+      request->addHeader(begin(header.field), end(header.field), end(header.value));
+    }
+    StringPiece content = body();
+    request->appendBody(content.data(), static_cast<size_t>(content.size()));
+  }
+
+ private:
+  friend class HttpParser;
+
+  // offset into input Buffer, which may move as more data arrives
+  struct Span
+  {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  struct Header
+  {
+    Span field;
+    Span value;
+    KnownHeader kind;
+  };
+
+  const char* begin(Span span) const { return base_ + span.offset; }
+  const char* end(Span span) const { return base_ + span.offset + span.length; }
+
+  StringPiece piece(Span span) const
+  { return StringPiece(begin(span), static_cast<int>(span.length)); }
+
+  // keeps capacity of headers_
+  void clear()
+  {
+    method_ = HttpRequest::kInvalid;
+    version_ = HttpRequest::kUnknown;
+    path_ = query_ = body_ = Span();
+    headers_.clear();
+    for (int i = 0; i < kNumKnownHeaders; ++i)
+    {
+      known_[i] = -1;
+    }
+    chunkedBody_ = NULL;
+  }
+
+  const char* base_;
+  Method method_;
+  Version version_;
+  Span path_;
+  Span query_;
+  Span body_;
+  Timestamp receiveTime_;
+  std::vector<Header> headers_;
+  int16_t known_[kNumKnownHeaders];  // index into headers_, -1 if none
+  const string* chunkedBody_;        // owned by HttpParser, or NULL
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_HTTP_HTTPREQUESTVIEW_H
@@ -32,6 +32,8 @@ class HttpResponse : public muduo::copyable
     k301MovedPermanently = 301,
     k400BadRequest = 400,
     k404NotFound = 404,
+    k413PayloadTooLarge = 413,
+    k431RequestHeaderFieldsTooLarge = 431,
   };
 
   explicit HttpResponse(bool close)
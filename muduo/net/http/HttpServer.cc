@@ -11,7 +11,9 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/net/http/HttpContext.h"
+#include "muduo/net/http/HttpParser.h"
 #include "muduo/net/http/HttpRequest.h"
+#include "muduo/net/http/HttpRequestView.h"
 #include "muduo/net/http/HttpResponse.h"
 
 using namespace muduo;
@@ -24,6 +26,36 @@ namespace net
 namespace detail
 {
 
+const char* statusMessage(HttpResponse::HttpStatusCode code)
+{
+  switch (code)
+  {
+    case HttpResponse::k413PayloadTooLarge:
+      return "Payload Too Large";
+    case HttpResponse::k431RequestHeaderFieldsTooLarge:
+      return "Request Header Fields Too Large";
+    default:
+      return "Bad Request";
+  }
+}
+
+void replyError(const TcpConnectionPtr& conn, HttpResponse::HttpStatusCode code)
+{
+  HttpResponse response(true);
+  response.setStatusCode(code);
+  response.setStatusMessage(statusMessage(code));
+  Buffer reply;
+  response.appendToBuffer(&reply);
+  conn->send(&reply);
+  conn->shutdown();
+}
+
+bool closeConnection(HttpRequest::Version version, StringPiece connection)
+{
+  return connection == "close" ||
+    (version == HttpRequest::kHttp10 && connection != "Keep-Alive");
+}
+
 void defaultHttpCallback(const HttpRequest&, HttpResponse* resp)
 {
   resp->setStatusCode(HttpResponse::k404NotFound);
@@ -40,7 +72,9 @@ HttpServer::HttpServer(EventLoop* loop,
                        const string& name,
                        TcpServer::Option option)
   : server_(loop, listenAddr, name, option),
-    httpCallback_(detail::defaultHttpCallback)
+    httpCallback_(detail::defaultHttpCallback),
+    maxHeaderBytes_(HttpContext::kDefaultMaxHeaderBytes),
+    maxBodyBytes_(HttpContext::kDefaultMaxBodyBytes)
 {
   server_.setConnectionCallback(
       std::bind(&HttpServer::onConnection, this, _1));
@@ -57,9 +91,17 @@ void HttpServer::start()
 
 void HttpServer::onConnection(const TcpConnectionPtr& conn)
 {
-  if (conn->connected())
+  if (conn->connected() && httpViewCallback_)
+  {
+    HttpParser parser;
+    parser.setLimits(maxHeaderBytes_, maxBodyBytes_);
+    conn->setContext(parser);
+  }
+  else if (conn->connected())
   {
-    conn->setContext(HttpContext());
+    HttpContext context;
+    context.setLimits(maxHeaderBytes_, maxBodyBytes_);
+    conn->setContext(context);
   }
 }
 
@@ -67,28 +109,96 @@ void HttpServer::onMessage(const TcpConnectionPtr& conn,
                            Buffer* buf,
                            Timestamp receiveTime)
 {
-  HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
-
-  if (!context->parseRequest(buf, receiveTime))
+  if (httpViewCallback_)
   {
-    conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-    conn->shutdown();
+    onMessageView(conn, buf, receiveTime);
+    return;
   }
+  HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
 
-  if (context->gotAll())
+  // pipelined requests, until the connection is being shutdown
+  while (conn->connected())
   {
+    if (!context->parseRequest(buf, receiveTime))
+    {
+      detail::replyError(conn, context->error());
+      buf->retrieveAll();
+      break;
+    }
+
+    if (context->takeExpectContinue())
+    {
+      conn->send("HTTP/1.1 100 Continue\r\n\r\n");
+    }
+
+    if (!context->gotAll())
+    {
+      break;
+    }
     onRequest(conn, context->request());
     context->reset();
+    if (buf->readableBytes() == 0)
+    {
+      break;
+    }
+  }
+}
+
+void HttpServer::onMessageView(const TcpConnectionPtr& conn,
+                               Buffer* buf,
+                               Timestamp receiveTime)
+{
+  HttpParser* parser = boost::any_cast<HttpParser>(conn->getMutableContext());
+
+  while (conn->connected())
+  {
+    if (!parser->parse(buf, receiveTime))
+    {
+      detail::replyError(conn, parser->error());
+      buf->retrieveAll();
+      break;
+    }
+
+    if (parser->takeExpectContinue())
+    {
+      conn->send("HTTP/1.1 100 Continue\r\n\r\n");
+    }
+
+    if (!parser->gotAll())
+    {
+      break;
+    }
+    // the view points into buf, retrieved after the callback
+    onRequestView(conn, parser->request());
+    buf->retrieve(parser->consumed());
+    parser->reset();
+    if (buf->readableBytes() == 0)
+    {
+      break;
+    }
   }
 }
 
 void HttpServer::onRequest(const TcpConnectionPtr& conn, const HttpRequest& req)
 {
-  const string& connection = req.getHeader("Connection");
-  bool close = connection == "close" ||
-    (req.getVersion() == HttpRequest::kHttp10 && connection != "Keep-Alive");
-  HttpResponse response(close);
+  const std::map<string, string>& headers = req.headers();
+  std::map<string, string>::const_iterator it = headers.find("Connection");
+  StringPiece connection = it != headers.end() ? StringPiece(it->second) : StringPiece();
+  HttpResponse response(detail::closeConnection(req.getVersion(), connection));
   httpCallback_(req, &response);
+  sendResponse(conn, response);
+}
+
+void HttpServer::onRequestView(const TcpConnectionPtr& conn, const HttpRequestView& req)
+{
+  StringPiece connection = req.getHeader(HttpRequestView::kConnection);
+  HttpResponse response(detail::closeConnection(req.getVersion(), connection));
+  httpViewCallback_(req, &response);
+  sendResponse(conn, response);
+}
+
+void HttpServer::sendResponse(const TcpConnectionPtr& conn, const HttpResponse& response)
+{
   Buffer buf;
   response.appendToBuffer(&buf);
   conn->send(&buf);
@@ -97,4 +207,3 @@ void HttpServer::onRequest(const TcpConnectionPtr& conn, const HttpRequest& req)
     conn->shutdown();
   }
 }
-
@@ -19,6 +19,7 @@ namespace net
 {
 
 class HttpRequest;
+class HttpRequestView;
 class HttpResponse;
 
 /// A simple embeddable HTTP server designed for report status of a program.
@@ -30,6 +31,8 @@ class HttpServer : noncopyable
  public:
   typedef std::function<void (const HttpRequest&,
                               HttpResponse*)> HttpCallback;
+  typedef std::function<void (const HttpRequestView&,
+                              HttpResponse*)> HttpViewCallback;
 
   HttpServer(EventLoop* loop,
              const InetAddress& listenAddr,
@@ -44,6 +47,21 @@ class HttpServer : noncopyable
     httpCallback_ = cb;
   }
 
+  /// Not thread safe, parses requests in place into views of the input
+  /// buffer instead, without copying, overrides setHttpCallback().
+  void setHttpViewCallback(const HttpViewCallback& cb)
+  {
+    httpViewCallback_ = cb;
+  }
+
+  /// Not thread safe, limits of request line with headers and of bodies,
+  /// see HttpContext::setLimits().
+  void setLimits(size_t maxHeaderBytes, size_t maxBodyBytes)
+  {
+    maxHeaderBytes_ = maxHeaderBytes;
+    maxBodyBytes_ = maxBodyBytes;
+  }
+
   void setThreadNum(int numThreads)
   {
     server_.setThreadNum(numThreads);
@@ -56,10 +74,18 @@ class HttpServer : noncopyable
   void onMessage(const TcpConnectionPtr& conn,
                  Buffer* buf,
                  Timestamp receiveTime);
+  void onMessageView(const TcpConnectionPtr& conn,
+                     Buffer* buf,
+                     Timestamp receiveTime);
   void onRequest(const TcpConnectionPtr&, const HttpRequest&);
+  void onRequestView(const TcpConnectionPtr&, const HttpRequestView&);
+  void sendResponse(const TcpConnectionPtr&, const HttpResponse&);
 
   TcpServer server_;
   HttpCallback httpCallback_;
+  HttpViewCallback httpViewCallback_;
+  size_t maxHeaderBytes_;
+  size_t maxBodyBytes_;
 };
 
 }  // namespace net
@@ -0,0 +1,211 @@
+#include "muduo/net/http/HttpParser.h"
+#include "muduo/net/Buffer.h"
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Timestamp;
+using muduo::net::Buffer;
+using muduo::net::HttpParser;
+using muduo::net::HttpRequest;
+using muduo::net::HttpRequestView;
+using muduo::net::HttpResponse;
+
+BOOST_AUTO_TEST_CASE(testParseAllInOne)
+{
+  HttpParser parser;
+  Buffer input;
+  input.append("GET /index.html?a=1 HTTP/1.1\r\n"
+       "host: www.chenshuo.com\r\n"
+       "X-Request-Id:  42 \r\n"
+       "\r\n");
+
+  BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK(parser.gotAll());
+  BOOST_CHECK_EQUAL(parser.consumed(), input.readableBytes());
+  const HttpRequestView& request = parser.request();
+  BOOST_CHECK_EQUAL(request.method(), HttpRequest::kGet);
+  BOOST_CHECK_EQUAL(request.path().as_string(), string("/index.html"));
+  BOOST_CHECK_EQUAL(request.query().as_string(), string("?a=1"));
+  BOOST_CHECK_EQUAL(request.getVersion(), HttpRequest::kHttp11);
+  BOOST_CHECK_EQUAL(request.getHeader(HttpRequestView::kHost).as_string(), string("www.chenshuo.com"));
+  BOOST_CHECK_EQUAL(request.getHeader("HOST").as_string(), string("www.chenshuo.com"));
+  BOOST_CHECK_EQUAL(request.getHeader("x-request-id").as_string(), string("42"));
+  BOOST_CHECK_EQUAL(request.getHeader(HttpRequestView::kUserAgent).as_string(), string(""));
+  BOOST_CHECK_EQUAL(request.headerCount(), 2);
+  BOOST_CHECK_EQUAL(request.headerKind(1), HttpRequestView::kOtherHeader);
+
+  HttpRequest copy;
+  request.copyTo(&copy);
+  BOOST_CHECK_EQUAL(copy.method(), HttpRequest::kGet);
+  BOOST_CHECK_EQUAL(copy.path(), string("/index.html"));
+  BOOST_CHECK_EQUAL(copy.query(), string("?a=1"));
+  BOOST_CHECK_EQUAL(copy.getHeader("X-Request-Id"), string("42"));
+}
+
+BOOST_AUTO_TEST_CASE(testParseInTwoPieces)
+{
+  string all("POST /echo HTTP/1.1\r\n"
+       "Host: www.chenshuo.com\r\n"
+       "Content-Length: 11\r\n"
+       "\r\n"
+       "hello world");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpParser parser;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+    BOOST_CHECK(!parser.gotAll());
+
+    // may move the data of Buffer
+    input.ensureWritableBytes(4096);
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+    BOOST_CHECK(parser.gotAll());
+    const HttpRequestView& request = parser.request();
+    BOOST_CHECK_EQUAL(request.method(), HttpRequest::kPost);
+    BOOST_CHECK_EQUAL(request.getHeader(HttpRequestView::kHost).as_string(), string("www.chenshuo.com"));
+    BOOST_CHECK_EQUAL(request.body().as_string(), string("hello world"));
+    BOOST_CHECK_EQUAL(parser.consumed(), all.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseChunked)
+{
+  string all("POST /upload HTTP/1.1\r\n"
+       "Transfer-Encoding: chunked\r\n"
+       "\r\n"
+       "5;name=value\r\n"
+       "hello\r\n"
+       "6\r\n"
+       " world\r\n"
+       "0\r\n"
+       "Checksum: 42\r\n"
+       "\r\n");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpParser parser;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+    BOOST_CHECK(!parser.gotAll());
+
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+    BOOST_CHECK(parser.gotAll());
+    BOOST_CHECK_EQUAL(parser.request().body().as_string(), string("hello world"));
+    // trailers are discarded
+    BOOST_CHECK_EQUAL(parser.request().getHeader("Checksum").as_string(), string(""));
+    BOOST_CHECK_EQUAL(parser.consumed(), all.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParsePipelined)
+{
+  HttpParser parser;
+  Buffer input;
+  input.append("POST /a HTTP/1.1\r\n"
+       "Content-Length: 3\r\n"
+       "\r\n"
+       "abc"
+       "GET /b HTTP/1.0\r\n"
+       "Connection: Keep-Alive\r\n"
+       "\r\n");
+
+  BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK(parser.gotAll());
+  BOOST_CHECK_EQUAL(parser.request().path().as_string(), string("/a"));
+  BOOST_CHECK_EQUAL(parser.request().body().as_string(), string("abc"));
+  input.retrieve(parser.consumed());
+  parser.reset();
+
+  BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK(parser.gotAll());
+  BOOST_CHECK_EQUAL(parser.request().path().as_string(), string("/b"));
+  BOOST_CHECK_EQUAL(parser.request().getVersion(), HttpRequest::kHttp10);
+  BOOST_CHECK_EQUAL(parser.request().getHeader(HttpRequestView::kConnection).as_string(),
+                    string("Keep-Alive"));
+  BOOST_CHECK_EQUAL(parser.request().getHeader(HttpRequestView::kContentLength).as_string(),
+                    string(""));
+  BOOST_CHECK_EQUAL(parser.request().body().as_string(), string(""));
+  BOOST_CHECK_EQUAL(parser.consumed(), input.readableBytes());
+}
+
+BOOST_AUTO_TEST_CASE(testParseErrors)
+{
+  const char* requests[] = {
+    "FETCH / HTTP/1.1\r\n\r\n",
+    "GET / HTTP/2.0\r\n\r\n",
+    "GET / HTTP/1.1\r\nno colon\r\n\r\n",
+    "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 1\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n",
+    "POST / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 3\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 0\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\ntransfer-encoding: chunked\r\n\r\n",
+    "GET\r\n\r\n",
+    // whitespace before colon, RFC 7230 3.2.4
+    "POST / HTTP/1.1\r\nContent-Length : 3\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nTransfer-Encoding\t: chunked\r\n\r\n",
+    "GET / HTTP/1.1\r\n: empty\r\n\r\n",
+    // obs-fold
+    "GET / HTTP/1.1\r\nX-Folded: a\r\n b\r\n\r\n",
+    "GET / HTTP/1.1\r\nX-Folded: a\r\n\tb: c\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\nBad Trailer: 1\r\n\r\n",
+  };
+
+  for (const char* req : requests)
+  {
+    HttpParser parser;
+    Buffer input;
+    input.append(req);
+    BOOST_CHECK(!parser.parse(&input, Timestamp::now()));
+    BOOST_CHECK_EQUAL(parser.error(), HttpResponse::k400BadRequest);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseLimits)
+{
+  HttpParser parser;
+  parser.setLimits(64, 8);
+  Buffer input;
+  input.append("POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n");
+  BOOST_CHECK(!parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(parser.error(), HttpResponse::k413PayloadTooLarge);
+
+  parser.reset();
+  input.retrieveAll();
+  input.append("GET / HTTP/1.1\r\nCookie: ");
+  input.append(string(64, 'x'));
+  BOOST_CHECK(!parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(parser.error(), HttpResponse::k431RequestHeaderFieldsTooLarge);
+}
+
+BOOST_AUTO_TEST_CASE(testParseTrailerInjection)
+{
+  HttpParser parser;
+  Buffer input;
+  input.append("POST / HTTP/1.1\r\n"
+       "Host: a.example.com\r\n"
+       "Transfer-Encoding: chunked\r\n"
+       "\r\n"
+       "0\r\n"
+       "Host: b.example.com\r\n"
+       "Content-Length: 3\r\n"
+       "\r\n");
+
+  BOOST_CHECK(parser.parse(&input, Timestamp::now()));
+  BOOST_CHECK(parser.gotAll());
+  BOOST_CHECK_EQUAL(parser.request().getHeader(HttpRequestView::kHost).as_string(),
+                    string("a.example.com"));
+  BOOST_CHECK_EQUAL(parser.request().getHeader(HttpRequestView::kContentLength).as_string(),
+                    string(""));
+  BOOST_CHECK_EQUAL(parser.request().headerCount(), 2);
+  BOOST_CHECK_EQUAL(parser.consumed(), input.readableBytes());
+}
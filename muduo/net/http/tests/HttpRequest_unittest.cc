@@ -11,6 +11,7 @@ using muduo::Timestamp;
 using muduo::net::Buffer;
 using muduo::net::HttpContext;
 using muduo::net::HttpRequest;
+using muduo::net::HttpResponse;
 
 BOOST_AUTO_TEST_CASE(testParseRequestAllInOne)
 {
@@ -77,3 +78,187 @@ BOOST_AUTO_TEST_CASE(testParseRequestEmptyHeaderValue)
   BOOST_CHECK_EQUAL(request.getHeader("User-Agent"), string(""));
   BOOST_CHECK_EQUAL(request.getHeader("Accept-Encoding"), string(""));
 }
+
+BOOST_AUTO_TEST_CASE(testParseRequestContentLength)
+{
+  string all("POST /echo HTTP/1.1\r\n"
+       "Host: www.chenshuo.com\r\n"
+       "content-length: 11\r\n"
+       "\r\n"
+       "hello world");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpContext context;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(!context.gotAll());
+
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(context.gotAll());
+    BOOST_CHECK_EQUAL(context.request().method(), HttpRequest::kPost);
+    BOOST_CHECK_EQUAL(context.request().body(), string("hello world"));
+    BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestChunked)
+{
+  string all("POST /upload HTTP/1.1\r\n"
+       "Transfer-Encoding: gzip, chunked\r\n"
+       "\r\n"
+       "5;name=value\r\n"
+       "hello\r\n"
+       "6\r\n"
+       " world\r\n"
+       "0\r\n"
+       "Checksum: 42\r\n"
+       "\r\n");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpContext context;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(!context.gotAll());
+
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(context.gotAll());
+    BOOST_CHECK_EQUAL(context.request().body(), string("hello world"));
+    // trailers are discarded
+    BOOST_CHECK_EQUAL(context.request().getHeader("Checksum"), string(""));
+    BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestPipelined)
+{
+  HttpContext context;
+  Buffer input;
+  input.append("POST /a HTTP/1.1\r\n"
+       "Content-Length: 3\r\n"
+       "\r\n"
+       "abc"
+       "GET /b HTTP/1.1\r\n"
+       "\r\n");
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().path(), string("/a"));
+  BOOST_CHECK_EQUAL(context.request().body(), string("abc"));
+  context.reset();
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().path(), string("/b"));
+  BOOST_CHECK_EQUAL(context.request().body(), string(""));
+  BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestExpectContinue)
+{
+  HttpContext context;
+  Buffer input;
+  input.append("PUT /file HTTP/1.1\r\n"
+       "Content-Length: 4\r\n"
+       "Expect: 100-continue\r\n"
+       "\r\n");
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(!context.gotAll());
+  BOOST_CHECK(context.takeExpectContinue());
+  BOOST_CHECK(!context.takeExpectContinue());
+
+  input.append("data");
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().body(), string("data"));
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestBadBody)
+{
+  const char* requests[] = {
+    "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+    "POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 1\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n",
+    "GET / HTTP/1.1\r\nno colon\r\n\r\n",
+    "POST / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 3\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 0\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\ntransfer-encoding: chunked\r\n\r\n",
+    // whitespace before colon, RFC 7230 3.2.4
+    "POST / HTTP/1.1\r\nContent-Length : 3\r\n\r\nabc",
+    "POST / HTTP/1.1\r\nTransfer-Encoding\t: chunked\r\n\r\n",
+    "GET / HTTP/1.1\r\n: empty\r\n\r\n",
+    // obs-fold
+    "GET / HTTP/1.1\r\nX-Folded: a\r\n b\r\n\r\n",
+    "GET / HTTP/1.1\r\nX-Folded: a\r\n\tb: c\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\nBad Trailer: 1\r\n\r\n",
+  };
+
+  for (const char* req : requests)
+  {
+    HttpContext context;
+    Buffer input;
+    input.append(req);
+    BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK_EQUAL(context.error(), HttpResponse::k400BadRequest);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestLimits)
+{
+  HttpContext context;
+  context.setLimits(64, 8);
+  Buffer input;
+  input.append("POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n");
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(context.error(), HttpResponse::k413PayloadTooLarge);
+
+  context.reset();
+  input.retrieveAll();
+  input.append("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+               "5\r\nhello\r\n5\r\n");
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(context.error(), HttpResponse::k413PayloadTooLarge);
+
+  // a header line never finished
+  context.reset();
+  input.retrieveAll();
+  input.append("GET / HTTP/1.1\r\nCookie: ");
+  input.append(string(64, 'x'));
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(context.error(), HttpResponse::k431RequestHeaderFieldsTooLarge);
+
+  context.reset();
+  input.retrieveAll();
+  input.append("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\nE: 5\r\nF: 6\r\nG: 7\r\nH: 8\r\nI: 9\r\n\r\n");
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK_EQUAL(context.error(), HttpResponse::k431RequestHeaderFieldsTooLarge);
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestTrailerInjection)
+{
+  HttpContext context;
+  Buffer input;
+  input.append("POST / HTTP/1.1\r\n"
+       "Host: a.example.com\r\n"
+       "Transfer-Encoding: chunked\r\n"
+       "\r\n"
+       "0\r\n"
+       "Host: b.example.com\r\n"
+       "Content-Length: 3\r\n"
+       "\r\n");
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().getHeader("Host"), string("a.example.com"));
+  BOOST_CHECK_EQUAL(context.request().getHeader("Content-Length"), string(""));
+  BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+}
@@ -9,6 +9,7 @@
 
 #include "muduo/net/inspect/ProcessInspector.h"
 #include "muduo/base/FileUtil.h"
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/ProcessInfo.h"
 #include <limits.h>
 #include <stdio.h>
@@ -128,6 +129,8 @@ void ProcessInspector::registerCommands(Inspector* ins)
   ins->add("proc", "status", ProcessInspector::procStatus, "print /proc/self/status");
   // ins->add("proc", "opened_files", ProcessInspector::openedFiles, "count /proc/self/fd");
   ins->add("proc", "threads", ProcessInspector::threads, "list /proc/self/task");
+  ins->add("proc", "flightrec", ProcessInspector::flightRecorder,
+           "print flight recorder, /proc/flightrec/dump to dump it to file");
 }
 
 string ProcessInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
@@ -237,3 +240,15 @@ string ProcessInspector::threads(HttpRequest::Method, const Inspector::ArgList&)
   return result;
 }
 
+string ProcessInspector::flightRecorder(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  if (!FlightRecorder::started())
+  {
+    return "FlightRecorder not started\n";
+  }
+  if (!args.empty() && args[0] == "dump")
+  {
+    return FlightRecorder::dump() ? "dumped\n" : "dump failed\n";
+  }
+  return FlightRecorder::snapshot();
+}
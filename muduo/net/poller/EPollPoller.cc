@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <poll.h>
 #include <sys/epoll.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -39,7 +40,12 @@ const int kDeleted = 2;
 EPollPoller::EPollPoller(EventLoop* loop)
   : Poller(loop),
     epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
-    events_(kInitEventListSize)
+    events_(kInitEventListSize),
+#ifdef SYS_epoll_pwait2
+    hasEpollPwait2_(true)
+#else
+    hasEpollPwait2_(false)
+#endif
 {
   if (epollfd_ < 0)
   {
@@ -59,7 +65,39 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
                                &*events_.begin(),
                                static_cast<int>(events_.size()),
                                timeoutMs);
-  int savedErrno = errno;
+  return handleEvents(numEvents, errno, activeChannels);
+}
+
+Timestamp EPollPoller::pollUsec(int64_t timeoutUsec, ChannelList* activeChannels)
+{
+#ifdef SYS_epoll_pwait2
+  if (hasEpollPwait2_ && timeoutUsec >= 0)
+  {
+    LOG_TRACE << "fd total count " << channels_.size();
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeoutUsec / Timestamp::kMicroSecondsPerSecond);
+    ts.tv_nsec = static_cast<long>(timeoutUsec % Timestamp::kMicroSecondsPerSecond * 1000);
+    // glibc has no wrapper before 2.35
+    int numEvents = static_cast<int>(::syscall(SYS_epoll_pwait2, epollfd_,
+                                               &*events_.begin(),
+                                               static_cast<int>(events_.size()),
+                                               &ts, NULL, 0));
+    int savedErrno = errno;
+    if (numEvents >= 0 || (savedErrno != ENOSYS && savedErrno != EPERM))
+    {
+      return handleEvents(numEvents, savedErrno, activeChannels);
+    }
+    // old kernel, or blocked by seccomp
+    LOG_WARN << "epoll_pwait2 unavailable, falls back to epoll_wait";
+    hasEpollPwait2_ = false;
+  }
+#endif
+  return Poller::pollUsec(timeoutUsec, activeChannels);
+}
+
+Timestamp EPollPoller::handleEvents(int numEvents, int savedErrno,
+                                    ChannelList* activeChannels)
+{
   Timestamp now(Timestamp::now());
   if (numEvents > 0)
   {
@@ -32,6 +32,8 @@ class EPollPoller : public Poller
   ~EPollPoller() override;
 
   Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+  /// Uses epoll_pwait2(2) if kernel supports it, Linux 5.11+.
+  Timestamp pollUsec(int64_t timeoutUsec, ChannelList* activeChannels) override;
   void updateChannel(Channel* channel) override;
   void removeChannel(Channel* channel) override;
 
@@ -40,6 +42,8 @@ class EPollPoller : public Poller
 
   static const char* operationToString(int op);
 
+  Timestamp handleEvents(int numEvents, int savedErrno,
+                         ChannelList* activeChannels);
   void fillActiveChannels(int numEvents,
                           ChannelList* activeChannels) const;
   void update(int operation, Channel* channel);
@@ -48,6 +52,7 @@ class EPollPoller : public Poller
 
   int epollfd_;
   EventList events_;
+  bool hasEpollPwait2_;
 };
 
 }  // namespace net
@@ -1,4 +1,5 @@
 #include "muduo/net/Buffer.h"
+#include "muduo/net/BufferSlice.h"
 
 //#define BOOST_TEST_MODULE BufferTest
 #define BOOST_TEST_MAIN
@@ -7,6 +8,7 @@
 
 using muduo::string;
 using muduo::net::Buffer;
+using muduo::net::BufferSlice;
 
 BOOST_AUTO_TEST_CASE(testBufferAppendRetrieve)
 {
@@ -168,3 +170,30 @@ BOOST_AUTO_TEST_CASE(testMove)
   // printf("Buffer at %p, inner %p\n", &buf, inner);
   output(std::move(buf), inner);
 }
+
+BOOST_AUTO_TEST_CASE(testBufferSlice)
+{
+  Buffer buf;
+  buf.append("hello muduo");
+  BufferSlice slice(&buf);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(slice.size(), 11);
+  BOOST_CHECK_EQUAL(slice.useCount(), 1);
+
+  BufferSlice muduo = slice.slice(6, 5);
+  BOOST_CHECK_EQUAL(muduo.toStringPiece().as_string(), "muduo");
+  BOOST_CHECK_EQUAL(slice.useCount(), 2);
+
+  BufferSlice copy(slice);
+  copy.retrieve(6);
+  BOOST_CHECK_EQUAL(copy.toStringPiece().as_string(), "muduo");
+  BOOST_CHECK_EQUAL(copy.data(), muduo.data());
+  BOOST_CHECK_EQUAL(slice.toStringPiece().as_string(), "hello muduo");
+  copy.retrieve(5);
+  BOOST_CHECK(copy.empty());
+  BOOST_CHECK_EQUAL(slice.useCount(), 3);
+
+  BufferSlice empty;
+  BOOST_CHECK(empty.empty());
+  BOOST_CHECK_EQUAL(empty.useCount(), 0);
+}
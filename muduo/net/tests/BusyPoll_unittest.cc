@@ -0,0 +1,69 @@
+#include "muduo/net/EventLoop.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/net/EventLoopThread.h"
+
+#include <unistd.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void runInLoopAndWait(EventLoop* loop, const std::function<void()>& func)
+{
+  CountDownLatch latch(1);
+  loop->runInLoop([&] { func(); latch.countDown(); });
+  latch.wait();
+}
+
+// seconds for a functor queued from this thread to run
+double wakeupLatency(EventLoop* loop)
+{
+  Timestamp start(Timestamp::now());
+  runInLoopAndWait(loop, [] {});
+  return timeDifference(Timestamp::now(), start);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testBusyPollWakeup)
+{
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  runInLoopAndWait(loop, [loop] { loop->setBusyPoll(10*1000*1000); });
+  for (int i = 0; i < 100 && !loop->spinning(); ++i)
+  {
+    ::usleep(10*1000);
+  }
+  BOOST_CHECK(loop->spinning());
+  // no eventfd write while spinning
+  BOOST_CHECK_LT(wakeupLatency(loop), 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(testBusyPollDisabledWhileSpinning)
+{
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  runInLoopAndWait(loop, [loop] { loop->setBusyPoll(10*1000*1000); });
+  for (int i = 0; i < 100 && !loop->spinning(); ++i)
+  {
+    ::usleep(10*1000);
+  }
+  BOOST_CHECK(loop->spinning());
+
+  runInLoopAndWait(loop, [loop] { loop->setBusyPoll(0); });
+  for (int i = 0; i < 100 && loop->spinning(); ++i)
+  {
+    ::usleep(10*1000);
+  }
+  BOOST_CHECK(!loop->spinning());
+
+  // blocked in poll, must be woken up, not wait for the poll timeout
+  ::usleep(100*1000);
+  BOOST_CHECK_LT(wakeupLatency(loop), 1.0);
+}
@@ -1,8 +1,12 @@
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/base/ProcessInfo.h"
 #include "muduo/base/Thread.h"
 
+#include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -20,6 +24,30 @@ void init(EventLoop* p)
          getpid(), CurrentThread::tid(), p);
 }
 
+std::vector<Thread::CpuSet> g_cpuSets;
+
+// "pinned0" runs on g_cpuSets[0], and so on
+void pinnedInit(EventLoop* p)
+{
+  init(p);
+  const char* name = CurrentThread::name();
+  size_t index = static_cast<size_t>(name[strlen(name) - 1] - '0');
+  const Thread::CpuSet& cpus = g_cpuSets[index % g_cpuSets.size()];
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  bool matched = ::sched_getaffinity(0, sizeof mask, &mask) == 0
+      && static_cast<size_t>(CPU_COUNT(&mask)) == cpus.size();
+  for (int cpu : cpus)
+  {
+    matched = matched && CPU_ISSET(cpu, &mask);
+  }
+  printf("%s: %d CPUs, %s\n", name, CPU_COUNT(&mask), matched ? "pinned" : "NOT PINNED");
+  if (!matched)
+  {
+    abort();
+  }
+}
+
 int main()
 {
   print();
@@ -63,6 +91,20 @@ int main()
     assert(nextLoop == model.getNextLoop());
   }
 
+  {
+    printf("Three threads pinned to NUMA nodes:\n");
+    EventLoopThreadPool model(&loop, "pinned");
+    model.setThreadNum(3);
+    g_cpuSets = ProcessInfo::numaNodeCpus();
+    model.setCpuAffinity(g_cpuSets);
+    model.start(pinnedInit);
+    std::vector<EventLoop*> loops = model.getAllLoops();
+    assert(loops.size() == 3);
+    assert(loops[0] == model.getNextLoop());
+    assert(loops[1] == model.getNextLoop());
+    assert(loops[2] == model.getNextLoop());
+  }
+
   loop.loop();
 }
 
@@ -0,0 +1,119 @@
+#include "muduo/net/LoopMessenger.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Timestamp.h"
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const int kLoops = 4;
+const int64_t kMessagesPerPair = 100 * 1000;
+
+struct Message
+{
+  int64_t seq;
+};
+
+typedef LoopMessenger<Message> Messenger;
+
+EventLoop* g_loop;
+Messenger* g_messenger;
+AtomicInt64 g_received;
+AtomicInt64 g_outOfOrder;
+AtomicInt64 g_full;
+int64_t g_sent[kLoops][kLoops];
+int64_t g_expected[kLoops][kLoops];
+
+void onMessage(size_t from, size_t to, Message& msg)
+{
+  // messages of each pair arrive in order
+  if (msg.seq != g_expected[from][to]++)
+  {
+    g_outOfOrder.increment();
+  }
+  if (g_received.incrementAndGet() == kLoops * kLoops * kMessagesPerPair)
+  {
+    g_loop->queueInLoop(std::bind(&EventLoop::quit, g_loop));
+  }
+}
+
+void produce(size_t from)
+{
+  bool done = true;
+  for (size_t to = 0; to < kLoops; ++to)
+  {
+    // sends a batch, stops on backpressure
+    for (int i = 0; i < 1000 && g_sent[from][to] < kMessagesPerPair; ++i)
+    {
+      Message msg = { g_sent[from][to] };
+      if (!g_messenger->send(from, to, msg))
+      {
+        g_full.increment();
+        break;
+      }
+      ++g_sent[from][to];
+    }
+    done = done && g_sent[from][to] == kMessagesPerPair;
+  }
+  if (!done)
+  {
+    EventLoop* loop = EventLoop::getEventLoopOfCurrentThread();
+    loop->queueInLoop(std::bind(produce, from));
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testAllPairsInOrder)
+{
+  EventLoop loop;
+  g_loop = &loop;
+  // not for ever if a message is lost
+  loop.runAfter(60, std::bind(&EventLoop::quit, &loop));
+  Timestamp start = Timestamp::now();
+  {
+    // outlives loop threads
+    std::unique_ptr<Messenger> messenger;
+    EventLoopThreadPool pool(&loop, "messenger");
+    pool.setThreadNum(kLoops);
+    pool.start();
+
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    messenger.reset(new Messenger(loops, 1024, onMessage));
+    g_messenger = messenger.get();
+
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+      loops[i]->runInLoop(std::bind(produce, i));
+    }
+    loop.loop();
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  printf("%" PRId64 " messages in %.3f seconds, %.0f msgs/s, %" PRId64 " full\n",
+         g_received.get(), seconds, static_cast<double>(g_received.get()) / seconds,
+         g_full.get());
+
+  // loop threads are joined
+  BOOST_CHECK_EQUAL(g_received.get(), kLoops * kLoops * kMessagesPerPair);
+  BOOST_CHECK_EQUAL(g_outOfOrder.get(), 0);
+  for (int from = 0; from < kLoops; ++from)
+  {
+    for (int to = 0; to < kLoops; ++to)
+    {
+      BOOST_CHECK_EQUAL(g_sent[from][to], kMessagesPerPair);
+      BOOST_CHECK_EQUAL(g_expected[from][to], kMessagesPerPair);
+    }
+  }
+}
@@ -0,0 +1,504 @@
+#include "muduo/net/TcpServer.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void runInLoopAndWait(EventLoop* loop, const std::function<void()>& func)
+{
+  CountDownLatch latch(1);
+  loop->runInLoop([&] { func(); latch.countDown(); });
+  latch.wait();
+}
+
+// polls for up to 3 seconds
+bool waitFor(const std::function<bool()>& cond)
+{
+  for (int i = 0; i < 300 && !cond(); ++i)
+  {
+    ::usleep(10*1000);
+  }
+  return cond();
+}
+
+// blocking client socket
+int connectTo(uint16_t port)
+{
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  InetAddress addr(port, true);
+  int ret = ::connect(fd, addr.getSockAddr(), sizeof(struct sockaddr_in));
+  BOOST_REQUIRE_EQUAL(ret, 0);
+  return fd;
+}
+
+// true if the server closed fd within 3 seconds
+bool closedByPeer(int fd)
+{
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  char buf[1024];
+  while (::poll(&pfd, 1, 3000) == 1)
+  {
+    ssize_t n = ::read(fd, buf, sizeof buf);
+    if (n == 0 || (n < 0 && errno == ECONNRESET))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// reads exactly len bytes, unless timeout or EOF
+string readBytes(int fd, size_t len, int timeoutMs = 3000)
+{
+  string result;
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  char buf[65536];
+  while (result.size() < len && ::poll(&pfd, 1, timeoutMs) == 1)
+  {
+    ssize_t n = ::read(fd, buf, std::min(sizeof buf, len - result.size()));
+    if (n <= 0)
+    {
+      break;
+    }
+    result.append(buf, n);
+  }
+  return result;
+}
+
+string makePayload(size_t len, char seed)
+{
+  string payload(len, '\0');
+  for (size_t i = 0; i < len; ++i)
+  {
+    payload[i] = static_cast<char>(seed + i % 251);
+  }
+  return payload;
+}
+
+// counts connections of a TcpServer running in its own loop thread
+class ServerHarness : noncopyable
+{
+ public:
+  explicit ServerHarness(uint16_t port)
+    : loop_(thread_.startLoop()),
+      port_(port),
+      established_(0),
+      closed_(0)
+  {
+    runInLoopAndWait(loop_, [this] {
+      server_.reset(new TcpServer(loop_, InetAddress(port_, true), "TcpServerTest"));
+      server_->setConnectionCallback(
+          std::bind(&ServerHarness::onConnection, this, _1));
+    });
+  }
+
+  ~ServerHarness()
+  {
+    destroyServer();
+  }
+
+  TcpServer* server() { return get_pointer(server_); }
+  EventLoop* loop() { return loop_; }
+  int established() const { return established_.load(); }
+  // called in io loops, before start()
+  void setConnectionHook(const ConnectionCallback& cb) { hook_ = cb; }
+  int closed() const { return closed_.load(); }
+
+  // EventLoopThreadPool::start() must run in the base loop
+  void start()
+  {
+    runInLoopAndWait(loop_, [this] { server_->start(); });
+  }
+
+  // tasks posted to io loops before this have run
+  void syncIoLoops()
+  {
+    std::vector<EventLoop*> ioLoops;
+    runInLoopAndWait(loop_, [&] { ioLoops = server_->threadPool()->getAllLoops(); });
+    for (EventLoop* ioLoop : ioLoops)
+    {
+      runInLoopAndWait(ioLoop, [] {});
+    }
+  }
+
+  // ~TcpServer() must run in its loop
+  void destroyServer()
+  {
+    runInLoopAndWait(loop_, [this] { server_.reset(); });
+  }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      ++established_;
+    }
+    else
+    {
+      ++closed_;
+    }
+    if (hook_)
+    {
+      hook_(conn);
+    }
+  }
+
+  EventLoopThread thread_;
+  EventLoop* loop_;
+  const uint16_t port_;
+  std::unique_ptr<TcpServer> server_;
+  ConnectionCallback hook_;
+  std::atomic<int> established_;
+  std::atomic<int> closed_;
+};
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testMaxConnections)
+{
+  ServerHarness harness(29981);
+  harness.server()->setMaxConnections(2);
+  harness.start();
+
+  // the third completes the handshake in backlog, but is not accepted
+  int c1 = connectTo(29981);
+  int c2 = connectTo(29981);
+  int c3 = connectTo(29981);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 2; }));
+  ::usleep(200*1000);
+  BOOST_CHECK_EQUAL(harness.established(), 2);
+
+  // accepting resumes when one is gone
+  ::close(c1);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 3; }));
+  BOOST_CHECK_EQUAL(harness.closed(), 1);
+
+  ::close(c2);
+  ::close(c3);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 3; }));
+}
+
+BOOST_AUTO_TEST_CASE(testMaxConnectionsPerIp)
+{
+  ServerHarness harness(29982);
+  harness.server()->setMaxConnectionsPerIp(1);
+  harness.start();
+
+  int c1 = connectTo(29982);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 1; }));
+  // closed right after accept(2), never becomes a TcpConnection
+  int c2 = connectTo(29982);
+  BOOST_CHECK(closedByPeer(c2));
+  BOOST_CHECK_EQUAL(harness.established(), 1);
+  ::close(c2);
+
+  ::close(c1);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+  int c3 = connectTo(29982);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 2; }));
+  ::close(c3);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 2; }));
+}
+
+BOOST_AUTO_TEST_CASE(testZeroCopySend)
+{
+  const size_t kThreshold = 64*1024;
+  const BufferSlice big1(makePayload(kThreshold, 'a'));
+  const BufferSlice big2(makePayload(3*kThreshold, 'b'));
+  const string small("small message below threshold");
+  std::atomic<bool> zeroCopy(false);
+  TcpConnectionPtr server;
+
+  ServerHarness harness(29983);
+  harness.setConnectionHook([&](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      server = conn;
+      zeroCopy = conn->setZeroCopy(kThreshold);
+      conn->send(big1);
+      conn->send(BufferSlice(small));
+      conn->send(big2);
+    }
+  });
+  harness.start();
+
+  int client = connectTo(29983);
+  string expected = big1.toStringPiece().as_string() + small
+      + big2.toStringPiece().as_string();
+  string received = readBytes(client, expected.size());
+  BOOST_CHECK(received == expected);
+  if (!zeroCopy)
+  {
+    BOOST_TEST_MESSAGE("SO_ZEROCOPY is not supported, data was copied");
+  }
+  else
+  {
+    TcpConnection::ZeroCopyStats stats;
+    BOOST_CHECK(waitFor([&] {
+      runInLoopAndWait(harness.loop(), [&] { stats = server->zeroCopyStats(); });
+      return stats.completions == stats.sends;
+    }));
+    BOOST_CHECK_GE(stats.sends, 2);
+    BOOST_CHECK_GE(stats.copies, 1);
+    // loopback copies on delivery
+    BOOST_CHECK_LE(stats.kernelCopies, stats.completions);
+    // no reference held for the kernel after completions
+    BOOST_CHECK(waitFor([&] { return big1.useCount() == 1 && big2.useCount() == 1; }));
+  }
+  runInLoopAndWait(harness.loop(), [&] { server.reset(); });
+  ::close(client);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(testZeroCopyOutlivesConnection)
+{
+  const size_t kLen = 16*1024*1024;
+  const BufferSlice big(makePayload(kLen, 'z'));
+  std::atomic<bool> zeroCopy(false);
+
+  ServerHarness harness(29984);
+  harness.setConnectionHook([&](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      zeroCopy = conn->setZeroCopy(1);
+      conn->send(big);
+      // client is not reading, sends are pending
+      conn->forceClose();
+    }
+  });
+  harness.start();
+
+  int client = connectTo(29984);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+  if (!zeroCopy)
+  {
+    BOOST_TEST_MESSAGE("SO_ZEROCOPY is not supported, skipped");
+    ::close(client);
+    return;
+  }
+  // connection is gone, but the kernel still references the payload
+  ::usleep(100*1000);
+  BOOST_CHECK_GT(big.useCount(), 1);
+
+  // the socket is kept open until completions, so bytes sent are intact
+  string received = readBytes(client, kLen);
+  BOOST_CHECK_GT(received.size(), 0U);
+  BOOST_CHECK(received == big.toStringPiece().as_string().substr(0, received.size()));
+  BOOST_CHECK(waitFor([&] { return big.useCount() == 1; }));
+  ::close(client);
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyWithConnections)
+{
+  std::set<EventLoop*> ioLoops;
+  MutexLock mutex;
+  ServerHarness harness(29985);
+  harness.server()->setThreadNum(2);
+  harness.setConnectionHook([&](const TcpConnectionPtr& conn) {
+    MutexLockGuard lock(mutex);
+    ioLoops.insert(conn->getLoop());
+  });
+  harness.start();
+
+  int clients[3];
+  for (int& c : clients)
+  {
+    c = connectTo(29985);
+  }
+  BOOST_CHECK(waitFor([&] { return harness.established() == 3; }));
+  // broadcast queued in io loops, bound to the server being destroyed
+  harness.server()->broadcast(BufferSlice(string("bye\n")));
+  harness.destroyServer();
+
+  // destroyed in io loops, which are gone now
+  BOOST_CHECK_EQUAL(harness.closed(), 3);
+  BOOST_CHECK_EQUAL(ioLoops.size(), 2U);
+  for (int c : clients)
+  {
+    BOOST_CHECK(closedByPeer(c));
+    ::close(c);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyWhileIoLoopBusy)
+{
+  ServerHarness harness(29989);
+  harness.server()->setThreadNum(1);
+  harness.start();
+  int c = connectTo(29989);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 1; }));
+
+  // outlives the server, like a pool shared by servers
+  std::shared_ptr<EventLoopThreadPool> pool;
+  std::vector<EventLoop*> ioLoops;
+  runInLoopAndWait(harness.loop(), [&] {
+    pool = harness.server()->threadPool();
+    ioLoops = pool->getAllLoops();
+  });
+  CountDownLatch busy(1);
+  ioLoops[0]->runInLoop([&busy] { busy.wait(); });
+
+  // returns without waiting for the io loop
+  harness.destroyServer();
+  BOOST_CHECK_EQUAL(harness.closed(), 0);
+  busy.countDown();
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+  BOOST_CHECK(closedByPeer(c));
+  ::close(c);
+  pool.reset();
+}
+
+BOOST_AUTO_TEST_CASE(testBroadcastAndGroups)
+{
+  std::atomic<int> index(0);
+  std::weak_ptr<TcpConnection> first;
+  ServerHarness harness(29986);
+  harness.server()->setThreadNum(2);
+  harness.setConnectionHook([&](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      // clients connect one by one, #0 and #2 in group "a", #1 in "b"
+      int i = index++;
+      if (i == 0)
+      {
+        first = conn;
+      }
+      harness.server()->joinGroup(conn, i % 2 == 0 ? "a" : "b");
+    }
+  });
+  harness.start();
+
+  int clients[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    clients[i] = connectTo(29986);
+    BOOST_CHECK(waitFor([&] { return harness.established() == i + 1; }));
+  }
+  harness.syncIoLoops();
+
+  harness.server()->broadcast(BufferSlice(string("all\n")));
+  for (int c : clients)
+  {
+    BOOST_CHECK_EQUAL(readBytes(c, 4), string("all\n"));
+  }
+
+  harness.server()->multicast("a", BufferSlice(string("to a\n")));
+  harness.server()->multicast("b", BufferSlice(string("to b\n")));
+  BOOST_CHECK_EQUAL(readBytes(clients[0], 5), string("to a\n"));
+  BOOST_CHECK_EQUAL(readBytes(clients[1], 5), string("to b\n"));
+  BOOST_CHECK_EQUAL(readBytes(clients[2], 5), string("to a\n"));
+
+  harness.server()->leaveGroup(first.lock(), "a");
+  harness.syncIoLoops();
+  harness.server()->multicast("a", BufferSlice(string("a again\n")));
+  BOOST_CHECK_EQUAL(readBytes(clients[2], 8), string("a again\n"));
+  BOOST_CHECK_EQUAL(readBytes(clients[0], 1, 200), string());
+
+  // leaves all groups when disconnected, no reference is kept
+  ::close(clients[1]);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+  harness.server()->multicast("b", BufferSlice(string("nobody\n")));
+  harness.syncIoLoops();
+  ::close(clients[0]);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 2; }));
+  BOOST_CHECK(waitFor([&] { return first.expired(); }));
+  ::close(clients[2]);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 3; }));
+}
+
+BOOST_AUTO_TEST_CASE(testSlowConsumerSkipped)
+{
+  const size_t kMessage = 1024*1024;
+  const int kMessages = 32;
+  ServerHarness harness(29987);
+  harness.server()->setThreadNum(2);
+  harness.server()->setSlowConsumerPolicy(64*1024, TcpServer::kSkipSlowConsumer);
+  harness.start();
+
+  int client = connectTo(29987);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 1; }));
+  // not reading, backlog grows once socket buffers are full
+  for (int i = 0; i < kMessages; ++i)
+  {
+    harness.server()->broadcast(BufferSlice(makePayload(kMessage, static_cast<char>(i))));
+  }
+  harness.syncIoLoops();
+
+  string received = readBytes(client, kMessage * kMessages, 500);
+  BOOST_CHECK_GT(received.size(), 0U);
+  BOOST_CHECK_LT(received.size(), kMessage * kMessages);
+  // whole messages are skipped, in order
+  BOOST_CHECK_EQUAL(received.size() % kMessage, 0U);
+  for (size_t i = 0; i < received.size() / kMessage; ++i)
+  {
+    BOOST_CHECK(received.compare(i * kMessage, kMessage, makePayload(kMessage, static_cast<char>(i))) == 0);
+  }
+  BOOST_CHECK_EQUAL(harness.closed(), 0);
+  ::close(client);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(testSlowConsumerDisconnected)
+{
+  const size_t kMessage = 1024*1024;
+  const int kMessages = 32;
+  ServerHarness harness(29988);
+  harness.server()->setThreadNum(2);
+  harness.server()->setSlowConsumerPolicy(64*1024, TcpServer::kDisconnectSlowConsumer);
+  harness.start();
+
+  int fast = connectTo(29988);
+  int slow = connectTo(29988);
+  BOOST_CHECK(waitFor([&] { return harness.established() == 2; }));
+  // fast reads everything as it comes
+  std::atomic<size_t> fastReceived(0);
+  Thread reader([&] {
+    char buf[65536];
+    ssize_t n = 0;
+    while (fastReceived < kMessage * kMessages && (n = ::read(fast, buf, sizeof buf)) > 0)
+    {
+      fastReceived += n;
+    }
+  });
+  reader.start();
+  for (int i = 0; i < kMessages; ++i)
+  {
+    harness.server()->broadcast(BufferSlice(makePayload(kMessage, static_cast<char>(i))));
+    // no backlog for fast
+    BOOST_CHECK(waitFor([&] { return fastReceived == (i + 1) * kMessage; }));
+  }
+  reader.join();
+
+  BOOST_CHECK(closedByPeer(slow));
+  BOOST_CHECK_EQUAL(fastReceived.load(), kMessage * kMessages);
+  BOOST_CHECK_EQUAL(harness.closed(), 1);
+  ::close(slow);
+  ::close(fast);
+  BOOST_CHECK(waitFor([&] { return harness.closed() == 2; }));
+}
@@ -0,0 +1,133 @@
+#include "muduo/net/Timer.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+
+#include <set>
+#include <vector>
+
+#include <stdlib.h>
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+void runInLoopAndWait(EventLoop* loop, const std::function<void()>& func)
+{
+  CountDownLatch latch(1);
+  loop->runInLoop([&] { func(); latch.countDown(); });
+  latch.wait();
+}
+
+int64_t expirationOf(const Timer& timer)
+{
+  return timer.expiration().microSecondsSinceEpoch();
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(testCoalesce)
+{
+  BOOST_CHECK_EQUAL(Timer::coalesce(Timestamp(1234567), 0.001).microSecondsSinceEpoch(), 1235000);
+  BOOST_CHECK_EQUAL(Timer::coalesce(Timestamp(1235000), 0.001).microSecondsSinceEpoch(), 1235000);
+  BOOST_CHECK_EQUAL(Timer::coalesce(Timestamp(1234567), 0.5).microSecondsSinceEpoch(), 1500000);
+  // no slack, exact
+  BOOST_CHECK_EQUAL(Timer::coalesce(Timestamp(1234567), 0.0).microSecondsSinceEpoch(), 1234567);
+}
+
+BOOST_AUTO_TEST_CASE(testRestartDriftFree)
+{
+  Timer timer([] {}, Timestamp(1000000), 0.5, 0.0);
+  BOOST_CHECK_EQUAL(expirationOf(timer), 1000000);
+
+  // fired late, next one is still on schedule
+  timer.restart(Timestamp(1000300));
+  BOOST_CHECK_EQUAL(expirationOf(timer), 1500000);
+
+  // missed 2000000 and 2500000
+  timer.restart(Timestamp(2700000));
+  BOOST_CHECK_EQUAL(expirationOf(timer), 3000000);
+
+  // exactly on the next deadline, skips it
+  timer.restart(Timestamp(3500000));
+  BOOST_CHECK_EQUAL(expirationOf(timer), 4000000);
+
+  Timer once([] {}, Timestamp(1000000), 0.0, 0.0);
+  once.restart(Timestamp(1000300));
+  BOOST_CHECK(!once.expiration().valid());
+}
+
+BOOST_AUTO_TEST_CASE(testRestartWithSlack)
+{
+  Timer timer([] {}, Timestamp(1000000), 0.5, 0.2);
+  BOOST_CHECK_EQUAL(expirationOf(timer), 1000000);
+  timer.restart(Timestamp(1000100));
+  BOOST_CHECK_EQUAL(expirationOf(timer), 1600000);
+  // slack doesn't accumulate, schedules from deadline 1500000
+  timer.restart(Timestamp(1600100));
+  BOOST_CHECK_EQUAL(expirationOf(timer), 2000000);
+}
+
+BOOST_AUTO_TEST_CASE(testRunEveryNoDrift)
+{
+  const double kInterval = 0.01;
+  const size_t kTimes = 50;
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  std::vector<Timestamp> fired;
+  CountDownLatch latch(1);
+  runInLoopAndWait(loop, [&] {
+    loop->setTimerSlack(0.0);
+    loop->runEvery(kInterval, [&] {
+      if (fired.size() <= kTimes)
+      {
+        fired.push_back(Timestamp::now());
+        if (fired.size() > kTimes)
+        {
+          latch.countDown();
+        }
+      }
+    });
+  });
+  latch.wait();
+
+  // late wakeups don't add up
+  double elapsed = timeDifference(fired.back(), fired.front());
+  BOOST_CHECK_CLOSE_FRACTION(elapsed, static_cast<double>(kTimes) * kInterval, 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(testSlackCoalescing)
+{
+  const int kTimers = 1000;
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  std::set<int64_t> iterations;
+  int count = 0;
+  CountDownLatch latch(kTimers);
+  runInLoopAndWait(loop, [&] {
+    loop->setTimerSlack(0.1);
+    srand(42);
+    for (int i = 0; i < kTimers; ++i)
+    {
+      double delay = 0.5 * rand() / RAND_MAX;
+      loop->runAfter(delay, [&] {
+        iterations.insert(loop->iteration());
+        ++count;
+        latch.countDown();
+      });
+    }
+  });
+  latch.wait();
+
+  runInLoopAndWait(loop, [&] {
+    BOOST_CHECK_EQUAL(count, kTimers);
+    // 0.5s of delays rounded up to 0.1s boundaries
+    BOOST_CHECK_LE(iterations.size(), 7U);
+  });
+}